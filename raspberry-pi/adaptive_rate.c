@@ -0,0 +1,85 @@
+// ---------------- adaptive_rate.c ---------------- //
+/*
+ * Adaptive sampling period (see adaptive_rate.h).
+ *
+ * urgency u = max(|slope| / slope_ref, dev / noise_ref, 1 - |distance| / margin_ref)
+ * period    = max_ms / (1 + u * (max_ms / min_ms - 1))
+ * so u = 0 sleeps max_ms and u >= 1 samples at min_ms.
+ */
+#include <math.h>
+#include "adaptive_rate.h"
+
+#define EWMA_ALPHA 0.3f
+
+void rate_init(rate_ctl_t *c, const rate_config_t *cfg, uint32_t now_ms) {
+    c->cfg = cfg;
+    c->primed = false;
+    c->last_v = 0;
+    c->last_ms = now_ms;
+    c->slope = 0;
+    c->mean = 0;
+    c->dev = 0;
+    c->period_ms = cfg->min_ms;
+    c->samples = 0;
+    c->start_ms = now_ms;
+}
+
+uint32_t rate_update(rate_ctl_t *c, uint32_t now_ms, float value, float distance, bool watering) {
+    const rate_config_t *cfg = c->cfg;
+    c->samples++;
+
+    if (!c->primed) {
+        c->primed = true;
+        c->last_v = value;
+        c->last_ms = now_ms;
+        c->mean = value;
+        c->period_ms = cfg->min_ms;
+        return c->period_ms;
+    }
+
+    // Slope from the smoothed value, so sensor jitter at short periods
+    // does not read as movement and keep the rate pinned high
+    float dt = (now_ms - c->last_ms) / 1000.0f;
+    float prev_mean = c->mean;
+    c->mean += EWMA_ALPHA * (value - c->mean);
+    c->dev += EWMA_ALPHA * (fabsf(value - c->mean) - c->dev);
+    if (dt > 0) {
+        float slope = (c->mean - prev_mean) / dt;
+        c->slope += EWMA_ALPHA * (slope - c->slope);
+    }
+    c->last_v = value;
+    c->last_ms = now_ms;
+
+    if (watering) {
+        c->period_ms = cfg->min_ms;
+        return c->period_ms;
+    }
+
+    float u_slope = fabsf(c->slope) / cfg->slope_ref;
+    float u_noise = c->dev / cfg->noise_ref;
+    float u_near = 1.0f - fabsf(distance) / cfg->margin_ref;
+    float u = fmaxf(u_slope, fmaxf(u_noise, u_near));
+
+    float ratio = (float)cfg->max_ms / cfg->min_ms;
+    float period = cfg->max_ms / (1.0f + u * (ratio - 1.0f));
+
+    // Heading for a threshold: check at least four times before crossing it
+    if ((distance > 0 && c->slope < 0) || (distance < 0 && c->slope > 0)) {
+        float cross_ms = fabsf(distance / c->slope) * 1000.0f;
+        if (period > cross_ms / 4) period = cross_ms / 4;
+    }
+
+    if (cfg->near_ms && fabsf(distance) < cfg->margin_ref && period > cfg->near_ms) period = cfg->near_ms;
+    if (period < cfg->min_ms) period = cfg->min_ms;
+    if (period > cfg->max_ms) period = cfg->max_ms;
+    c->period_ms = (uint32_t)period;
+    return c->period_ms;
+}
+
+float rate_samples_per_hour(const rate_ctl_t *c, uint32_t now_ms) {
+    uint32_t elapsed = now_ms - c->start_ms;
+    if (elapsed == 0) return 0;
+    return c->samples * 3600000.0f / elapsed;
+}
+
+// End of adaptive_rate.c
@@ -0,0 +1,48 @@
+// ---------------- adaptive_rate.h ---------------- //
+/*
+ * Adaptive sampling period for one sensor.
+ * After each reading the controller picks the next period between min_ms
+ * and max_ms from how "busy" the signal is:
+ *   - how fast it is moving (EWMA of the derivative vs slope_ref),
+ *   - how noisy it is (EWMA deviation vs noise_ref),
+ *   - how close it is to a decision threshold (vs margin_ref),
+ *   - whether watering is running (always min_ms).
+ * It also never sleeps past a quarter of the predicted time to reach the
+ * nearest threshold, nor past near_ms while within margin_ref of one: a
+ * noise step there can cross it without any slope to predict it. No
+ * hardware calls, so host tools can use it too.
+ */
+#ifndef ADAPTIVE_RATE_H
+#define ADAPTIVE_RATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    uint32_t min_ms, max_ms;
+    float slope_ref;    // units/s that count as "moving fast"
+    float noise_ref;    // deviation that counts as "noisy"
+    float margin_ref;   // distance to a threshold below which the rate ramps up
+    uint32_t near_ms;   // longest period within margin_ref (0: no cap)
+} rate_config_t;
+
+typedef struct {
+    const rate_config_t *cfg;
+    bool primed;
+    float last_v;
+    uint32_t last_ms;
+    float slope;        // EWMA, units/s
+    float mean, dev;    // EWMA mean and absolute deviation
+    uint32_t period_ms;
+    uint32_t samples;
+    uint32_t start_ms;
+} rate_ctl_t;
+
+void rate_init(rate_ctl_t *c, const rate_config_t *cfg, uint32_t now_ms);
+// Feed a reading; returns the period until the next one.
+// `distance` is the signed gap to the nearest threshold (value - threshold).
+uint32_t rate_update(rate_ctl_t *c, uint32_t now_ms, float value, float distance, bool watering);
+// Average samples per hour since rate_init().
+float rate_samples_per_hour(const rate_ctl_t *c, uint32_t now_ms);
+
+#endif // ADAPTIVE_RATE_H
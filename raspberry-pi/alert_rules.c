@@ -0,0 +1,273 @@
+// ---------------- alert_rules.c ---------------- //
+/*
+ * Alert bytecode loader and evaluator (see alert_rules.h).
+ *
+ * Per rule, on each sample of a signal it reads:
+ *   condition false   -> clear (handler told once if it had been raised)
+ *   true < for_s      -> wait
+ *   true >= for_s     -> raise once, unless inside cooldown_s of the last
+ *                        raise or max_fires is used up; it stays raised
+ *                        (no repeat) until the condition clears
+ */
+#include <string.h>
+#include "alert_rules.h"
+#include "checksum.h"
+
+#define ST_HOLDING 0x01   // condition currently true
+#define ST_RAISED  0x02   // handler was told, owes a clear
+#define ST_FIRED   0x04   // raised at least once, cooldown applies
+
+static const alert_blob_hdr_t *hdr(const alert_engine_t *e) {
+    return (const alert_blob_hdr_t *)e->blob;
+}
+
+static const alert_rule_t *rules(const alert_engine_t *e) {
+    return (const alert_rule_t *)(e->blob + sizeof(alert_blob_hdr_t));
+}
+
+// ---------------- Loader ---------------- //
+// Walks one rule's code the way the evaluator will and rejects anything
+// that could read past the code, index a bad signal or misuse the stack.
+static bool check_code(const uint8_t *pc, const uint8_t *end, uint8_t signals) {
+    int depth = 0;
+    while (pc < end) {
+        uint8_t op = *pc++;
+        switch (op) {
+        case OP_SIG:
+        case OP_RATE:
+            if (pc + 1 > end || *pc >= ALERT_SIGNALS || !(signals & (1u << *pc))) return false;
+            pc += 1;
+            depth++;
+            break;
+        case OP_CONST16:
+            if (pc + 2 > end) return false;
+            pc += 2;
+            depth++;
+            break;
+        case OP_CONST32:
+            if (pc + 4 > end) return false;
+            pc += 4;
+            depth++;
+            break;
+        case OP_TEST:
+            if (pc + 4 > end || pc[0] >= ALERT_SIGNALS || !(signals & (1u << pc[0]))) return false;
+            if (pc[1] < OP_GT || pc[1] > OP_NE) return false;
+            pc += 4;
+            depth++;
+            break;
+        case OP_GT: case OP_GE: case OP_LT: case OP_LE: case OP_EQ: case OP_NE:
+        case OP_AND: case OP_OR:
+            if (depth < 2) return false;
+            depth--;
+            break;
+        case OP_NOT:
+            if (depth < 1) return false;
+            break;
+        default:
+            return false;
+        }
+        if (depth > ALERT_STACK) return false;
+    }
+    return depth == 1;
+}
+
+bool alert_load(alert_engine_t *e, const uint8_t *blob, uint32_t len) {
+    e->blob = NULL;
+    memset(e->state, 0, sizeof(e->state));
+    if (!blob || len < sizeof(alert_blob_hdr_t) || ((uintptr_t)blob & 3)) return false;
+
+    const alert_blob_hdr_t *h = (const alert_blob_hdr_t *)blob;
+    if (h->magic != ALERT_MAGIC || h->version != ALERT_VERSION) return false;
+    if (h->total_len < sizeof(*h) || h->total_len > len || h->total_len > ALERT_BLOB_MAX) return false;
+    if (h->rule_count > ALERT_MAX_RULES) return false;
+    if (crc32(blob + 16, h->total_len - 16) != h->crc) return false;
+
+    uint32_t rules_end = sizeof(alert_blob_hdr_t) + h->rule_count * sizeof(alert_rule_t);
+    if (rules_end > h->total_len || h->index_off < rules_end || (h->index_off & 1)) return false;
+    for (int s = 0; s < ALERT_SIGNALS; s++) {
+        if (h->sig_start[s] > h->sig_start[s + 1]) return false;
+    }
+    if (h->sig_start[0] != 0 || h->index_off + 2u * h->sig_start[ALERT_SIGNALS] > h->total_len) return false;
+    const uint16_t *index = (const uint16_t *)(blob + h->index_off);
+    for (uint32_t i = 0; i < h->sig_start[ALERT_SIGNALS]; i++) {
+        if (index[i] >= h->rule_count) return false;
+    }
+
+    const alert_rule_t *r = (const alert_rule_t *)(blob + sizeof(alert_blob_hdr_t));
+    for (uint32_t i = 0; i < h->rule_count; i++) {
+        if (r[i].code_off + r[i].code_len > h->total_len || r[i].name_off >= h->total_len) return false;
+        if (!memchr(blob + r[i].name_off, 0, h->total_len - r[i].name_off)) return false;
+        if (!check_code(blob + r[i].code_off, blob + r[i].code_off + r[i].code_len, r[i].signals)) return false;
+    }
+
+    e->blob = blob;
+    return true;
+}
+
+uint16_t alert_rule_count(const alert_engine_t *e) {
+    return e->blob ? hdr(e)->rule_count : 0;
+}
+
+const char *alert_rule_name(const alert_engine_t *e, uint16_t i) {
+    return (const char *)e->blob + rules(e)[i].name_off;
+}
+
+bool alert_rule_raised(const alert_engine_t *e, uint16_t i) {
+    return (e->state[i].flags & ST_RAISED) != 0;
+}
+
+const char *alert_raised_action(const alert_engine_t *e, uint8_t actions) {
+    for (uint16_t i = 0; i < alert_rule_count(e); i++) {
+        if ((rules(e)[i].actions & actions) && alert_rule_raised(e, i)) return alert_rule_name(e, i);
+    }
+    return NULL;
+}
+
+// ---------------- Evaluator ---------------- //
+static inline int32_t compare(uint8_t op, int32_t a, int32_t b) {
+    switch (op) {
+    case OP_GT: return a > b;
+    case OP_GE: return a >= b;
+    case OP_LT: return a < b;
+    case OP_LE: return a <= b;
+    case OP_EQ: return a == b;
+    default:    return a != b;
+    }
+}
+
+static bool run(const alert_engine_t *e, const uint8_t *pc, const uint8_t *end) {
+    int32_t st[ALERT_STACK];
+    int sp = 0;
+    while (pc < end) {
+        uint8_t op = *pc++;
+        switch (op) {
+        case OP_SIG:
+            st[sp++] = e->value[*pc++];
+            break;
+        case OP_RATE:
+            st[sp++] = e->rate[*pc++];
+            break;
+        case OP_CONST16:
+            st[sp++] = (int16_t)(pc[0] | pc[1] << 8);
+            pc += 2;
+            break;
+        case OP_CONST32:
+            st[sp++] = (int32_t)((uint32_t)pc[0] | (uint32_t)pc[1] << 8 | (uint32_t)pc[2] << 16 | (uint32_t)pc[3] << 24);
+            pc += 4;
+            break;
+        case OP_TEST:
+            st[sp++] = compare(pc[1], e->value[pc[0]], (int16_t)(pc[2] | pc[3] << 8));
+            pc += 4;
+            break;
+        case OP_AND:
+            sp--;
+            st[sp - 1] = st[sp - 1] && st[sp];
+            break;
+        case OP_OR:
+            sp--;
+            st[sp - 1] = st[sp - 1] || st[sp];
+            break;
+        case OP_NOT:
+            st[sp - 1] = !st[sp - 1];
+            break;
+        default:    // comparisons
+            sp--;
+            st[sp - 1] = compare(op, st[sp - 1], st[sp]);
+            break;
+        }
+    }
+    return st[0] != 0;
+}
+
+uint32_t alert_sample(alert_engine_t *e, uint8_t sig, int32_t value_x10, uint32_t now_ms, alert_action_fn fn) {
+    if (sig >= ALERT_SIGNALS) return 0;
+
+    // Per-minute rate against the previous sample of this signal
+    if (e->seen & (1u << sig)) {
+        uint32_t dt = now_ms - e->seen_ms[sig];
+        if (dt > 0) e->rate[sig] = (int32_t)((int64_t)(value_x10 - e->value[sig]) * 60000 / dt);
+    }
+    e->value[sig] = value_x10;
+    e->seen_ms[sig] = now_ms;
+    e->seen |= 1u << sig;
+    if (!e->blob) return 0;
+
+    const alert_blob_hdr_t *h = hdr(e);
+    const alert_rule_t *r = rules(e);
+    const uint16_t *index = (const uint16_t *)(e->blob + h->index_off);
+    uint32_t evaluated = 0;
+
+    for (uint32_t k = h->sig_start[sig]; k < h->sig_start[sig + 1]; k++) {
+        uint16_t i = index[k];
+        const alert_rule_t *rule = &r[i];
+        if ((rule->signals & e->seen) != rule->signals) continue;   // an input has no value yet
+        alert_state_t *st = &e->state[i];
+        evaluated++;
+
+        if (!run(e, e->blob + rule->code_off, e->blob + rule->code_off + rule->code_len)) {
+            if ((st->flags & ST_RAISED) && fn) fn((const char *)e->blob + rule->name_off, rule->actions, false);
+            st->flags &= ST_FIRED;
+            continue;
+        }
+        if (!(st->flags & ST_HOLDING)) {
+            st->flags |= ST_HOLDING;
+            st->since_ms = now_ms;
+        }
+        if (st->flags & ST_RAISED) continue;                        // handler already told
+        if (now_ms - st->since_ms < rule->for_s * 1000u) continue;
+        if ((st->flags & ST_FIRED) && now_ms - st->last_ms < rule->cooldown_s * 1000u) continue;
+        if (rule->max_fires && st->fires >= rule->max_fires) continue;
+
+        if (st->fires < 255) st->fires++;
+        st->last_ms = now_ms;
+        st->flags |= ST_RAISED | ST_FIRED;
+        if (fn) fn((const char *)e->blob + rule->name_off, rule->actions, true);
+    }
+    return evaluated;
+}
+
+// ---------------- Flash copy ---------------- //
+#if PICO_ON_DEVICE
+#include "pico/stdlib.h"
+#include "pico/flash.h"
+#include "hardware/flash.h"
+#include "flash_layout.h"
+#include "pump_drive.h"
+
+_Static_assert(ALERT_BLOB_MAX <= RULES_FLASH_BYTES, "rule blob does not fit its flash region");
+
+typedef struct {
+    uint32_t offset;
+    const uint8_t *page;
+} rules_op_t;
+
+static void rules_flash_op(void *param) {
+    const rules_op_t *op = param;
+    pump_drive_flash_hold(true);
+    if (op->offset % FLASH_SECTOR_SIZE == 0) flash_range_erase(op->offset, FLASH_SECTOR_SIZE);
+    if (op->page) flash_range_program(op->offset, op->page, FLASH_PAGE_SIZE);
+    pump_drive_flash_hold(false);
+}
+
+const uint8_t *alert_flash_blob(void) {
+    const alert_blob_hdr_t *h = (const alert_blob_hdr_t *)(XIP_BASE + RULES_FLASH_OFFSET);
+    if (h->magic != ALERT_MAGIC || h->total_len < sizeof(*h) || h->total_len > ALERT_BLOB_MAX) return NULL;
+    if (crc32((const uint8_t *)h + 16, h->total_len - 16) != h->crc) return NULL;
+    return (const uint8_t *)h;
+}
+
+void alert_flash_erase(void) {
+    rules_op_t op = {.offset = RULES_FLASH_OFFSET, .page = NULL};
+    flash_safe_execute(rules_flash_op, &op, UINT32_MAX);
+}
+
+// Pages must arrive in order from offset 0; a sector is erased when its
+// first page is written.
+void alert_flash_write(uint32_t offset, const uint8_t *page) {
+    if (offset + FLASH_PAGE_SIZE > RULES_FLASH_BYTES) return;
+    rules_op_t op = {.offset = RULES_FLASH_OFFSET + offset, .page = page};
+    flash_safe_execute(rules_flash_op, &op, UINT32_MAX);
+}
+#endif
+
+// End of alert_rules.c
@@ -0,0 +1,120 @@
+// ---------------- alert_rules.h ---------------- //
+/*
+ * Alert rules as compact bytecode.
+ * Rules are written in config/irrigation-settings.json ("alerts"), compiled
+ * on the host by tools/alert_compiler.c and either built in
+ * (alert_rules_default.h) or uploaded over the CLI into flash.
+ *
+ * Each sample updates one signal; only the rules that read that signal are
+ * run, through a per-signal index the compiler stores in the blob. Code is
+ * checked once at load, so the evaluator itself does no bounds checks.
+ * No hardware calls outside the PICO_ON_DEVICE flash section, so the host
+ * compiler links this file too.
+ */
+#ifndef ALERT_RULES_H
+#define ALERT_RULES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- Signals (values are fixed point, x10) ---
+enum {
+    SIG_SOIL = 0,       // raw ADC
+    SIG_TEMP,           // C
+    SIG_HUM,            // %
+    SIG_INTRUSION,      // proximity sensor, 0/1
+    SIG_CYCLES,         // irrigation cycles since the last maintenance
+    SIG_WATERING,       // a zone is being watered, 0/1
+    ALERT_SIGNALS
+};
+
+// --- Actions (bitmask), carried out by the firmware's handler ---
+#define ALERT_LOG          0x01   // console message on raise / clear
+#define ALERT_LED          0x02   // LED_ALERT while raised
+#define ALERT_STOP         0x04   // stop watering
+#define ALERT_LCD          0x08   // show the rule name
+#define ALERT_RESET_CYCLES 0x10   // maintenance done: irrigation_count = 0
+
+// --- Opcodes (stack machine, int32 operands) ---
+enum {
+    OP_SIG = 1,     // s          push signal s
+    OP_RATE,        // s          push change of s per minute
+    OP_CONST16,     // k16        push k
+    OP_CONST32,     // k32        push k
+    OP_TEST,        // s cmp k16  push (signal s <cmp> k), the common case in one op
+    OP_GT, OP_GE, OP_LT, OP_LE, OP_EQ, OP_NE,
+    OP_AND, OP_OR, OP_NOT,
+};
+#define ALERT_STACK 8
+
+// --- Blob (little endian, 4-byte aligned) ---
+//   header | rules[rule_count] | index (u16 rule ids) | code | names
+#define ALERT_MAGIC    0x31524c41u   // "ALR1"
+#define ALERT_VERSION  1
+#ifndef ALERT_MAX_RULES
+#define ALERT_MAX_RULES 256
+#endif
+#define ALERT_BLOB_MAX (16 * 1024)
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t rule_count;
+    uint32_t total_len;
+    uint32_t crc;                       // CRC-32 of everything after this field
+    uint16_t index_off;                 // byte offset of the index
+    uint16_t sig_start[ALERT_SIGNALS + 1];  // index entries for signal s: [sig_start[s], sig_start[s+1])
+} alert_blob_hdr_t;
+
+typedef struct {
+    uint16_t code_off;      // byte offset from the blob start
+    uint16_t name_off;
+    uint16_t for_s;         // condition must hold this long
+    uint16_t cooldown_s;    // minimum gap between two raises
+    uint8_t max_fires;      // 0 = unlimited
+    uint8_t actions;
+    uint8_t signals;        // bitmask of signals the code reads
+    uint8_t code_len;
+} alert_rule_t;
+
+_Static_assert(sizeof(alert_blob_hdr_t) == 32, "blob header layout");
+_Static_assert(sizeof(alert_rule_t) == 12, "rule entry layout");
+
+// --- Evaluator ---
+typedef struct {
+    uint32_t since_ms;      // condition true since
+    uint32_t last_ms;       // last raise
+    uint8_t fires;
+    uint8_t flags;
+} alert_state_t;
+
+typedef struct {
+    const uint8_t *blob;    // NULL: no rules
+    int32_t value[ALERT_SIGNALS];
+    int32_t rate[ALERT_SIGNALS];
+    uint32_t seen_ms[ALERT_SIGNALS];
+    uint8_t seen;           // bitmask of signals with a value
+    alert_state_t state[ALERT_MAX_RULES];
+} alert_engine_t;
+
+// raised = true when a rule fires, false when its condition clears again
+typedef void (*alert_action_fn)(const char *name, uint8_t actions, bool raised);
+
+// Checks and attaches a blob (kept by reference); false leaves no rules.
+bool alert_load(alert_engine_t *e, const uint8_t *blob, uint32_t len);
+// Feeds one sample; returns how many rules were evaluated.
+uint32_t alert_sample(alert_engine_t *e, uint8_t sig, int32_t value_x10, uint32_t now_ms, alert_action_fn fn);
+uint16_t alert_rule_count(const alert_engine_t *e);
+const char *alert_rule_name(const alert_engine_t *e, uint16_t i);
+bool alert_rule_raised(const alert_engine_t *e, uint16_t i);
+// Name of the first rule raised right now with any of `actions`, or NULL.
+const char *alert_raised_action(const alert_engine_t *e, uint8_t actions);
+
+#if PICO_ON_DEVICE
+// --- Flash copy (RULES_FLASH_OFFSET, see flash_layout.h) ---
+const uint8_t *alert_flash_blob(void);   // NULL if the flash copy is blank or bad
+void alert_flash_erase(void);
+void alert_flash_write(uint32_t offset, const uint8_t *page);   // one FLASH_PAGE_SIZE page
+#endif
+
+#endif // ALERT_RULES_H
@@ -0,0 +1,30 @@
+// ---------------- alert_rules_default.h ---------------- //
+// Built-in alert rules, generated from config/irrigation-settings.json by tools/alert_compiler -c.
+// 5 rules, 208 bytes. Do not edit; change the settings file and regenerate.
+#ifndef ALERT_RULES_DEFAULT_H
+#define ALERT_RULES_DEFAULT_H
+
+#include <stdint.h>
+
+static const uint8_t alert_rules_default[208] __attribute__((aligned(4))) = {
+    0x41, 0x4c, 0x52, 0x31, 0x01, 0x00, 0x05, 0x00, 0xd0, 0x00, 0x00, 0x00,
+    0x9c, 0x7d, 0xf4, 0x52, 0x5c, 0x00, 0x00, 0x00, 0x02, 0x00, 0x03, 0x00,
+    0x04, 0x00, 0x05, 0x00, 0x06, 0x00, 0x08, 0x00, 0x6c, 0x00, 0x90, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x0f, 0x08, 0x02, 0x6e, 0x00, 0x9a, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x19, 0x10, 0x05, 0x73, 0x00, 0xa7, 0x00,
+    0x00, 0x00, 0x3c, 0x00, 0x03, 0x03, 0x06, 0x0b, 0x7e, 0x00, 0xb5, 0x00,
+    0x08, 0x07, 0x10, 0x0e, 0x00, 0x03, 0x21, 0x09, 0x87, 0x00, 0xc2, 0x00,
+    0x14, 0x00, 0x58, 0x02, 0x00, 0x01, 0x21, 0x09, 0x03, 0x00, 0x04, 0x00,
+    0x02, 0x00, 0x02, 0x00, 0x00, 0x00, 0x01, 0x00, 0x03, 0x00, 0x04, 0x00,
+    0x01, 0x03, 0x05, 0x04, 0x07, 0x2c, 0x01, 0x05, 0x01, 0x06, 0x2c, 0x01,
+    0x05, 0x02, 0x06, 0xbc, 0x02, 0x0d, 0x05, 0x00, 0x08, 0x40, 0x1f, 0x01,
+    0x05, 0x0e, 0x0c, 0x01, 0x05, 0x02, 0x00, 0x03, 0x00, 0x00, 0x09, 0x0c,
+    0x49, 0x4e, 0x54, 0x52, 0x55, 0x53, 0x49, 0x4f, 0x4e, 0x00, 0x4d, 0x61,
+    0x69, 0x6e, 0x74, 0x65, 0x6e, 0x61, 0x6e, 0x63, 0x65, 0x21, 0x00, 0x54,
+    0x65, 0x6d, 0x70, 0x2f, 0x48, 0x75, 0x6d, 0x69, 0x64, 0x69, 0x74, 0x79,
+    0x00, 0x53, 0x6f, 0x69, 0x6c, 0x20, 0x74, 0x6f, 0x6f, 0x20, 0x64, 0x72,
+    0x79, 0x00, 0x4e, 0x6f, 0x20, 0x73, 0x6f, 0x69, 0x6c, 0x20, 0x72, 0x69,
+    0x73, 0x65, 0x00, 0x00,
+};
+
+#endif // ALERT_RULES_DEFAULT_H
@@ -0,0 +1,125 @@
+// ---------------- ab_boot.c ---------------- //
+/*
+ * A/B bootloader for the irrigation firmware. Built as its own image at
+ * the start of flash (after boot2, within BOOTLOADER_BYTES), linked with
+ * ../boot_state.c and ../checksum.c; no FreeRTOS, no stdio.
+ *
+ * On every reset:
+ *   SWAP_PENDING    swap slot A <-> B (new image into A), then TESTING
+ *   TESTING         count the boot; past BOOT_MAX_ATTEMPTS swap back
+ *                   (REVERT_PENDING -> CONFIRMED), else arm the watchdog
+ *   REVERT_PENDING  finish swapping the old image back
+ * then jump to the image in slot A.
+ *
+ * The swap goes sector by sector through SWAP_SCRATCH_OFFSET, with each
+ * step recorded in the boot state sector, so a power cut mid-swap resumes
+ * on the next reset. Sectors equal in both slots are skipped. Slot A is always the one that runs, so the firmware
+ * is linked for one address only.
+ */
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "hardware/watchdog.h"
+#include "hardware/structs/scb.h"
+#include "boot_state.h"
+
+static uint8_t sector_buf[FLASH_SECTOR_SIZE];
+
+// No other core or RTOS is running here: just keep interrupts off
+void boot_flash_write(uint32_t offset, const uint8_t *data, size_t len, bool erase) {
+    uint32_t irq = save_and_disable_interrupts();
+    if (erase) flash_range_erase(offset, FLASH_SECTOR_SIZE);
+    if (data) flash_range_program(offset, data, len);
+    restore_interrupts(irq);
+}
+
+static void copy_sector(uint32_t from, uint32_t to) {
+    memcpy(sector_buf, (const void *)(XIP_BASE + from), FLASH_SECTOR_SIZE);
+    boot_flash_write(to, sector_buf, FLASH_SECTOR_SIZE, true);
+}
+
+// Every step only reads a sector that no earlier unfinished step has
+// overwritten, so re-running a step after a reset is harmless.
+static void swap_slots(uint16_t sectors) {
+    if (sectors > SLOT_SECTORS) sectors = SLOT_SECTORS;
+    for (uint32_t i = 0; i < sectors; i++) {
+        uint32_t a = SLOT_A_OFFSET + i * FLASH_SECTOR_SIZE;
+        uint32_t b = SLOT_B_OFFSET + i * FLASH_SECTOR_SIZE;
+        uint32_t step = i * BOOT_SWAP_STEPS;
+        // Untouched and identical in both slots: nothing to exchange. Small
+        // deltas leave most sectors like this, which spares the scratch sector.
+        if (!boot_progress_done(step) &&
+            memcmp((const void *)(XIP_BASE + a), (const void *)(XIP_BASE + b), FLASH_SECTOR_SIZE) == 0) {
+            continue;
+        }
+        if (!boot_progress_done(step)) {
+            copy_sector(a, SWAP_SCRATCH_OFFSET);
+            boot_progress_mark(step);
+        }
+        if (!boot_progress_done(step + 1)) {
+            copy_sector(b, a);
+            boot_progress_mark(step + 1);
+        }
+        if (!boot_progress_done(step + 2)) {
+            copy_sector(SWAP_SCRATCH_OFFSET, b);
+            boot_progress_mark(step + 2);
+        }
+    }
+}
+
+static void __attribute__((noreturn)) start_slot_a(void) {
+    const uint32_t *vectors = (const uint32_t *)(XIP_BASE + SLOT_A_OFFSET);
+    scb_hw->vtor = (uintptr_t)vectors;
+    __asm volatile(
+        "msr msp, %0\n"
+        "bx %1\n"
+        :: "r"(vectors[0]), "r"(vectors[1]));
+    __builtin_unreachable();
+}
+
+int main(void) {
+    // A watchdog left running by a failed trial must not cut a swap short
+    watchdog_disable();
+
+    boot_state_t st;
+    if (boot_state_read(&st)) {
+        switch (st.state) {
+        case BOOT_SWAP_PENDING:
+            swap_slots(st.swap_sectors);
+            st.state = BOOT_TESTING;
+            st.attempts = 0;
+            boot_state_write(&st);
+            break;
+        case BOOT_REVERT_PENDING:
+            swap_slots(st.swap_sectors);
+            st.state = BOOT_CONFIRMED;
+            st.image_size = 0;   // old image; its size is not tracked
+            memset(st.image_sha, 0, sizeof(st.image_sha));
+            boot_state_write(&st);
+            break;
+        default:
+            break;
+        }
+
+        if (st.state == BOOT_TESTING) {
+            if (st.attempts >= BOOT_MAX_ATTEMPTS) {
+                st.state = BOOT_REVERT_PENDING;
+                boot_state_write(&st);
+                swap_slots(st.swap_sectors);
+                st.state = BOOT_CONFIRMED;
+                st.image_size = 0;
+                memset(st.image_sha, 0, sizeof(st.image_sha));
+                boot_state_write(&st);
+            } else {
+                st.attempts++;
+                boot_state_write(&st);
+                // A hang before fw_update_poll() runs counts as a failed boot
+                watchdog_enable(BOOT_WATCHDOG_MS, true);
+            }
+        }
+    }
+    start_slot_a();
+}
+
+// End of ab_boot.c
@@ -0,0 +1,62 @@
+// ---------------- boot_state.c ---------------- //
+/*
+ * Boot state record and swap progress in flash (see boot_state.h).
+ */
+#include <string.h>
+#include "pico/stdlib.h"
+#include "boot_state.h"
+#include "checksum.h"
+
+static uint32_t current_sector = BOOT_STATE_OFFSET;   // sector holding the live record
+
+static const boot_state_t *record_at(uint32_t offset) {
+    return (const boot_state_t *)(XIP_BASE + offset);
+}
+
+static bool record_valid(const boot_state_t *st) {
+    return st->magic == BOOT_STATE_MAGIC && st->crc == crc32((const uint8_t *)st, offsetof(boot_state_t, crc));
+}
+
+bool boot_state_read(boot_state_t *st) {
+    const boot_state_t *a = record_at(BOOT_STATE_OFFSET);
+    const boot_state_t *b = record_at(BOOT_STATE_OFFSET + FLASH_SECTOR_SIZE);
+    bool va = record_valid(a), vb = record_valid(b);
+    if (!va && !vb) return false;
+
+    // Newer of the two; seq comparison survives wrap-around
+    bool use_b = vb && (!va || (int32_t)(b->seq - a->seq) > 0);
+    current_sector = BOOT_STATE_OFFSET + (use_b ? FLASH_SECTOR_SIZE : 0);
+    memcpy(st, use_b ? b : a, sizeof(*st));
+    return true;
+}
+
+void boot_state_write(boot_state_t *st) {
+    static uint8_t page[FLASH_PAGE_SIZE];
+    boot_state_t prev;
+    uint32_t seq = boot_state_read(&prev) ? prev.seq + 1 : 1;
+    uint32_t next = current_sector == BOOT_STATE_OFFSET ? BOOT_STATE_OFFSET + FLASH_SECTOR_SIZE : BOOT_STATE_OFFSET;
+
+    st->magic = BOOT_STATE_MAGIC;
+    st->seq = seq;
+    st->crc = crc32((const uint8_t *)st, offsetof(boot_state_t, crc));
+    memset(page, 0xFF, sizeof(page));
+    memcpy(page, st, sizeof(*st));
+    boot_flash_write(next, page, sizeof(page), true);   // erasing also clears the progress bytes
+    current_sector = next;
+}
+
+bool boot_progress_done(uint32_t step) {
+    return *(const uint8_t *)(XIP_BASE + current_sector + BOOT_PROGRESS_OFFSET + step) == 0x00;
+}
+
+// Programs one page with a single 0x00 byte; 0xFF elsewhere leaves the
+// other progress bytes as they are.
+void boot_progress_mark(uint32_t step) {
+    static uint8_t page[FLASH_PAGE_SIZE];
+    uint32_t at = BOOT_PROGRESS_OFFSET + step;
+    memset(page, 0xFF, sizeof(page));
+    page[at % FLASH_PAGE_SIZE] = 0x00;
+    boot_flash_write(current_sector + at - at % FLASH_PAGE_SIZE, page, sizeof(page), false);
+}
+
+// End of boot_state.c
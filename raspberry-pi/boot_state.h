@@ -0,0 +1,57 @@
+// ---------------- boot_state.h ---------------- //
+/*
+ * A/B boot state, shared by the bootloader (boot/ab_boot.c) and the
+ * firmware (fw_update.c).
+ *
+ * Two flash sectors at BOOT_STATE_OFFSET take turns holding the record;
+ * the valid one with the higher seq wins, so a write torn by a power cut
+ * leaves the previous record in charge. After the record page, the sector
+ * keeps one progress byte per swap step, programmed 0xFF -> 0x00 as the
+ * step completes, so an interrupted A/B swap resumes where it stopped.
+ *
+ *   CONFIRMED      slot A is good
+ *   SWAP_PENDING   slot B holds a verified update; bootloader swaps A <-> B
+ *   TESTING        new image in A, not yet reported healthy; the bootloader
+ *                  counts boots and arms the watchdog
+ *   REVERT_PENDING too many failed boots; bootloader swaps the old image back
+ */
+#ifndef BOOT_STATE_H
+#define BOOT_STATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "flash_layout.h"
+
+#define BOOT_STATE_MAGIC   0x544f4f42u   // "BOOT"
+#define BOOT_MAX_ATTEMPTS  3             // boots a TESTING image gets to confirm
+#define BOOT_WATCHDOG_MS   8000          // armed by the bootloader while TESTING
+
+enum { BOOT_CONFIRMED = 0, BOOT_SWAP_PENDING, BOOT_TESTING, BOOT_REVERT_PENDING };
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint8_t state;
+    uint8_t attempts;           // boots of a TESTING image so far
+    uint16_t swap_sectors;      // sectors exchanged between A and B
+    uint32_t image_size;        // image in slot A once the swap is done
+    uint8_t image_sha[32];
+    uint32_t crc;               // CRC-32 of the fields above
+} boot_state_t;
+
+#define BOOT_SWAP_STEPS      3   // A -> scratch, B -> A, scratch -> B
+#define BOOT_PROGRESS_OFFSET FLASH_PAGE_SIZE
+_Static_assert(BOOT_PROGRESS_OFFSET + BOOT_SWAP_STEPS * SLOT_SECTORS <= FLASH_SECTOR_SIZE,
+               "swap progress does not fit the boot state sector");
+
+// Provided by the caller: erase the sector at `offset` if `erase`, then
+// program `len` bytes (a multiple of FLASH_PAGE_SIZE) if `data`.
+void boot_flash_write(uint32_t offset, const uint8_t *data, size_t len, bool erase);
+
+bool boot_state_read(boot_state_t *st);          // false: no record (factory image, treat as confirmed)
+void boot_state_write(boot_state_t *st);         // bumps seq; clears swap progress
+bool boot_progress_done(uint32_t step);
+void boot_progress_mark(uint32_t step);
+
+#endif // BOOT_STATE_H
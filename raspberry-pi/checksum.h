@@ -0,0 +1,28 @@
+// ---------------- checksum.h ---------------- //
+/*
+ * CRC-32 (IEEE, as zlib) for framing and flash records, and SHA-256 for
+ * firmware images. Plain C, no hardware, shared with the host tools.
+ */
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t len);   // start with crc = 0
+static inline uint32_t crc32(const uint8_t *data, size_t len) {
+    return crc32_update(0, data, len);
+}
+
+typedef struct {
+    uint32_t h[8];
+    uint64_t bytes;
+    uint8_t block[64];
+    uint8_t used;
+} sha256_t;
+
+void sha256_init(sha256_t *s);
+void sha256_update(sha256_t *s, const uint8_t *data, size_t len);
+void sha256_final(sha256_t *s, uint8_t out[32]);
+
+#endif // CHECKSUM_H
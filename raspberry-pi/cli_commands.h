@@ -0,0 +1,37 @@
+// ---------------- cli_commands.h ---------------- //
+/*
+ * Console commands for cli_task, as one X-macro table so the firmware
+ * and the host benchmarks (tools/host_bench.c) parse lines the same way.
+ *
+ *   CLI_COMMANDS(X)   X(id, "text typed at the prompt")
+ */
+#ifndef CLI_COMMANDS_H
+#define CLI_COMMANDS_H
+
+#include <string.h>
+
+#define CLI_COMMANDS(X) \
+    X(START,       "start") \
+    X(STOP,        "stop") \
+    X(STATUS,      "status") \
+    X(HISTORY,     "history") \
+    X(TELEMETRY,   "telemetry") \
+    X(MEMMAP,      "memmap") \
+    X(ALERTS,      "alerts") \
+    X(ALERTS_LOAD, "alerts load") \
+    X(PUMP,        "pump") \
+    X(PUMP_RESET,  "pump reset") \
+    X(FIRMWARE,    "firmware") \
+    X(UPDATE,      "update")
+
+#define CLI_ID(id, text) CLI_##id,
+enum { CLI_NONE, CLI_COMMANDS(CLI_ID) CLI_COUNT };
+
+// Command id for one input line; CLI_NONE for blank or unknown lines.
+#define CLI_MATCH(id, text) if (strcmp(line, text) == 0) return CLI_##id;
+static inline int cli_parse(const char *line) {
+    CLI_COMMANDS(CLI_MATCH)
+    return CLI_NONE;
+}
+
+#endif // CLI_COMMANDS_H
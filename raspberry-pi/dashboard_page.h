@@ -0,0 +1,78 @@
+// ---------------- dashboard_page.h ---------------- //
+/*
+ * web/dashboard.html, gzip-compressed, kept in flash and sent as-is with
+ * Content-Encoding: gzip. Regenerate after editing the page:
+ *   gzip -9 -n -c web/dashboard.html | xxd -i
+ * (1969 bytes raw, 981 bytes compressed)
+ */
+#ifndef DASHBOARD_PAGE_H
+#define DASHBOARD_PAGE_H
+
+#include <stdint.h>
+
+static const uint8_t dashboard_page_gz[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x8d, 0x55, 0x6d, 0x6f, 0xdb, 0x36,
+    0x10, 0xfe, 0xee, 0x5f, 0xc1, 0x29, 0x5d, 0x29, 0xc1, 0xb6, 0x6c, 0xd9, 0x59, 0x9b, 0x4a, 0xb6,
+    0x0b, 0x2c, 0xcd, 0xb0, 0x0e, 0xc3, 0x52, 0xc0, 0x01, 0x86, 0x0d, 0xfb, 0x42, 0x8b, 0x27, 0x89,
+    0x88, 0x44, 0x0a, 0x24, 0xe5, 0x97, 0x1a, 0xfe, 0xef, 0x3b, 0xca, 0x8a, 0x1b, 0xc7, 0x1d, 0xb2,
+    0x0f, 0x36, 0xc9, 0xbb, 0x7b, 0x9e, 0x3b, 0xde, 0x0b, 0x35, 0xfb, 0xe1, 0xd3, 0xfd, 0xed, 0xc3,
+    0x5f, 0x5f, 0xee, 0x48, 0x61, 0xab, 0x72, 0xd1, 0x9b, 0x3d, 0x2d, 0xc0, 0x38, 0x2e, 0x15, 0x58,
+    0x46, 0xd2, 0x82, 0x69, 0x03, 0x76, 0xee, 0x35, 0x36, 0x1b, 0xde, 0x78, 0x4f, 0x62, 0xc9, 0x2a,
+    0x98, 0x7b, 0x6b, 0x01, 0x9b, 0x5a, 0x69, 0xeb, 0x91, 0x54, 0x49, 0x0b, 0x12, 0xcd, 0x36, 0x82,
+    0xdb, 0x62, 0xce, 0x61, 0x2d, 0x52, 0x18, 0xb6, 0x87, 0x81, 0x90, 0xc2, 0x0a, 0x56, 0x0e, 0x4d,
+    0xca, 0x4a, 0x98, 0x47, 0x8e, 0xc3, 0x0a, 0x5b, 0xc2, 0x62, 0x59, 0x31, 0x6d, 0xc9, 0x67, 0xad,
+    0x45, 0xce, 0xac, 0x50, 0x72, 0x36, 0x3a, 0xca, 0x7b, 0x33, 0x63, 0x77, 0x6e, 0x5d, 0x29, 0xbe,
+    0xdb, 0x67, 0x48, 0x3d, 0xcc, 0x58, 0x25, 0xca, 0x5d, 0x6c, 0x98, 0x34, 0x43, 0x03, 0x5a, 0x64,
+    0x09, 0x62, 0x73, 0x21, 0xe3, 0x08, 0xaa, 0x64, 0xc5, 0xd2, 0xc7, 0x5c, 0xab, 0x46, 0xf2, 0xf8,
+    0x2a, 0xbb, 0xce, 0x6e, 0xb2, 0x49, 0x92, 0xaa, 0x52, 0xe9, 0xf8, 0x6a, 0x32, 0x99, 0x1e, 0x7a,
+    0x45, 0x74, 0xe4, 0x30, 0xe2, 0x2b, 0xc4, 0x51, 0x38, 0x85, 0xea, 0xd0, 0x0b, 0x73, 0x2d, 0xf8,
+    0x9e, 0x0b, 0x53, 0x97, 0x6c, 0x17, 0xbb, 0x43, 0xe2, 0xfe, 0x86, 0x16, 0x2a, 0x94, 0x58, 0x18,
+    0x22, 0x41, 0x53, 0x49, 0x13, 0x6b, 0xa8, 0x81, 0x59, 0x9f, 0x35, 0x56, 0x0d, 0x33, 0x61, 0x07,
+    0x95, 0x90, 0x15, 0xdb, 0xfa, 0x1f, 0xa0, 0x1a, 0x44, 0x99, 0x0e, 0x82, 0x24, 0x67, 0x75, 0x1c,
+    0xbe, 0x6b, 0x39, 0x53, 0xa6, 0xf9, 0xfe, 0x2c, 0x98, 0x2c, 0x4b, 0x56, 0x4a, 0x73, 0xd0, 0x43,
+    0xcd, 0xb8, 0x68, 0x4c, 0xfc, 0xae, 0xde, 0x26, 0x35, 0xe3, 0x5c, 0xc8, 0xbc, 0x45, 0xa1, 0x7a,
+    0x3b, 0x34, 0x05, 0xe3, 0x6a, 0x13, 0x8f, 0x49, 0x54, 0x6f, 0xc9, 0x14, 0x7f, 0x57, 0xe3, 0xf1,
+    0x78, 0xd2, 0x11, 0x92, 0xd5, 0x29, 0xcc, 0x55, 0xa9, 0xd2, 0xc7, 0xe4, 0xf9, 0x5d, 0x5a, 0xbf,
+    0xab, 0xc6, 0x5a, 0x25, 0x9f, 0xdf, 0x11, 0x79, 0x4f, 0x4e, 0x7e, 0x82, 0x8a, 0x44, 0xe1, 0x04,
+    0x45, 0x5d, 0xc6, 0x1c, 0x88, 0x84, 0xd7, 0xf8, 0x37, 0x26, 0xe3, 0x43, 0xef, 0xaa, 0x54, 0xf9,
+    0x59, 0x8e, 0x2b, 0x25, 0x95, 0xa9, 0x59, 0x0a, 0xcf, 0x3c, 0x85, 0x37, 0x48, 0x93, 0x6c, 0x0a,
+    0x81, 0x99, 0x69, 0x75, 0x71, 0xad, 0x21, 0x29, 0x40, 0xe4, 0x85, 0x8d, 0x23, 0x47, 0xae, 0xd6,
+    0xa0, 0xb3, 0x12, 0x6f, 0xe1, 0x32, 0x95, 0xbc, 0x4c, 0xc2, 0x29, 0x9a, 0x6b, 0x17, 0xf0, 0x6c,
+    0xd4, 0xd5, 0x77, 0x36, 0xea, 0x5a, 0xcd, 0x15, 0xda, 0x35, 0x5e, 0xb4, 0x78, 0x7b, 0x15, 0x4d,
+    0xde, 0xbf, 0xff, 0x30, 0x4d, 0xc8, 0x65, 0x77, 0xa0, 0xba, 0x37, 0xe3, 0x62, 0x4d, 0xd2, 0x92,
+    0x19, 0x33, 0xf7, 0x5c, 0xc5, 0xbc, 0x73, 0x91, 0xcb, 0x98, 0xb7, 0x58, 0x2a, 0x51, 0xce, 0x56,
+    0x44, 0xf0, 0xb9, 0x67, 0x70, 0xeb, 0x2d, 0x86, 0xb3, 0xd1, 0x6a, 0x31, 0x1b, 0xa1, 0xe1, 0xf7,
+    0xcc, 0x3f, 0xe9, 0x1d, 0xf9, 0xaa, 0x24, 0x98, 0x0e, 0xd3, 0xee, 0x5f, 0x03, 0x3d, 0x60, 0xa7,
+    0x90, 0xb7, 0x1c, 0xf2, 0xe4, 0xb6, 0x83, 0xb9, 0xde, 0x79, 0x0d, 0xf5, 0x6b, 0x53, 0x09, 0x2e,
+    0xec, 0x8e, 0xfc, 0xd8, 0x81, 0x8a, 0xa6, 0x7a, 0x0d, 0xf3, 0x27, 0xf6, 0xa3, 0xc6, 0xec, 0x3d,
+    0x8b, 0xee, 0x35, 0xc8, 0xed, 0x2e, 0x2d, 0x4f, 0xd7, 0x49, 0xb1, 0x0e, 0xf6, 0x05, 0xa2, 0x5b,
+    0x8e, 0xad, 0x43, 0x94, 0x4c, 0x4b, 0x91, 0x3e, 0xa2, 0x69, 0xc5, 0x7d, 0x6a, 0x2c, 0x26, 0x9e,
+    0x06, 0x98, 0x46, 0xb7, 0x41, 0x54, 0x6b, 0xb4, 0xf8, 0x2f, 0x63, 0x55, 0x1f, 0x6d, 0x55, 0x7d,
+    0x32, 0xc5, 0x01, 0xae, 0x99, 0x6c, 0x9d, 0x97, 0x42, 0x3e, 0x7a, 0x0b, 0x7c, 0x1e, 0x24, 0xa4,
+    0x16, 0x2f, 0x11, 0x86, 0x21, 0x96, 0x1f, 0xb5, 0xae, 0xdc, 0x93, 0xc5, 0xef, 0x2a, 0xc7, 0xba,
+    0x4e, 0xba, 0x3b, 0xb4, 0x00, 0x95, 0x7b, 0xa7, 0x30, 0x4d, 0xaa, 0x45, 0x6d, 0x17, 0xbd, 0xac,
+    0x91, 0xa9, 0xeb, 0x01, 0xf2, 0xc6, 0x17, 0xc1, 0x5e, 0x83, 0x6d, 0xb4, 0x24, 0x5c, 0xa5, 0x4d,
+    0x85, 0x8f, 0x4e, 0x98, 0x83, 0xbd, 0x2b, 0xc1, 0x6d, 0x7f, 0xde, 0x7d, 0xe6, 0x68, 0x71, 0xf8,
+    0x06, 0x70, 0x41, 0xa6, 0xc1, 0x3e, 0x03, 0x9b, 0x16, 0x3e, 0x1d, 0xd1, 0x7e, 0x3a, 0xd8, 0xe3,
+    0x0b, 0x56, 0x28, 0x1e, 0xd3, 0x2f, 0xf7, 0xcb, 0x07, 0x7a, 0x78, 0x6e, 0x8d, 0xce, 0x7d, 0x13,
+    0xec, 0xd7, 0x4c, 0x93, 0x72, 0xfe, 0xc6, 0xa7, 0x78, 0xa6, 0x41, 0x52, 0x86, 0x16, 0xb6, 0xf6,
+    0xb6, 0x7b, 0xe2, 0x4c, 0x9f, 0xfe, 0x23, 0x69, 0xff, 0x4c, 0x18, 0x1a, 0x4c, 0x09, 0xf8, 0xe3,
+    0xc1, 0x35, 0x4e, 0x2e, 0x12, 0x3a, 0x02, 0x30, 0x73, 0x09, 0x1b, 0x72, 0xb7, 0x46, 0xfd, 0x52,
+    0x35, 0x1a, 0xf5, 0x74, 0x04, 0xee, 0x64, 0x90, 0xb3, 0x07, 0x26, 0xc4, 0x41, 0xab, 0x41, 0xce,
+    0x9f, 0xbc, 0xfb, 0xc1, 0xde, 0xb9, 0xc4, 0x84, 0xd1, 0xe0, 0xcc, 0x23, 0xca, 0xd6, 0x40, 0x0f,
+    0x1d, 0x06, 0xb4, 0x56, 0xfa, 0x7f, 0x80, 0x34, 0x9c, 0x65, 0xfd, 0x84, 0xaf, 0xc0, 0x18, 0x96,
+    0xc3, 0x37, 0x06, 0x08, 0xf6, 0x3d, 0xe2, 0x22, 0xe6, 0xf3, 0xdf, 0x96, 0xf7, 0x7f, 0x84, 0xb5,
+    0x7b, 0xf1, 0x7d, 0x08, 0x39, 0xb3, 0x0c, 0x03, 0xc5, 0x9c, 0x53, 0x37, 0x45, 0x2f, 0xf8, 0x79,
+    0xe8, 0x84, 0x47, 0x75, 0x3b, 0x30, 0x17, 0xfa, 0x56, 0x1a, 0x5a, 0xb5, 0xb4, 0xae, 0x7b, 0xfd,
+    0x49, 0x80, 0xcc, 0xbc, 0xed, 0x29, 0x7f, 0x3a, 0xa0, 0x63, 0xda, 0x71, 0xbb, 0xb1, 0xb9, 0xc0,
+    0x3a, 0x21, 0x42, 0x7f, 0x11, 0x5b, 0xe0, 0x7e, 0xd4, 0x59, 0xe2, 0xac, 0x5c, 0x18, 0xa2, 0xec,
+    0xc2, 0xce, 0x39, 0xfe, 0x6e, 0x34, 0xb3, 0xf1, 0x47, 0x2a, 0x78, 0x09, 0x34, 0xa6, 0x7f, 0xd3,
+    0xbe, 0x7f, 0x14, 0xf6, 0xa3, 0xa0, 0x4f, 0x09, 0xed, 0xf3, 0xb0, 0x84, 0xcc, 0xf6, 0xa9, 0xa1,
+    0x47, 0x96, 0x76, 0x6c, 0x2e, 0x68, 0x5a, 0x29, 0x1a, 0xb8, 0x4e, 0xa1, 0x98, 0x65, 0x84, 0x21,
+    0x86, 0xb8, 0x5c, 0xb4, 0x07, 0xb7, 0xc1, 0x73, 0x7b, 0xf7, 0x56, 0xd0, 0xee, 0x9e, 0x7c, 0xb9,
+    0x00, 0xd0, 0x39, 0xd9, 0x74, 0x23, 0x4d, 0xce, 0xc2, 0xc0, 0xaf, 0x49, 0x0f, 0xab, 0x84, 0xf3,
+    0xd1, 0xb5, 0x3d, 0x0e, 0xd4, 0xf1, 0x61, 0x1c, 0x1d, 0xbf, 0xcc, 0xff, 0x02, 0x97, 0x99, 0x21,
+    0x52, 0xb1, 0x07, 0x00, 0x00,
+};
+
+#endif // DASHBOARD_PAGE_H
@@ -0,0 +1,53 @@
+// ---------------- flash_layout.h ---------------- //
+/*
+ * Where everything lives in on-board flash (2 MB on the Pico W):
+ *
+ *   PICO_FLASH_SIZE_BYTES
+ *     telemetry spool   64 KB  (telemetry.c)
+ *     alert rules       16 KB  (alert_rules.c, compiled bytecode)
+ *     swap scratch       4 KB  (boot/ab_boot.c)
+ *     boot state         8 KB  (two alternating records, fw_update.h)
+ *     slot B           ~944 KB (update download / previous image)
+ *     slot A           ~944 KB (the running firmware, executed in place)
+ *     bootloader        64 KB  (boot2 + boot/ab_boot.c)
+ *   0
+ *
+ * Offsets are from the start of flash (what flash_range_* take); add
+ * XIP_BASE to read them through the cache. The firmware must be linked
+ * to run from XIP_BASE + SLOT_A_OFFSET (a memmap with that FLASH origin
+ * and no boot2), and boot/ab_boot.c built as the image at flash start.
+ */
+#ifndef FLASH_LAYOUT_H
+#define FLASH_LAYOUT_H
+
+#if PICO_ON_DEVICE
+#include "hardware/flash.h"
+#else
+// Host tools: the Pico W's flash geometry
+#define FLASH_PAGE_SIZE       256
+#define FLASH_SECTOR_SIZE     4096
+#define PICO_FLASH_SIZE_BYTES (2 * 1024 * 1024)
+#endif
+
+#define SPOOL_SECTORS       16
+#define SPOOL_BYTES         (SPOOL_SECTORS * FLASH_SECTOR_SIZE)
+#define SPOOL_OFFSET        (PICO_FLASH_SIZE_BYTES - SPOOL_BYTES)
+
+#define RULES_FLASH_SECTORS 4
+#define RULES_FLASH_BYTES   (RULES_FLASH_SECTORS * FLASH_SECTOR_SIZE)
+#define RULES_FLASH_OFFSET  (SPOOL_OFFSET - RULES_FLASH_BYTES)
+
+#define SWAP_SCRATCH_OFFSET (RULES_FLASH_OFFSET - FLASH_SECTOR_SIZE)
+#define BOOT_STATE_OFFSET   (SWAP_SCRATCH_OFFSET - 2 * FLASH_SECTOR_SIZE)
+
+#define BOOTLOADER_BYTES    (64 * 1024)
+#define SLOT_BYTES          (((BOOT_STATE_OFFSET - BOOTLOADER_BYTES) / 2) & ~(FLASH_SECTOR_SIZE - 1))
+#define SLOT_SECTORS        (SLOT_BYTES / FLASH_SECTOR_SIZE)
+#define SLOT_A_OFFSET       BOOTLOADER_BYTES
+#define SLOT_B_OFFSET       (SLOT_A_OFFSET + SLOT_BYTES)
+
+#define FLASH_DATA_OFFSET   BOOT_STATE_OFFSET    // lowest byte above the slots
+
+_Static_assert(SLOT_B_OFFSET + SLOT_BYTES <= BOOT_STATE_OFFSET, "slots overlap the data regions");
+
+#endif // FLASH_LAYOUT_H
@@ -0,0 +1,135 @@
+// ---------------- fw_patch.c ---------------- //
+/*
+ * Streaming patch applier (see fw_patch.h).
+ * Compressed bytes -> LZSS decoder -> command parser -> page buffer -> sink.
+ * Everything is a byte-at-a-time state machine, so the body can arrive in
+ * frames of any size.
+ */
+#include <string.h>
+#include "fw_patch.h"
+
+enum { ST_CMD, ST_OFF, ST_LEN, ST_DATA };
+
+void fwp_init(fwp_t *p, const fw_patch_hdr_t *hdr, const uint8_t *old, fwp_sink_fn sink, void *ctx) {
+    memset(p, 0, sizeof(*p));
+    p->hdr = hdr;
+    p->old = old;
+    p->sink = sink;
+    p->ctx = ctx;
+    p->status = hdr->new_size ? FWP_OK : FWP_DONE;
+    sha256_init(&p->sha);
+}
+
+static void emit(fwp_t *p, uint8_t c) {
+    p->page[p->produced % FWP_PAGE] = c;
+    p->produced++;
+    if (p->produced % FWP_PAGE == 0) {
+        sha256_update(&p->sha, p->page, FWP_PAGE);
+        if (!p->sink(p->ctx, p->produced - FWP_PAGE, p->page)) p->status = FWP_ERR_SINK;
+    }
+    if (p->status == FWP_OK && p->produced == p->hdr->new_size) p->status = FWP_DONE;
+}
+
+// Returns true once a varint is complete (value in p->varint)
+static bool varint_step(fwp_t *p, uint8_t b) {
+    if (p->shift > 28) {
+        p->status = FWP_ERR_FORMAT;
+        return false;
+    }
+    p->varint |= (uint32_t)(b & 0x7F) << p->shift;
+    p->shift += 7;
+    return !(b & 0x80);
+}
+
+static void command(fwp_t *p, uint8_t b) {
+    switch (p->st) {
+    case ST_CMD:
+        if (b != 'A' && b != 'C' && b != 'I') {
+            p->status = FWP_ERR_FORMAT;
+            return;
+        }
+        p->cmd = b;
+        p->varint = 0;
+        p->shift = 0;
+        p->st = b == 'I' ? ST_LEN : ST_OFF;
+        break;
+    case ST_OFF:
+        if (!varint_step(p, b)) return;
+        // zigzag: 0, -1, 1, -2, ... relative to the end of the previous copy
+        p->old_pos += (p->varint >> 1) ^ -(p->varint & 1);
+        p->varint = 0;
+        p->shift = 0;
+        p->st = ST_LEN;
+        break;
+    case ST_LEN:
+        if (!varint_step(p, b)) return;
+        p->left = p->varint;
+        if (p->left > p->hdr->new_size - p->produced ||
+            (p->cmd != 'I' && (p->old_pos > p->hdr->old_size || p->left > p->hdr->old_size - p->old_pos))) {
+            p->status = FWP_ERR_RANGE;
+            return;
+        }
+        if (p->cmd == 'C') {
+            // No data bytes follow: produce the whole run now
+            while (p->left && p->status == FWP_OK) {
+                emit(p, p->old[p->old_pos++]);
+                p->left--;
+            }
+        }
+        p->st = p->left ? ST_DATA : ST_CMD;
+        break;
+    case ST_DATA:
+        if (p->cmd == 'A') emit(p, (uint8_t)(p->old[p->old_pos++] + b));
+        else emit(p, b);
+        if (--p->left == 0) p->st = ST_CMD;
+        break;
+    }
+}
+
+static void put(fwp_t *p, uint8_t c) {
+    p->window[p->wpos++ & (FWP_WINDOW - 1)] = c;
+    command(p, c);
+}
+
+int fwp_feed(fwp_t *p, const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len && p->status == FWP_OK; i++) {
+        uint8_t b = data[i];
+        if (p->flag_bits == 0) {
+            p->flags = b;
+            p->flag_bits = 8;
+            continue;
+        }
+        if (p->flags & 1) {
+            put(p, b);
+        } else if (!p->have_lo) {
+            p->lo = b;
+            p->have_lo = true;
+            continue;
+        } else {
+            uint16_t token = (uint16_t)(p->lo | b << 8);
+            uint16_t off = (token & (FWP_WINDOW - 1)) + 1;
+            uint16_t n = (token >> FWP_WINDOW_BITS) + FWP_MIN_MATCH;
+            while (n-- && p->status == FWP_OK) put(p, p->window[(p->wpos - off) & (FWP_WINDOW - 1)]);
+            p->have_lo = false;
+        }
+        p->flags >>= 1;
+        p->flag_bits--;
+    }
+    return p->status;
+}
+
+int fwp_finish(fwp_t *p) {
+    if (p->status != FWP_DONE) return p->status == FWP_OK ? FWP_ERR_RANGE : p->status;
+    uint32_t tail = p->produced % FWP_PAGE;
+    if (tail) {
+        sha256_update(&p->sha, p->page, tail);
+        memset(p->page + tail, 0xFF, FWP_PAGE - tail);
+        if (!p->sink(p->ctx, p->produced - tail, p->page)) return p->status = FWP_ERR_SINK;
+    }
+    uint8_t digest[32];
+    sha256_final(&p->sha, digest);
+    if (memcmp(digest, p->hdr->new_sha, 32) != 0) return p->status = FWP_ERR_HASH;
+    return FWP_DONE;
+}
+
+// End of fw_patch.c
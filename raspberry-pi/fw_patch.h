@@ -0,0 +1,90 @@
+// ---------------- fw_patch.h ---------------- //
+/*
+ * Firmware delta patches: format and streaming applier.
+ *
+ * A patch is a header followed by an LZSS-compressed body. The body is a
+ * sequence of bsdiff-style commands that rebuild the new image from the
+ * running one:
+ *   'C' off len             new = old[off..]          (unchanged run)
+ *   'A' off len diff[len]   new = old[off..] + diff   (a few bytes differ)
+ *   'I' len bytes[len]      literal bytes
+ * off is a zigzag varint relative to where the previous 'C'/'A' ended, so
+ * the usual "carry on from here" costs one byte. Code that moved or had a
+ * few addresses change gives mostly-zero diffs, which the LZSS stage
+ * (1 KB window, heatshrink-style) squeezes out.
+ *
+ * The applier takes the body in arbitrary pieces and hands out the new
+ * image one flash page at a time, so RAM use is fixed (~1.4 KB) however
+ * large the image. No hardware calls; tools/fw_delta.c links it too.
+ */
+#ifndef FW_PATCH_H
+#define FW_PATCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "checksum.h"
+
+#define FWP_MAGIC        0x31445746u   // "FWD1"
+#define FWP_PAGE         256           // output granularity (FLASH_PAGE_SIZE)
+#define FWP_WINDOW_BITS  10
+#define FWP_WINDOW       (1 << FWP_WINDOW_BITS)
+#define FWP_MIN_MATCH    3
+#define FWP_MAX_MATCH    (FWP_MIN_MATCH + (1 << (16 - FWP_WINDOW_BITS)) - 1)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t old_size;      // running image the patch was made against
+    uint32_t new_size;
+    uint32_t body_len;      // compressed bytes after the header
+    uint8_t old_sha[32];
+    uint8_t new_sha[32];
+} fw_patch_hdr_t;
+
+_Static_assert(sizeof(fw_patch_hdr_t) == 80, "patch header layout");
+
+enum {
+    FWP_OK = 0,
+    FWP_DONE,           // all new_size bytes produced
+    FWP_ERR_FORMAT,     // bad command or varint
+    FWP_ERR_RANGE,      // reads past the old image or writes past new_size
+    FWP_ERR_SINK,       // page writer failed
+    FWP_ERR_HASH,       // rebuilt image does not match new_sha
+};
+
+// Receives each finished page; offset is into the new image. The last
+// page is padded with 0xFF. Return false to abort.
+typedef bool (*fwp_sink_fn)(void *ctx, uint32_t offset, const uint8_t *page);
+
+typedef struct {
+    const fw_patch_hdr_t *hdr;
+    const uint8_t *old;
+    fwp_sink_fn sink;
+    void *ctx;
+    int status;
+
+    // LZSS stage
+    uint8_t window[FWP_WINDOW];
+    uint16_t wpos;
+    uint8_t flags, flag_bits;
+    bool have_lo;
+    uint8_t lo;
+
+    // command stage
+    uint8_t st, cmd, shift;
+    uint32_t varint;
+    uint32_t old_pos, left;
+
+    // output
+    uint8_t page[FWP_PAGE];
+    uint32_t produced;
+    sha256_t sha;
+} fwp_t;
+
+void fwp_init(fwp_t *p, const fw_patch_hdr_t *hdr, const uint8_t *old, fwp_sink_fn sink, void *ctx);
+// Feeds compressed body bytes; returns FWP_OK, FWP_DONE or an error (sticky).
+int fwp_feed(fwp_t *p, const uint8_t *data, size_t len);
+// After FWP_DONE: flushes the last page and checks the hash.
+int fwp_finish(fwp_t *p);
+
+#endif // FW_PATCH_H
@@ -0,0 +1,226 @@
+// ---------------- fw_update.c ---------------- //
+/*
+ * Delta update receiver and boot confirmation (see fw_update.h).
+ * RAM: one frame, the patch header and the applier (~2.1 KB, static).
+ */
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/flash.h"
+#include "hardware/flash.h"
+#include "hardware/watchdog.h"
+#include "fw_update.h"
+#include "fw_patch.h"
+#include "boot_state.h"
+#include "pump_drive.h"
+
+static boot_state_t boot;
+static bool have_boot_record;
+static bool testing;             // this boot runs an unconfirmed image
+
+static const char *state_names[] = {"confirmed", "swap pending", "testing", "revert pending"};
+
+// ---------------- Flash ---------------- //
+typedef struct {
+    uint32_t offset;
+    const uint8_t *data;
+    size_t len;
+    bool erase;
+} fw_flash_op_t;
+
+static void fw_flash_op(void *param) {
+    const fw_flash_op_t *op = param;
+    pump_drive_flash_hold(true);
+    if (op->erase) flash_range_erase(op->offset, FLASH_SECTOR_SIZE);
+    if (op->data) flash_range_program(op->offset, op->data, op->len);
+    pump_drive_flash_hold(false);
+}
+
+void boot_flash_write(uint32_t offset, const uint8_t *data, size_t len, bool erase) {
+    fw_flash_op_t op = {.offset = offset, .data = data, .len = len, .erase = erase};
+    flash_safe_execute(fw_flash_op, &op, UINT32_MAX);
+}
+
+// Applier output: slot B, erasing each sector as its first page arrives
+static bool slot_b_sink(void *ctx, uint32_t offset, const uint8_t *page) {
+    (void)ctx;
+    if (offset + FWP_PAGE > SLOT_BYTES) return false;
+    if (testing) watchdog_update();
+    boot_flash_write(SLOT_B_OFFSET + offset, page, FWP_PAGE, offset % FLASH_SECTOR_SIZE == 0);
+    return true;
+}
+
+static void sha_flash(uint32_t offset, uint32_t len, uint8_t out[32]) {
+    sha256_t s;
+    sha256_init(&s);
+    sha256_update(&s, (const uint8_t *)(XIP_BASE + offset), len);
+    sha256_final(&s, out);
+}
+
+// ---------------- Boot confirmation ---------------- //
+void fw_update_boot(void) {
+    have_boot_record = boot_state_read(&boot);
+    testing = have_boot_record && boot.state == BOOT_TESTING;
+    if (testing) {
+        printf("Firmware: new image on trial, boot %u of %u\n", boot.attempts, BOOT_MAX_ATTEMPTS);
+        watchdog_update();
+    }
+}
+
+void fw_update_poll(bool healthy) {
+    if (!testing) return;
+    watchdog_update();
+    if (!healthy || to_ms_since_boot(get_absolute_time()) < FWU_HEALTHY_AFTER_MS) return;
+
+    boot.state = BOOT_CONFIRMED;
+    boot.attempts = 0;
+    boot_state_write(&boot);
+    testing = false;
+    watchdog_disable();
+    printf("Firmware: new image confirmed\n");
+}
+
+void fw_update_feed(void) {
+    if (testing) watchdog_update();
+}
+
+void fw_update_status(void) {
+    printf("\n--- Firmware ---\n");
+    printf("Slots: A 0x%06lx, B 0x%06lx, %lu KB each\n", (unsigned long)SLOT_A_OFFSET,
+           (unsigned long)SLOT_B_OFFSET, (unsigned long)(SLOT_BYTES / 1024));
+    if (!have_boot_record) {
+        printf("State: factory image (no update yet)\n");
+    } else {
+        printf("State: %s (record %lu, boot %u)\n", boot.state < 4 ? state_names[boot.state] : "?",
+               (unsigned long)boot.seq, boot.attempts);
+        printf("Image: %lu bytes, sha256 ", (unsigned long)boot.image_size);
+        for (int i = 0; i < 8; i++) printf("%02x", boot.image_sha[i]);
+        printf("...\n");
+    }
+    printf("--------------------\n");
+}
+
+// ---------------- Receiver ---------------- //
+static bool read_exact(uint8_t *d, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        int c = getchar_timeout_us(FWU_FRAME_TIMEOUT_MS * 1000);
+        if (c == PICO_ERROR_TIMEOUT) return false;
+        d[i] = (uint8_t)c;
+    }
+    return true;
+}
+
+// Drop whatever is left of a damaged frame
+static void drain(void) {
+    while (getchar_timeout_us(50000) != PICO_ERROR_TIMEOUT) {}
+}
+
+// One frame into buf; 1 = ok, 0 = damaged (NAK sent), -1 = link lost
+static int read_frame(uint8_t *buf, uint16_t *len) {
+    uint8_t hdr[2], crc_le[4];
+    if (!read_exact(hdr, 2)) return -1;
+    *len = (uint16_t)(hdr[0] | hdr[1] << 8);
+    if (*len == 0 || *len > FWU_FRAME_MAX) {
+        drain();
+        printf("UPD NAK\n");
+        return 0;
+    }
+    if (!read_exact(buf, *len) || !read_exact(crc_le, 4)) return -1;
+    uint32_t crc = (uint32_t)crc_le[0] | (uint32_t)crc_le[1] << 8 | (uint32_t)crc_le[2] << 16 | (uint32_t)crc_le[3] << 24;
+    if (crc != crc32(buf, *len)) {
+        drain();
+        printf("UPD NAK\n");
+        return 0;
+    }
+    return 1;
+}
+
+void fw_update_receive(void) {
+    static uint8_t frame[FWU_FRAME_MAX];
+    static fw_patch_hdr_t hdr;
+    static fwp_t patcher;
+    uint16_t len;
+    int r;
+
+    if (testing) {
+        printf("UPD ERR running image not confirmed yet\n");
+        return;
+    }
+    printf("UPD READY %d\n", FWU_FRAME_MAX);
+
+    // Header: must describe the image we are running
+    while ((r = read_frame(frame, &len)) == 0) {}
+    if (r < 0) {
+        printf("UPD ERR timeout\n");
+        return;
+    }
+    memcpy(&hdr, frame, len < sizeof(hdr) ? len : sizeof(hdr));
+    if (len != sizeof(hdr) || hdr.magic != FWP_MAGIC) {
+        printf("UPD ERR not a patch\n");
+        return;
+    }
+    if (hdr.old_size > SLOT_BYTES || hdr.new_size > SLOT_BYTES) {
+        printf("UPD ERR image larger than a slot\n");
+        return;
+    }
+    uint8_t digest[32];
+    sha_flash(SLOT_A_OFFSET, hdr.old_size, digest);
+    if (memcmp(digest, hdr.old_sha, 32) != 0) {
+        printf("UPD ERR patch is for a different image\n");
+        return;
+    }
+    printf("UPD ACK 0\n");
+
+    uint32_t t0 = to_ms_since_boot(get_absolute_time());
+    fwp_init(&patcher, &hdr, (const uint8_t *)(XIP_BASE + SLOT_A_OFFSET), slot_b_sink, NULL);
+    uint32_t got = 0;
+    int status = FWP_OK;
+    while (got < hdr.body_len) {
+        r = read_frame(frame, &len);
+        if (r < 0) {
+            printf("UPD ERR timeout at %lu\n", (unsigned long)got);
+            return;
+        }
+        if (r == 0) continue;
+        if (len > hdr.body_len - got) {
+            printf("UPD ERR body longer than announced\n");
+            return;
+        }
+        status = fwp_feed(&patcher, frame, len);
+        if (status != FWP_OK && status != FWP_DONE) {
+            printf("UPD ERR patch rejected (%d)\n", status);
+            return;
+        }
+        got += len;
+        printf("UPD ACK %lu\n", (unsigned long)got);
+    }
+
+    // Hash of what was produced, then of what actually landed in flash
+    if (fwp_finish(&patcher) != FWP_DONE) {
+        printf("UPD ERR new image hash mismatch\n");
+        return;
+    }
+    sha_flash(SLOT_B_OFFSET, hdr.new_size, digest);
+    if (memcmp(digest, hdr.new_sha, 32) != 0) {
+        printf("UPD ERR slot B verify failed\n");
+        return;
+    }
+
+    uint32_t span = hdr.old_size > hdr.new_size ? hdr.old_size : hdr.new_size;
+    boot.state = BOOT_SWAP_PENDING;
+    boot.attempts = 0;
+    boot.swap_sectors = (uint16_t)((span + FLASH_SECTOR_SIZE - 1) / FLASH_SECTOR_SIZE);
+    boot.image_size = hdr.new_size;
+    memcpy(boot.image_sha, hdr.new_sha, 32);
+    boot_state_write(&boot);
+
+    uint32_t ms = to_ms_since_boot(get_absolute_time()) - t0;
+    if (ms == 0) ms = 1;
+    printf("UPD OK %lu byte patch -> %lu byte image in %lu ms (%lu B/s), rebooting\n",
+           (unsigned long)(sizeof(hdr) + hdr.body_len), (unsigned long)hdr.new_size, (unsigned long)ms,
+           (unsigned long)((uint64_t)hdr.new_size * 1000 / ms));
+    sleep_ms(100);
+    watchdog_reboot(0, 0, 0);
+}
+
+// End of fw_update.c
@@ -0,0 +1,38 @@
+// ---------------- fw_update.h ---------------- //
+/*
+ * Delta firmware updates over the USB CLI, into slot B (flash_layout.h).
+ *
+ * CLI "update" switches the console into a framed binary link:
+ *   device: "UPD READY <frame max>"
+ *   host:   frame = u16 len | payload[len] | u32 crc32(payload)   (LE)
+ *   device: "UPD ACK <bytes so far>" | "UPD NAK" (resend) | "UPD ERR <why>"
+ * The first frame is the fw_patch_hdr_t, the rest the compressed body.
+ * The patch is applied as it arrives against the running image (slot A),
+ * slot B is re-hashed, and the device answers "UPD OK ..." and reboots
+ * into the bootloader, which swaps the slots.
+ *
+ * The new image then runs as TESTING under the watchdog until
+ * fw_update_poll() sees it healthy for FWU_HEALTHY_AFTER_MS and confirms
+ * it; otherwise the bootloader swaps the old image back after
+ * BOOT_MAX_ATTEMPTS boots. tools/fw_delta.c makes and sends the patches.
+ */
+#ifndef FW_UPDATE_H
+#define FW_UPDATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "flash_layout.h"
+
+#define FWU_FRAME_MAX         512     // payload bytes per frame
+#define FWU_FRAME_TIMEOUT_MS  2000
+#define FWU_HEALTHY_AFTER_MS  60000   // uptime before a TESTING image may confirm
+
+#if PICO_ON_DEVICE
+void fw_update_boot(void);              // read the boot state; call early in main()
+void fw_update_poll(bool healthy);      // feed the watchdog / confirm; call about once a second
+void fw_update_feed(void);              // feed only, from code that blocks longer than that
+void fw_update_receive(void);           // CLI "update"
+void fw_update_status(void);            // CLI "firmware"
+#endif
+
+#endif // FW_UPDATE_H
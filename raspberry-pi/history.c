@@ -0,0 +1,307 @@
+// ---------------- history.c ---------------- //
+/*
+ * Compressed sensor history (see history.h).
+ *
+ * Raw block layout, after the first sample which lives in the header:
+ *   timestamp  delta-of-delta, zigzag:  '0' | '10'+7 | '110'+9 | '1110'+12 | '1111'+32
+ *   value      XOR with previous:       '0' same | '10' + bits in previous window
+ *                                       | '11' + lead(4) + len-1(4) + len bits
+ */
+#include <string.h>
+#include "history.h"
+
+#define NO_WINDOW 0xFF
+#define MAX_SAMPLE_BITS (36 + HIST_CHANNELS * 26)   // worst case for one appended sample
+
+// ---------------- Bit packing ---------------- //
+static void put_bits(hist_block_t *b, uint32_t value, uint8_t n) {
+    while (n > 0) {
+        uint8_t room = 8 - (b->bits & 7);
+        uint8_t take = n < room ? n : room;
+        uint8_t chunk = (uint8_t)((value >> (n - take)) & ((1u << take) - 1));
+        b->data[b->bits >> 3] |= (uint8_t)(chunk << (room - take));
+        b->bits += take;
+        n -= take;
+    }
+}
+
+typedef struct {
+    const uint8_t *data;
+    uint16_t pos;
+} bit_reader_t;
+
+static uint32_t get_bits(bit_reader_t *r, uint8_t n) {
+    uint32_t value = 0;
+    while (n > 0) {
+        uint8_t room = 8 - (r->pos & 7);
+        uint8_t take = n < room ? n : room;
+        uint8_t byte = r->data[r->pos >> 3];
+        value = (value << take) | ((byte >> (room - take)) & ((1u << take) - 1));
+        r->pos += take;
+        n -= take;
+    }
+    return value;
+}
+
+static inline uint8_t clz16(uint16_t x) { return (uint8_t)(__builtin_clz((uint32_t)x) - 16); }
+static inline uint8_t ctz16(uint16_t x) { return (uint8_t)__builtin_ctz((uint32_t)x); }
+
+// ---------------- Aggregates ---------------- //
+static void bucket_start(hist_bucket_t *bk, uint32_t t0) {
+    memset(bk, 0, sizeof(*bk));
+    bk->t0 = t0;
+}
+
+static void bucket_add(hist_bucket_t *bk, uint32_t t, const int16_t v[HIST_CHANNELS]) {
+    for (int ch = 0; ch < HIST_CHANNELS; ch++) {
+        hist_agg_t *a = &bk->agg[ch];
+        if (bk->count == 0 || v[ch] < a->min) a->min = v[ch];
+        if (bk->count == 0 || v[ch] > a->max) a->max = v[ch];
+        a->sum += v[ch];
+    }
+    bk->sum_dt += t - bk->t0;
+    bk->count++;
+}
+
+// ---------------- Raw block encoder ---------------- //
+static void block_start(hist_block_t *b, uint32_t t, const int16_t v[HIST_CHANNELS]) {
+    memset(b, 0, sizeof(*b));
+    bucket_start(&b->summary, t);
+    bucket_add(&b->summary, t, v);
+    b->t_last = t;
+    for (int ch = 0; ch < HIST_CHANNELS; ch++) {
+        b->first_v[ch] = v[ch];
+        b->v_last[ch] = v[ch];
+        b->lead[ch] = NO_WINDOW;
+    }
+}
+
+static void put_timestamp(hist_block_t *b, uint32_t t) {
+    int32_t delta = (int32_t)(t - b->t_last);
+    int32_t dod = delta - b->delta_last;
+    uint32_t z = ((uint32_t)dod << 1) ^ (uint32_t)(dod >> 31);
+
+    if (z == 0)          put_bits(b, 0x0, 1);
+    else if (z < 128)  { put_bits(b, 0x2, 2);  put_bits(b, z, 7); }
+    else if (z < 512)  { put_bits(b, 0x6, 3);  put_bits(b, z, 9); }
+    else if (z < 4096) { put_bits(b, 0xE, 4);  put_bits(b, z, 12); }
+    else               { put_bits(b, 0xF, 4);  put_bits(b, z, 32); }
+
+    b->t_last = t;
+    b->delta_last = delta;
+}
+
+static void put_value(hist_block_t *b, int ch, int16_t v) {
+    uint16_t x = (uint16_t)v ^ (uint16_t)b->v_last[ch];
+    b->v_last[ch] = v;
+
+    if (x == 0) {
+        put_bits(b, 0x0, 1);
+        return;
+    }
+    uint8_t lead = clz16(x), trail = ctz16(x);
+    if (b->lead[ch] != NO_WINDOW && lead >= b->lead[ch] && trail >= b->trail[ch]) {
+        // fits in the previous window: only the meaningful bits
+        put_bits(b, 0x2, 2);
+        put_bits(b, x >> b->trail[ch], 16 - b->lead[ch] - b->trail[ch]);
+    } else {
+        uint8_t len = 16 - lead - trail;
+        put_bits(b, 0x3, 2);
+        put_bits(b, lead, 4);
+        put_bits(b, len - 1, 4);
+        put_bits(b, x >> trail, len);
+        b->lead[ch] = lead;
+        b->trail[ch] = trail;
+    }
+}
+
+// ---------------- Raw block decoder ---------------- //
+typedef struct {
+    bit_reader_t r;
+    uint16_t left;          // samples still to decode after the current one
+    uint32_t t;
+    int32_t delta;
+    int16_t v[HIST_CHANNELS];
+    uint8_t lead[HIST_CHANNELS], trail[HIST_CHANNELS];
+} block_cursor_t;
+
+static void cursor_open(block_cursor_t *c, const hist_block_t *b) {
+    c->r.data = b->data;
+    c->r.pos = 0;
+    c->left = b->summary.count - 1;
+    c->t = b->summary.t0;
+    c->delta = 0;
+    for (int ch = 0; ch < HIST_CHANNELS; ch++) {
+        c->v[ch] = b->first_v[ch];
+        c->lead[ch] = NO_WINDOW;
+    }
+}
+
+static bool cursor_next(block_cursor_t *c) {
+    if (c->left == 0) return false;
+    c->left--;
+
+    uint32_t z;
+    if (get_bits(&c->r, 1) == 0)      z = 0;
+    else if (get_bits(&c->r, 1) == 0) z = get_bits(&c->r, 7);
+    else if (get_bits(&c->r, 1) == 0) z = get_bits(&c->r, 9);
+    else if (get_bits(&c->r, 1) == 0) z = get_bits(&c->r, 12);
+    else                              z = get_bits(&c->r, 32);
+    int32_t dod = (int32_t)(z >> 1) ^ -(int32_t)(z & 1);
+    c->delta += dod;
+    c->t += (uint32_t)c->delta;
+
+    for (int ch = 0; ch < HIST_CHANNELS; ch++) {
+        if (get_bits(&c->r, 1) == 0) continue;
+        uint16_t x;
+        if (get_bits(&c->r, 1) == 0) {
+            x = (uint16_t)(get_bits(&c->r, 16 - c->lead[ch] - c->trail[ch]) << c->trail[ch]);
+        } else {
+            uint8_t lead = (uint8_t)get_bits(&c->r, 4);
+            uint8_t len = (uint8_t)get_bits(&c->r, 4) + 1;
+            c->lead[ch] = lead;
+            c->trail[ch] = 16 - lead - len;
+            x = (uint16_t)(get_bits(&c->r, len) << c->trail[ch]);
+        }
+        c->v[ch] = (int16_t)((uint16_t)c->v[ch] ^ x);
+    }
+    return true;
+}
+
+// ---------------- Recording ---------------- //
+void history_init(history_t *h) {
+    memset(h, 0, sizeof(*h));
+}
+
+static void push_bucket(hist_bucket_t *ring, uint8_t size, uint8_t *head, uint8_t *used, const hist_bucket_t *bk) {
+    ring[*head] = *bk;
+    *head = (uint8_t)((*head + 1) % size);
+    if (*used < size) (*used)++;
+}
+
+void history_record(history_t *h, uint32_t t_s, const int16_t v[HIST_CHANNELS]) {
+    // Raw tier
+    hist_block_t *b = &h->blocks[h->block_head];
+    if (h->blocks_used == 0) {
+        block_start(b, t_s, v);
+        h->blocks_used = 1;
+    } else if (b->bits + MAX_SAMPLE_BITS > HIST_BLOCK_BYTES * 8 || b->summary.count == UINT16_MAX) {
+        h->block_head = (uint8_t)((h->block_head + 1) % HIST_BLOCKS);
+        if (h->blocks_used < HIST_BLOCKS) h->blocks_used++;
+        block_start(&h->blocks[h->block_head], t_s, v);
+    } else {
+        put_timestamp(b, t_s);
+        for (int ch = 0; ch < HIST_CHANNELS; ch++) put_value(b, ch, v[ch]);
+        bucket_add(&b->summary, t_s, v);
+    }
+
+    // Minute / hour rollups
+    uint32_t minute = t_s - t_s % 60;
+    uint32_t hour = t_s - t_s % 3600;
+    if (h->cur_minute.count > 0 && h->cur_minute.t0 != minute) {
+        push_bucket(h->minutes, HIST_MINUTES, &h->minute_head, &h->minutes_used, &h->cur_minute);
+    }
+    if (h->cur_minute.count == 0 || h->cur_minute.t0 != minute) bucket_start(&h->cur_minute, minute);
+    bucket_add(&h->cur_minute, t_s, v);
+
+    if (h->cur_hour.count > 0 && h->cur_hour.t0 != hour) {
+        push_bucket(h->hours, HIST_HOURS, &h->hour_head, &h->hours_used, &h->cur_hour);
+    }
+    if (h->cur_hour.count == 0 || h->cur_hour.t0 != hour) bucket_start(&h->cur_hour, hour);
+    bucket_add(&h->cur_hour, t_s, v);
+}
+
+// ---------------- Queries ---------------- //
+typedef struct {
+    uint32_t start;
+    int16_t min, max;
+    uint32_t n;
+    double sum;
+    double sw, st, stt, stv;   // weighted regression sums, t in hours from start
+    uint32_t t_first, t_last;
+} hist_acc_t;
+
+// Add `count` samples summarised by their mean time, value sum and range.
+static void acc_add(hist_acc_t *a, double t_mean, uint32_t count, double sum, int16_t mn, int16_t mx,
+                    uint32_t t_first, uint32_t t_last) {
+    if (count == 0) return;
+    if (a->n == 0 || mn < a->min) a->min = mn;
+    if (a->n == 0 || mx > a->max) a->max = mx;
+    if (a->n == 0 || t_first < a->t_first) a->t_first = t_first;
+    if (a->n == 0 || t_last > a->t_last) a->t_last = t_last;
+    a->n += count;
+    a->sum += sum;
+
+    double t_h = (t_mean - a->start) / 3600.0;
+    a->sw += count;
+    a->st += count * t_h;
+    a->stt += count * t_h * t_h;
+    a->stv += t_h * sum;
+}
+
+static void acc_bucket(hist_acc_t *a, const hist_bucket_t *bk, uint8_t ch, uint32_t t_end) {
+    if (bk->count == 0) return;
+    double t_mean = bk->t0 + (double)bk->sum_dt / bk->count;
+    acc_add(a, t_mean, bk->count, bk->agg[ch].sum, bk->agg[ch].min, bk->agg[ch].max, bk->t0, t_end);
+}
+
+static void acc_ring(hist_acc_t *a, const hist_bucket_t *ring, uint8_t size, uint8_t head, uint8_t used,
+                     uint8_t ch, uint32_t len_s) {
+    for (uint8_t i = 0; i < used; i++) {
+        const hist_bucket_t *bk = &ring[(head + size - used + i) % size];
+        if (bk->t0 + len_s > a->start) acc_bucket(a, bk, ch, bk->t0 + len_s - 1);
+    }
+}
+
+static void acc_blocks(hist_acc_t *a, const history_t *h, uint8_t ch) {
+    for (uint8_t i = 0; i < h->blocks_used; i++) {
+        const hist_block_t *b = &h->blocks[(h->block_head + HIST_BLOCKS - h->blocks_used + 1 + i) % HIST_BLOCKS];
+        if (b->t_last < a->start) continue;
+        if (b->summary.t0 >= a->start) {
+            // whole block inside the window: summary only, no decoding
+            acc_bucket(a, &b->summary, ch, b->t_last);
+            continue;
+        }
+        block_cursor_t c;
+        cursor_open(&c, b);
+        do {
+            if (c.t >= a->start) acc_add(a, c.t, 1, c.v[ch], c.v[ch], c.v[ch], c.t, c.t);
+        } while (cursor_next(&c));
+    }
+}
+
+bool history_query(const history_t *h, uint8_t channel, uint32_t now_s, uint32_t window_s, hist_stats_t *out) {
+    if (channel >= HIST_CHANNELS || h->blocks_used == 0) return false;
+
+    hist_acc_t a;
+    memset(&a, 0, sizeof(a));
+    a.start = now_s > window_s ? now_s - window_s : 0;
+
+    // Finest tier that still reaches back to the window start
+    const hist_block_t *oldest_block = &h->blocks[(h->block_head + HIST_BLOCKS - h->blocks_used + 1) % HIST_BLOCKS];
+    bool raw_covers = h->blocks_used < HIST_BLOCKS || oldest_block->summary.t0 <= a.start;
+    bool minutes_covers = h->minutes_used < HIST_MINUTES ||
+                          h->minutes[h->minute_head].t0 <= a.start;  // head is the oldest once full
+
+    if (raw_covers) {
+        acc_blocks(&a, h, channel);
+    } else if (minutes_covers) {
+        acc_ring(&a, h->minutes, HIST_MINUTES, h->minute_head, h->minutes_used, channel, 60);
+        acc_bucket(&a, &h->cur_minute, channel, now_s);
+    } else {
+        acc_ring(&a, h->hours, HIST_HOURS, h->hour_head, h->hours_used, channel, 3600);
+        acc_bucket(&a, &h->cur_hour, channel, now_s);
+    }
+    if (a.n == 0) return false;
+
+    out->min = a.min;
+    out->max = a.max;
+    out->count = a.n;
+    out->avg = (float)(a.sum / a.n);
+    out->span_s = a.t_last - a.t_first;
+    double den = a.sw * a.stt - a.st * a.st;
+    out->slope_per_hour = den > 1e-9 ? (float)((a.sw * a.stv - a.st * a.sum) / den) : 0.0f;
+    return true;
+}
+
+// End of history.c
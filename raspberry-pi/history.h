@@ -0,0 +1,77 @@
+// ---------------- history.h ---------------- //
+/*
+ * In-RAM sensor history for the irrigation firmware.
+ * Recent samples are kept compressed (delta-of-delta timestamps, XOR-packed
+ * values) in a ring of small blocks; older data is rolled up into minute and
+ * hour buckets. Each block and bucket carries its own min/max/sum, so window
+ * queries only decode the blocks that straddle the window edge.
+ * Footprint is fixed at compile time: sizeof(history_t), roughly 5 KB.
+ */
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- Channels ---
+#define HIST_CHANNELS 3
+enum { HIST_SOIL = 0, HIST_TEMP = 1, HIST_HUM = 2 };  // soil raw ADC, temp/hum in 0.1 units
+
+// --- Sizing (override with -D to trade RAM for depth) ---
+#define HIST_BLOCK_BYTES 192   // compressed payload per raw block
+#ifndef HIST_BLOCKS
+#define HIST_BLOCKS        8   // raw blocks kept (~25 min at one sample / 2 s)
+#endif
+#define HIST_MINUTES      60   // minute rollups (1 h)
+#define HIST_HOURS        24   // hour rollups (24 h)
+
+typedef struct {
+    int16_t min, max;
+    int32_t sum;
+} hist_agg_t;
+
+// Aggregate over a span of samples: a rollup bucket or a raw block summary
+typedef struct {
+    uint32_t t0;        // first timestamp (s) or bucket start
+    uint32_t sum_dt;    // sum of (t - t0), gives the mean sample time
+    uint16_t count;
+    hist_agg_t agg[HIST_CHANNELS];
+} hist_bucket_t;
+
+typedef struct {
+    hist_bucket_t summary;
+    int16_t first_v[HIST_CHANNELS];
+    // encoder state for the next append
+    uint32_t t_last;
+    int32_t delta_last;
+    int16_t v_last[HIST_CHANNELS];
+    uint8_t lead[HIST_CHANNELS], trail[HIST_CHANNELS];
+    uint16_t bits;
+    uint8_t data[HIST_BLOCK_BYTES];
+} hist_block_t;
+
+typedef struct {
+    hist_block_t blocks[HIST_BLOCKS];
+    uint8_t block_head;     // block being written
+    uint8_t blocks_used;
+
+    hist_bucket_t minutes[HIST_MINUTES];
+    hist_bucket_t hours[HIST_HOURS];
+    uint8_t minute_head, minutes_used;
+    uint8_t hour_head, hours_used;
+    hist_bucket_t cur_minute, cur_hour;
+} history_t;
+
+typedef struct {
+    int16_t min, max;
+    float avg;
+    float slope_per_hour;   // least-squares trend, units per hour
+    uint32_t count;         // samples covered
+    uint32_t span_s;        // time actually covered by the data
+} hist_stats_t;
+
+void history_init(history_t *h);
+void history_record(history_t *h, uint32_t t_s, const int16_t v[HIST_CHANNELS]);
+bool history_query(const history_t *h, uint8_t channel, uint32_t now_s, uint32_t window_s, hist_stats_t *out);
+
+#endif // HISTORY_H
@@ -0,0 +1,351 @@
+// ---------------- http_dashboard.c ---------------- //
+/*
+ * Zero-copy HTTP/1.1 + SSE server (see http_dashboard.h).
+ *
+ * The page, response headers and SSE frames are handed to tcp_write()
+ * without TCP_WRITE_FLAG_COPY, so they must stay untouched until acked:
+ *   - page and headers are const data in flash;
+ *   - SSE frames sit in a ring of HTTP_MAX_SSE + 1 slots, each with a count
+ *     of clients that still hold unacked bytes from it. A new snapshot goes
+ *     into a free slot and only to clients that have acked their last frame,
+ *     so a slow client skips updates instead of queueing them.
+ * All lwIP calls from the task are made under cyw43_arch_lwip_begin/end;
+ * callbacks already run with the lwIP lock held.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/cyw43_arch.h"
+#include "lwip/tcp.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "http_dashboard.h"
+#include "dashboard_page.h"
+#include "telemetry.h"
+
+// --- Shared state from watering_system_main.c ---
+extern volatile uint8_t dry_zones;
+extern volatile uint32_t irrigation_count;
+extern volatile bool manual_abort_flag;
+extern volatile bool manual_start_flag;
+extern volatile float temperature;
+extern volatile float humidity;
+extern volatile uint16_t soil_level;
+extern volatile int8_t watering_zone;
+extern volatile int watering_seconds;
+
+#define HTTP_REQ_MAX   256
+#define HTTP_IDLE_POLLS 10   // tcp_poll interval 2 is one poll/s -> ~10 s to send a request
+#define FRAME_SLOTS    (HTTP_MAX_SSE + 1)
+
+enum { CONN_FREE, CONN_REQUEST, CONN_RESPONSE, CONN_SSE };
+
+typedef struct {
+    struct tcp_pcb *pcb;
+    uint8_t state;
+    uint8_t polls;
+    uint16_t req_len;
+    char req[HTTP_REQ_MAX];     // request, then reused for small dynamic bodies
+    const uint8_t *tx;          // body still to queue (RESPONSE)
+    uint32_t tx_left;
+    uint32_t unacked;           // bytes written but not yet acked
+    int8_t frame;               // SSE frame slot held until acked, -1 if none
+} http_conn_t;
+
+typedef struct {
+    char buf[HTTP_FRAME_MAX];
+    uint16_t len;
+    uint8_t refs;
+    uint32_t t_us;
+} sse_frame_t;
+
+static http_conn_t conns[HTTP_MAX_CONNS];
+static sse_frame_t frames[FRAME_SLOTS];
+static http_stats_t stats;
+static uint64_t latency_sum_us;
+static uint32_t latency_count;
+static char page_headers[160];
+static uint16_t page_headers_len;
+
+static const char SSE_HEADERS[] =
+    "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+    "Cache-Control: no-cache\r\nConnection: keep-alive\r\n\r\n"
+    "retry: 2000\n\n";
+static const char NO_CONTENT[] = "HTTP/1.1 204 No Content\r\nConnection: close\r\n\r\n";
+static const char NOT_FOUND[] = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+static const char BUSY[] = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+
+// ---------------- Connection helpers ---------------- //
+static void frame_release(http_conn_t *c) {
+    if (c->frame < 0) return;
+    sse_frame_t *f = &frames[c->frame];
+    uint32_t latency = time_us_32() - f->t_us;
+    latency_sum_us += latency;
+    latency_count++;
+    if (latency > stats.latency_max_us) stats.latency_max_us = latency;
+    f->refs--;
+    c->frame = -1;
+}
+
+static void conn_free(http_conn_t *c) {
+    if (c->state == CONN_SSE) stats.clients--;
+    if (c->frame >= 0) frames[c->frame].refs--;
+    memset(c, 0, sizeof(*c));
+    c->frame = -1;
+}
+
+// Returns ERR_ABRT if the pcb had to be aborted; callbacks must pass that on.
+// With bytes still unacked, lwIP would keep sending them from c->req or the
+// SSE frame after the slot is reused, so the pcb is aborted instead: that
+// drops its queued segments (and sends a RST) before anything is freed.
+static err_t conn_close(http_conn_t *c) {
+    struct tcp_pcb *pcb = c->pcb;
+    tcp_arg(pcb, NULL);
+    tcp_recv(pcb, NULL);
+    tcp_sent(pcb, NULL);
+    tcp_err(pcb, NULL);
+    tcp_poll(pcb, NULL, 0);
+    if (c->unacked > 0 || tcp_close(pcb) != ERR_OK) {
+        tcp_abort(pcb);
+        conn_free(c);
+        return ERR_ABRT;
+    }
+    conn_free(c);
+    return ERR_OK;
+}
+
+static bool conn_write(http_conn_t *c, const void *data, uint16_t len) {
+    if (tcp_write(c->pcb, data, len, 0) != ERR_OK) return false;
+    c->unacked += len;
+    return true;
+}
+
+// Queue as much of the pending body as the send buffer takes.
+static void conn_send_more(http_conn_t *c) {
+    while (c->tx_left > 0) {
+        uint16_t room = tcp_sndbuf(c->pcb);
+        if (room == 0) break;
+        uint16_t n = c->tx_left < room ? (uint16_t)c->tx_left : room;
+        if (!conn_write(c, c->tx, n)) break;
+        c->tx += n;
+        c->tx_left -= n;
+    }
+    tcp_output(c->pcb);
+}
+
+// Headers and optional body, then close once everything is acked.
+static err_t conn_respond(http_conn_t *c, const char *head, uint16_t head_len, const void *body, uint32_t body_len) {
+    c->state = CONN_RESPONSE;
+    c->tx = body;
+    c->tx_left = body_len;
+    if (!conn_write(c, head, head_len)) return conn_close(c);
+    conn_send_more(c);
+    return ERR_OK;
+}
+
+// ---------------- Routing ---------------- //
+static err_t route(http_conn_t *c) {
+    const char *r = c->req;
+
+    if (strncmp(r, "GET / ", 6) == 0 || strncmp(r, "GET /index.html ", 16) == 0) {
+        return conn_respond(c, page_headers, page_headers_len, dashboard_page_gz, sizeof(dashboard_page_gz));
+    } else if (strncmp(r, "GET /events ", 12) == 0) {
+        if (stats.clients >= HTTP_MAX_SSE) {
+            return conn_respond(c, BUSY, sizeof(BUSY) - 1, NULL, 0);
+        }
+        c->state = CONN_SSE;
+        stats.clients++;
+        if (stats.clients > stats.clients_peak) stats.clients_peak = stats.clients;
+        if (!conn_write(c, SSE_HEADERS, sizeof(SSE_HEADERS) - 1)) return conn_close(c);
+        tcp_output(c->pcb);
+        return ERR_OK;
+    } else if (strncmp(r, "POST /start ", 12) == 0) {
+        manual_start_flag = true;
+        printf("Manual start requested (web)!\n");
+        return conn_respond(c, NO_CONTENT, sizeof(NO_CONTENT) - 1, NULL, 0);
+    } else if (strncmp(r, "POST /stop ", 11) == 0) {
+        manual_abort_flag = true;
+        printf("Manual stop requested (web)!\n");
+        return conn_respond(c, NO_CONTENT, sizeof(NO_CONTENT) - 1, NULL, 0);
+    } else if (strncmp(r, "GET /stats ", 11) == 0) {
+        // The request buffer is done with; reuse it for the body
+        http_stats_t st;
+        http_get_stats(&st);
+        int body = snprintf(c->req, sizeof(c->req),
+            "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nConnection: close\r\n\r\n"
+            "{\"clients\":%u,\"peak\":%u,\"sent\":%lu,\"skipped\":%lu,\"lat_avg_us\":%lu,\"lat_max_us\":%lu}",
+            st.clients, st.clients_peak, (unsigned long)st.events_sent, (unsigned long)st.events_skipped,
+            (unsigned long)st.latency_avg_us, (unsigned long)st.latency_max_us);
+        if (body >= (int)sizeof(c->req)) body = sizeof(c->req) - 1;
+        return conn_respond(c, c->req, (uint16_t)body, NULL, 0);
+    }
+    return conn_respond(c, NOT_FOUND, sizeof(NOT_FOUND) - 1, NULL, 0);
+}
+
+// ---------------- lwIP callbacks ---------------- //
+static err_t on_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err) {
+    http_conn_t *c = arg;
+    if (p == NULL) {
+        // The client is done sending; a response still going out finishes
+        // first and on_sent closes it (on_poll if the client stops acking)
+        if (c->state == CONN_RESPONSE) return ERR_OK;
+        return conn_close(c);
+    }
+
+    bool complete = false;
+    if (c->state == CONN_REQUEST) {
+        uint16_t room = HTTP_REQ_MAX - 1 - c->req_len;
+        uint16_t n = pbuf_copy_partial(p, c->req + c->req_len, p->tot_len < room ? p->tot_len : room, 0);
+        c->req_len += n;
+        c->req[c->req_len] = '\0';
+        // Only the request line matters; answer once the header block ends or the buffer is full
+        complete = strstr(c->req, "\r\n\r\n") || c->req_len == HTTP_REQ_MAX - 1;
+    }
+    tcp_recved(pcb, p->tot_len);
+    pbuf_free(p);
+    return complete ? route(c) : ERR_OK;
+}
+
+static err_t on_sent(void *arg, struct tcp_pcb *pcb, u16_t len) {
+    http_conn_t *c = arg;
+    c->unacked -= len;
+    c->polls = 0;
+
+    if (c->state == CONN_RESPONSE) {
+        conn_send_more(c);
+        if (c->tx_left == 0 && c->unacked == 0) return conn_close(c);
+    } else if (c->state == CONN_SSE && c->unacked == 0) {
+        frame_release(c);
+    }
+    return ERR_OK;
+}
+
+static void on_err(void *arg, err_t err) {
+    // pcb is already gone
+    if (arg) conn_free(arg);
+}
+
+static err_t on_poll(void *arg, struct tcp_pcb *pcb) {
+    http_conn_t *c = arg;
+    if (c->state != CONN_SSE && ++c->polls > HTTP_IDLE_POLLS) return conn_close(c);
+    return ERR_OK;
+}
+
+static err_t on_accept(void *arg, struct tcp_pcb *pcb, err_t err) {
+    if (err != ERR_OK || pcb == NULL) return ERR_VAL;
+
+    http_conn_t *c = NULL;
+    for (int i = 0; i < HTTP_MAX_CONNS; i++) {
+        if (conns[i].state == CONN_FREE) { c = &conns[i]; break; }
+    }
+    if (c == NULL) {
+        tcp_abort(pcb);
+        return ERR_ABRT;
+    }
+    memset(c, 0, sizeof(*c));
+    c->pcb = pcb;
+    c->state = CONN_REQUEST;
+    c->frame = -1;
+
+    tcp_arg(pcb, c);
+    tcp_recv(pcb, on_recv);
+    tcp_sent(pcb, on_sent);
+    tcp_err(pcb, on_err);
+    tcp_poll(pcb, on_poll, 2);
+    tcp_nagle_disable(pcb);
+    return ERR_OK;
+}
+
+// ---------------- SSE publishing ---------------- //
+static void publish_snapshot(void) {
+    int slot = -1;
+    for (int i = 0; i < FRAME_SLOTS; i++) {
+        if (frames[i].refs == 0) { slot = i; break; }
+    }
+    if (slot < 0) return;   // cannot happen with FRAME_SLOTS > HTTP_MAX_SSE
+
+    sse_frame_t *f = &frames[slot];
+    int len = snprintf(f->buf, sizeof(f->buf),
+        "data: {\"t\":%lu,\"soil\":%u,\"zones\":%u,\"temp\":%.1f,\"hum\":%.1f,\"zone\":%d,\"left\":%d,\"count\":%lu}\n\n",
+        (unsigned long)(to_ms_since_boot(get_absolute_time()) / 1000), soil_level, dry_zones,
+        temperature, humidity, watering_zone, watering_seconds, (unsigned long)irrigation_count);
+    if (len <= 0 || len >= (int)sizeof(f->buf)) return;
+    f->len = (uint16_t)len;
+    f->t_us = time_us_32();
+
+    for (int i = 0; i < HTTP_MAX_CONNS; i++) {
+        http_conn_t *c = &conns[i];
+        if (c->state != CONN_SSE) continue;
+        if (c->unacked > 0 || !conn_write(c, f->buf, f->len)) {
+            stats.events_skipped++;
+            continue;
+        }
+        c->frame = (int8_t)slot;
+        f->refs++;
+        stats.events_sent++;
+        tcp_output(c->pcb);
+    }
+}
+
+void http_get_stats(http_stats_t *out) {
+    *out = stats;
+    out->latency_avg_us = latency_count ? (uint32_t)(latency_sum_us / latency_count) : 0;
+}
+
+uint32_t http_ram_bytes(void) {
+    return sizeof(conns) + sizeof(frames) + sizeof(stats) + sizeof(page_headers);
+}
+
+// ---------------- Server task ---------------- //
+// Give up for good; params is where the creator keeps our handle
+static void task_exit(void *params) {
+    if (params) *(TaskHandle_t *)params = NULL;
+    vTaskDelete(NULL);
+}
+
+void http_dashboard_task(void *params) {
+    // Wi-Fi is brought up by the telemetry task
+    while (!telemetry_link_up()) {
+        if (telemetry_wifi_failed()) {
+            printf("[HTTP] no Wi-Fi, dashboard disabled\n");
+            task_exit(params);
+        }
+        vTaskDelay(pdMS_TO_TICKS(500));
+    }
+
+    for (int i = 0; i < HTTP_MAX_CONNS; i++) conns[i].frame = -1;
+    page_headers_len = (uint16_t)snprintf(page_headers, sizeof(page_headers),
+        "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Encoding: gzip\r\n"
+        "Content-Length: %u\r\nConnection: close\r\n\r\n", (unsigned)sizeof(dashboard_page_gz));
+
+    cyw43_arch_lwip_begin();
+    struct tcp_pcb *listen = tcp_new_ip_type(IPADDR_TYPE_ANY);
+    if (listen == NULL || tcp_bind(listen, IP_ANY_TYPE, HTTP_PORT) != ERR_OK) {
+        if (listen) tcp_close(listen);
+        cyw43_arch_lwip_end();
+        printf("[HTTP] bind failed\n");
+        task_exit(params);
+    }
+    // On failure lwIP leaves the bound pcb allocated; on success it frees it
+    struct tcp_pcb *bound = listen;
+    listen = tcp_listen_with_backlog(bound, HTTP_MAX_CONNS);
+    if (listen == NULL) {
+        tcp_close(bound);
+        cyw43_arch_lwip_end();
+        printf("[HTTP] listen failed\n");
+        task_exit(params);
+    }
+    tcp_accept(listen, on_accept);
+    cyw43_arch_lwip_end();
+    printf("[HTTP] dashboard on port %d\n", HTTP_PORT);
+
+    TickType_t last = xTaskGetTickCount();
+    while(1) {
+        vTaskDelayUntil(&last, pdMS_TO_TICKS(HTTP_UPDATE_MS));
+        cyw43_arch_lwip_begin();
+        publish_snapshot();
+        cyw43_arch_lwip_end();
+    }
+}
+
+// End of http_dashboard.c
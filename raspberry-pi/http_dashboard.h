@@ -0,0 +1,40 @@
+// ---------------- http_dashboard.h ---------------- //
+/*
+ * Live web dashboard for the Pico W, on lwIP's raw TCP API.
+ *   GET  /        gzip dashboard page, streamed straight from flash
+ *   GET  /events  Server-Sent-Events stream of sensor snapshots
+ *   GET  /stats   server counters as JSON
+ *   POST /start   same as the CLI 'start' (manual_start_flag)
+ *   POST /stop    same as the CLI 'stop'  (manual_abort_flag)
+ *
+ * Connections live in a fixed table and SSE frames in a small shared ring,
+ * so nothing is allocated per client.
+ */
+#ifndef HTTP_DASHBOARD_H
+#define HTTP_DASHBOARD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HTTP_PORT         80
+#define HTTP_MAX_CONNS    6    // total open connections
+#define HTTP_MAX_SSE      4    // of which live /events streams
+#define HTTP_FRAME_MAX    192  // one SSE frame ("data: {...}\n\n")
+#define HTTP_UPDATE_MS    1000
+
+typedef struct {
+    uint8_t clients;           // open /events streams now
+    uint8_t clients_peak;
+    uint32_t events_sent;
+    uint32_t events_skipped;   // client still busy with the previous frame
+    uint32_t latency_avg_us;   // publish -> TCP ack
+    uint32_t latency_max_us;
+} http_stats_t;
+
+// params: optional TaskHandle_t * holding this task's handle; cleared
+// before the task deletes itself (no Wi-Fi, no socket).
+void http_dashboard_task(void *params);
+void http_get_stats(http_stats_t *out);
+uint32_t http_ram_bytes(void);
+
+#endif // HTTP_DASHBOARD_H
@@ -0,0 +1,81 @@
+// ---------------- irrigation_cycle.c ---------------- //
+/*
+ * soil_task / irrigation_task bodies (see irrigation_cycle.h). Console
+ * lines are formatted here and handed to io->log, so the benchmark pays
+ * for the formatting the firmware does.
+ */
+#include <stdio.h>
+#include "irrigation_cycle.h"
+#include "alert_rules.h"
+
+uint8_t irrigation_soil_pass(const irrigation_params_t *p, const irrigation_io_t *io, uint16_t *probes,
+                             float *distance) {
+    io->read_probes(probes);
+
+    // Dry zones from each zone's probe; skip watering if humidity > 80%
+    uint8_t zones = irrigation_dry_zones(p, probes, *io->humidity);
+    io->signal(SIG_SOIL, probes[0]);
+    *distance = irrigation_threshold_distance(p, probes);
+    return zones;
+}
+
+irrigation_end_t irrigation_water_zone(const irrigation_params_t *p, const irrigation_io_t *io, int zone,
+                                       uint8_t dry_zones) {
+    char line[80], msg[24];     // "Watering Z%d" for any int
+    snprintf(line, sizeof(line), "\n=== Starting watering Zone %d ===\n", zone + 1);
+    io->log(line);
+    snprintf(msg, sizeof(msg), "Watering Z%d", zone + 1);
+    io->message(msg);
+
+    io->pump_on(zone);
+    io->servo(irrigation_servo_angle(dry_zones));
+    io->watering(zone);
+    io->signal(SIG_WATERING, 1);
+
+    irrigation_end_t end = IRR_DONE;
+    for (int seconds = p->water_seconds; seconds > 0; seconds--) {
+        if (io->abort_requested()) {
+            io->log("Manual abort via CLI!\n");
+            end = IRR_ABORTED;
+            break;
+        }
+        io->signal(SIG_INTRUSION, io->intrusion());
+        const char *rule = io->stop_rule();
+        if (rule) {
+            // A rule with the "stop" action fired (e.g. INTRUSION)
+            snprintf(line, sizeof(line), "%s alert! Stopping watering.\n", rule);
+            io->log(line);
+            io->pump_off(zone);
+            io->delay_ms(2000);
+            end = IRR_ALERT_STOP;
+            break;
+        }
+        if (io->pump_fault()) {
+            // The drive has already cut the pump; log why, with the current waveform
+            io->log("Pump fault! Stopping watering.\n");
+            io->pump_report();
+            end = IRR_PUMP_FAULT;
+            break;
+        }
+
+        snprintf(line, sizeof(line), "[Zone %d] Watering... %d s | Temp=%.1fC Hum=%.1f%%\n", zone + 1, seconds,
+                 *io->temperature, *io->humidity);
+        io->log(line);
+        io->countdown(seconds);
+        io->delay_ms(1000);
+    }
+
+    io->pump_off(zone);
+    io->watering(-1);
+    io->signal(SIG_WATERING, 0);
+    snprintf(line, sizeof(line), "=== Finished watering Zone %d ===\n", zone + 1);
+    io->log(line);
+    io->message("Zone Done");
+
+    (*io->cycles)++;
+    io->signal(SIG_CYCLES, *io->cycles);   // maintenance rule
+    io->delay_ms(2000);
+    return end;
+}
+
+// End of irrigation_cycle.c
@@ -0,0 +1,54 @@
+// ---------------- irrigation_cycle.h ---------------- //
+/*
+ * The per-pass bodies of soil_task and irrigation_task, with every
+ * hardware, RTOS and display call behind an irrigation_io_t table. The
+ * firmware's table drives the relays or motor drive, servo, screen and
+ * vTaskDelay; tools/host_bench.c fills one from hal_sim, so it times the
+ * code the tasks run rather than a copy of it.
+ */
+#ifndef IRRIGATION_CYCLE_H
+#define IRRIGATION_CYCLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "irrigation_logic.h"
+
+typedef struct {
+    void (*read_probes)(uint16_t *probes);        // PROBE_COUNT readings
+    void (*signal)(uint8_t sig, float value);     // alert_signal()
+    void (*pump_on)(int zone);
+    void (*pump_off)(int zone);
+    bool (*pump_fault)(void);                     // the drive has cut the pump
+    void (*pump_report)(void);                    // why, printed after a fault
+    bool (*intrusion)(void);
+    void (*servo)(float angle);
+    void (*message)(const char *msg);             // event text on the display
+    void (*countdown)(int seconds);               // once per watering second
+    void (*watering)(int zone);                   // zone started, or -1 once it stopped
+    void (*log)(const char *line);                // console
+    void (*delay_ms)(uint32_t ms);
+    bool (*abort_requested)(void);                // CLI / web "stop"
+    const char *(*stop_rule)(void);               // alert rule asking to stop, or NULL
+    const volatile float *temperature, *humidity;
+    volatile uint32_t *cycles;                    // zones watered, for the maintenance rule
+} irrigation_io_t;
+
+typedef enum {
+    IRR_DONE,           // full water_seconds
+    IRR_ABORTED,        // abort_requested()
+    IRR_ALERT_STOP,     // stop_rule() named a rule
+    IRR_PUMP_FAULT,     // pump_fault()
+} irrigation_end_t;
+
+// soil_task, one reading: fills probes (PROBE_COUNT), signals the soil
+// value and returns the dry mask; *distance is the threshold gap for the
+// sampling rate.
+uint8_t irrigation_soil_pass(const irrigation_params_t *p, const irrigation_io_t *io, uint16_t *probes,
+                             float *distance);
+
+// irrigation_task, one zone: pump on, the countdown with its stop checks,
+// pump off and the pause before the next zone. dry_zones sets the servo.
+irrigation_end_t irrigation_water_zone(const irrigation_params_t *p, const irrigation_io_t *io, int zone,
+                                       uint8_t dry_zones);
+
+#endif // IRRIGATION_CYCLE_H
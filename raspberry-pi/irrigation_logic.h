@@ -0,0 +1,64 @@
+// ---------------- irrigation_logic.h ---------------- //
+/*
+ * Irrigation decisions from soil_task / irrigation_task as pure functions,
+ * so the firmware and the host tuner (tools/irrigation_tuner.c) run the
+ * exact same rules. No hardware or RTOS calls in here.
+ */
+#ifndef IRRIGATION_LOGIC_H
+#define IRRIGATION_LOGIC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define IRR_MAX_ZONES 8
+
+typedef struct {
+    uint8_t zone_count;
+    uint16_t cutoff[IRR_MAX_ZONES];  // zone n is dry while its probe < cutoff[n]
+    uint8_t probe[IRR_MAX_ZONES];    // probe read for zone n (topology ZONE_PROBE)
+    bool dry_above;                  // probes read high when dry: dry while > cutoff
+    float humidity_skip;             // no watering above this humidity (%)
+    uint16_t water_seconds;          // pump time per dry zone
+} irrigation_params_t;
+
+// soil_task: bitmask of zones that need water (bit n = zone n), each
+// zone judged on its own probe. Same result as topology_dry_mask() for
+// params built from the topology, plus the humidity skip.
+static inline uint8_t irrigation_dry_zones(const irrigation_params_t *p, const uint16_t *probes, float humidity) {
+    if (humidity > p->humidity_skip) return 0;
+    uint8_t zones = 0;
+    for (uint8_t z = 0; z < p->zone_count; z++) {
+        uint16_t raw = probes[p->probe[z]];
+        if (p->dry_above ? raw > p->cutoff[z] : raw < p->cutoff[z]) zones |= (uint8_t)(1u << z);
+    }
+    return zones;
+}
+
+// Signed gap from each zone's probe to its cutoff (reading - cutoff),
+// the one nearest zero.
+static inline float irrigation_threshold_distance(const irrigation_params_t *p, const uint16_t *probes) {
+    float best = 1e9f;
+    for (uint8_t z = 0; z < p->zone_count; z++) {
+        float d = (float)probes[p->probe[z]] - p->cutoff[z];
+        if ((d < 0 ? -d : d) < (best < 0 ? -best : best)) best = d;
+    }
+    return best;
+}
+
+// irrigation_task: next zone to water at or after `from`, given the live
+// dry mask; -1 when the cycle is done.
+static inline int irrigation_next_zone(const irrigation_params_t *p, uint8_t dry_zones, int from) {
+    for (int z = from; z < p->zone_count; z++) {
+        if (dry_zones & (1u << z)) return z;
+    }
+    return -1;
+}
+
+// irrigation_task: servo angle shown while watering, from the dry mask.
+static inline float irrigation_servo_angle(uint8_t dry_zones) {
+    if (dry_zones == 0x01) return 45;
+    if (dry_zones == 0x03) return 90;
+    return 135;
+}
+
+#endif // IRRIGATION_LOGIC_H
@@ -0,0 +1,40 @@
+// ---------------- lcd.c ---------------- //
+/*
+ * LCD driver functions (I2C 16x2), moved out of watering_system_main.c.
+ */
+#include "pico/stdlib.h"
+#include "lcd.h"
+
+void lcd_send_cmd(uint8_t cmd) {
+    uint8_t buf[2] = {0x80, cmd};
+    i2c_write_blocking(I2C_PORT, LCD_ADDR, buf, 2, false);
+}
+
+void lcd_send_data(uint8_t data) {
+    uint8_t buf[2] = {0x40, data};
+    i2c_write_blocking(I2C_PORT, LCD_ADDR, buf, 2, false);
+}
+
+void lcd_clear(void) {
+    lcd_send_cmd(0x01);
+    sleep_ms(2);
+}
+
+void lcd_init(void) {
+    sleep_ms(50);
+    lcd_send_cmd(0x38);
+    lcd_send_cmd(0x0C);
+    lcd_send_cmd(0x01);
+    sleep_ms(2);
+}
+
+void lcd_set_cursor(int col, int row) {
+    int row_offsets[] = {0x00, 0x40};
+    lcd_send_cmd(0x80 | (col + row_offsets[row]));
+}
+
+void lcd_print(const char *str) {
+    while (*str) lcd_send_data(*str++);
+}
+
+// End of lcd.c
@@ -0,0 +1,26 @@
+// ---------------- lcd.h ---------------- //
+/*
+ * 16x2 character LCD on I2C (HD44780-compatible, 0x80 command / 0x40
+ * data control bytes), for builds with -DDISPLAY_OLED=0; the default is
+ * the SSD1306 (oled.h). Only HAL calls, so the host benchmarks build it
+ * against tools/hal_sim.
+ */
+#ifndef LCD_H
+#define LCD_H
+
+#include <stdint.h>
+#include "hardware/i2c.h"
+
+// --- I2C for LCD ---
+#define I2C_PORT i2c0
+#define LCD_ADDR 0x27   // common I2C address
+#define LCD_COLS 16
+
+void lcd_send_cmd(uint8_t cmd);
+void lcd_send_data(uint8_t data);
+void lcd_clear(void);
+void lcd_init(void);
+void lcd_set_cursor(int col, int row);
+void lcd_print(const char *str);
+
+#endif // LCD_H
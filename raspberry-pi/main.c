@@ -12,17 +12,14 @@
 #include "hardware/adc.h"
 
 // ---------------- Pin Configuration ---------------- //
-#define THRESHOLD 2000  // Moisture threshold value (0-4095 from ADC)
-
-// Soil moisture sensors (analog pins)
-const uint SENSOR_PINS[2] = {26, 27};  // ADC0 (GP26), ADC1 (GP27)
-
-// Relay control pins (digital output)
-const uint RELAY_PINS[2]  = {2, 3};    // GP2, GP3
+// Probes (GP26/GP27), relays (GP2/GP3) and the 2000 dry threshold live in topology.h
+#ifndef IRRIGATION_SITE
+#define IRRIGATION_SITE SITE_DUAL_ZONE
+#endif
+#include "topology.h"
 
 // ---------------- Function Prototypes ---------------- //
 void init_system();
-uint16_t read_moisture(uint channel);
 void control_sprinkler(uint zone, uint16_t moisture);
 
 // ---------------- Main Program ---------------- //
@@ -30,9 +27,13 @@ int main() {
     stdio_init_all();
     init_system();
 
+    uint16_t probes[PROBE_COUNT];
+
     while (true) {
-        for (int zone = 0; zone < 2; zone++) {
-            uint16_t moisture = read_moisture(zone);
+        topology_read_probes(probes);
+
+        for (int zone = 0; zone < ZONE_COUNT; zone++) {
+            uint16_t moisture = probes[ZONE_PROBE[zone]];
 
             // Print moisture levels for debugging
             printf("Zone %d Moisture: %d\n", zone + 1, moisture);
@@ -49,35 +50,19 @@ int main() {
 
 // Initialize ADC for sensors and GPIO for relays
 void init_system() {
-    // Initialize ADC hardware
-    adc_init();
-    for (int i = 0; i < 2; i++) {
-        adc_gpio_init(SENSOR_PINS[i]);
-    }
-
-    // Initialize relay control pins as outputs
-    for (int i = 0; i < 2; i++) {
-        gpio_init(RELAY_PINS[i]);
-        gpio_set_dir(RELAY_PINS[i], true);
-        gpio_put(RELAY_PINS[i], 0);  // Ensure sprinklers start OFF
-    }
-
-    printf("System Initialized...\n");
-}
+    // ADC for every probe, relays as outputs (sprinklers start OFF)
+    topology_init_io();
 
-// Read moisture level from a specific ADC channel (0 or 1)
-uint16_t read_moisture(uint channel) {
-    adc_select_input(channel);
-    return adc_read();
+    printf("System Initialized (%s, %d zones)...\n", SITE_NAME, ZONE_COUNT);
 }
 
 // Control sprinkler relay for a specific zone
 void control_sprinkler(uint zone, uint16_t moisture) {
-    if (moisture < THRESHOLD) {
-        gpio_put(RELAY_PINS[zone], 1);  // Turn ON sprinkler
+    if (zone_is_dry(moisture, ZONE_DRY_THRESHOLD[zone])) {
+        gpio_put(zone_relay_gpio(zone), 1);  // Turn ON sprinkler
         printf("Zone %d: DRY - Sprinkler ON\n", zone + 1);
     } else {
-        gpio_put(RELAY_PINS[zone], 0);  // Turn OFF sprinkler
+        gpio_put(zone_relay_gpio(zone), 0);  // Turn OFF sprinkler
         printf("Zone %d: WET - Sprinkler OFF\n", zone + 1);
     }
 }
\ No newline at end of file
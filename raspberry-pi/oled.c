@@ -0,0 +1,226 @@
+// ---------------- oled.c ---------------- //
+/*
+ * SSD1306 128x64 OLED driver: framebuffer, glyphs, sparklines and
+ * page-diff flushes (see oled.h).
+ */
+#include <string.h>
+#include "pico/stdlib.h"
+#include "oled.h"
+
+#define WINDOW_BYTES 13     // column/page window commands + data control byte
+#define TX_MAX (OLED_PAGES / 2 * WINDOW_BYTES + OLED_PAGES * OLED_WIDTH)
+
+// 5x7 glyphs for ASCII 32-126, one byte per column, bit 0 at the top
+static const uint8_t font[95][5] = {
+    {0x00,0x00,0x00,0x00,0x00}, {0x00,0x00,0x5F,0x00,0x00}, {0x00,0x07,0x00,0x07,0x00}, // ' ' ! "
+    {0x14,0x7F,0x14,0x7F,0x14}, {0x24,0x2A,0x7F,0x2A,0x12}, {0x23,0x13,0x08,0x64,0x62}, // # $ %
+    {0x36,0x49,0x55,0x22,0x50}, {0x00,0x05,0x03,0x00,0x00}, {0x00,0x1C,0x22,0x41,0x00}, // & ' (
+    {0x00,0x41,0x22,0x1C,0x00}, {0x08,0x2A,0x1C,0x2A,0x08}, {0x08,0x08,0x3E,0x08,0x08}, // ) * +
+    {0x00,0x50,0x30,0x00,0x00}, {0x08,0x08,0x08,0x08,0x08}, {0x00,0x60,0x60,0x00,0x00}, // , - .
+    {0x20,0x10,0x08,0x04,0x02}, {0x3E,0x51,0x49,0x45,0x3E}, {0x00,0x42,0x7F,0x40,0x00}, // / 0 1
+    {0x42,0x61,0x51,0x49,0x46}, {0x21,0x41,0x45,0x4B,0x31}, {0x18,0x14,0x12,0x7F,0x10}, // 2 3 4
+    {0x27,0x45,0x45,0x45,0x39}, {0x3C,0x4A,0x49,0x49,0x30}, {0x01,0x71,0x09,0x05,0x03}, // 5 6 7
+    {0x36,0x49,0x49,0x49,0x36}, {0x06,0x49,0x49,0x29,0x1E}, {0x00,0x36,0x36,0x00,0x00}, // 8 9 :
+    {0x00,0x56,0x36,0x00,0x00}, {0x08,0x14,0x22,0x41,0x00}, {0x14,0x14,0x14,0x14,0x14}, // ; < =
+    {0x00,0x41,0x22,0x14,0x08}, {0x02,0x01,0x51,0x09,0x06}, {0x32,0x49,0x79,0x41,0x3E}, // > ? @
+    {0x7E,0x11,0x11,0x11,0x7E}, {0x7F,0x49,0x49,0x49,0x36}, {0x3E,0x41,0x41,0x41,0x22}, // A B C
+    {0x7F,0x41,0x41,0x22,0x1C}, {0x7F,0x49,0x49,0x49,0x41}, {0x7F,0x09,0x09,0x09,0x01}, // D E F
+    {0x3E,0x41,0x49,0x49,0x7A}, {0x7F,0x08,0x08,0x08,0x7F}, {0x00,0x41,0x7F,0x41,0x00}, // G H I
+    {0x20,0x40,0x41,0x3F,0x01}, {0x7F,0x08,0x14,0x22,0x41}, {0x7F,0x40,0x40,0x40,0x40}, // J K L
+    {0x7F,0x02,0x0C,0x02,0x7F}, {0x7F,0x04,0x08,0x10,0x7F}, {0x3E,0x41,0x41,0x41,0x3E}, // M N O
+    {0x7F,0x09,0x09,0x09,0x06}, {0x3E,0x41,0x51,0x21,0x5E}, {0x7F,0x09,0x19,0x29,0x46}, // P Q R
+    {0x46,0x49,0x49,0x49,0x31}, {0x01,0x01,0x7F,0x01,0x01}, {0x3F,0x40,0x40,0x40,0x3F}, // S T U
+    {0x1F,0x20,0x40,0x20,0x1F}, {0x3F,0x40,0x38,0x40,0x3F}, {0x63,0x14,0x08,0x14,0x63}, // V W X
+    {0x07,0x08,0x70,0x08,0x07}, {0x61,0x51,0x49,0x45,0x43}, {0x00,0x7F,0x41,0x41,0x00}, // Y Z [
+    {0x02,0x04,0x08,0x10,0x20}, {0x00,0x41,0x41,0x7F,0x00}, {0x04,0x02,0x01,0x02,0x04}, // \ ] ^
+    {0x40,0x40,0x40,0x40,0x40}, {0x00,0x01,0x02,0x04,0x00}, {0x20,0x54,0x54,0x54,0x78}, // _ ` a
+    {0x7F,0x48,0x44,0x44,0x38}, {0x38,0x44,0x44,0x44,0x20}, {0x38,0x44,0x44,0x48,0x7F}, // b c d
+    {0x38,0x54,0x54,0x54,0x18}, {0x08,0x7E,0x09,0x01,0x02}, {0x0C,0x52,0x52,0x52,0x3E}, // e f g
+    {0x7F,0x08,0x04,0x04,0x78}, {0x00,0x44,0x7D,0x40,0x00}, {0x20,0x40,0x44,0x3D,0x00}, // h i j
+    {0x7F,0x10,0x28,0x44,0x00}, {0x00,0x41,0x7F,0x40,0x00}, {0x7C,0x04,0x18,0x04,0x78}, // k l m
+    {0x7C,0x08,0x04,0x04,0x78}, {0x38,0x44,0x44,0x44,0x38}, {0x7C,0x14,0x14,0x14,0x08}, // n o p
+    {0x08,0x14,0x14,0x18,0x7C}, {0x7C,0x08,0x04,0x04,0x08}, {0x48,0x54,0x54,0x54,0x20}, // q r s
+    {0x04,0x3F,0x44,0x40,0x20}, {0x3C,0x40,0x40,0x20,0x7C}, {0x1C,0x20,0x40,0x20,0x1C}, // t u v
+    {0x3C,0x40,0x30,0x40,0x3C}, {0x44,0x28,0x10,0x28,0x44}, {0x0C,0x50,0x50,0x50,0x3C}, // w x y
+    {0x44,0x64,0x54,0x4C,0x44}, {0x00,0x08,0x36,0x41,0x00}, {0x00,0x00,0x7F,0x00,0x00}, // z { |
+    {0x00,0x41,0x36,0x08,0x00}, {0x08,0x04,0x08,0x10,0x08},                              // } ~
+};
+
+static uint8_t fb[OLED_PAGES][OLED_WIDTH];
+static uint8_t dirty;
+
+#if PICO_ON_DEVICE
+#include "hardware/dma.h"
+
+typedef uint16_t tx_t;      // IC_DATA_CMD words: the byte plus RESTART / STOP
+static int dma_chan = -1;
+#else
+typedef uint8_t tx_t;
+#endif
+static tx_t tx[TX_MAX];
+
+static inline void put(int page, int x, uint8_t b) {
+    if (fb[page][x] != b) {
+        fb[page][x] = b;
+        dirty |= (uint8_t)(1u << page);
+    }
+}
+
+void oled_init(void) {
+    static const uint8_t init_cmds[] = {
+        0x00,               // control byte: commands follow
+        0xAE,               // display off
+        0xD5, 0x80,         // clock divide / oscillator
+        0xA8, 0x3F,         // multiplex: 64 rows
+        0xD3, 0x00,         // no display offset
+        0x40,               // start line 0
+        0x8D, 0x14,         // internal charge pump on
+        0x20, 0x00,         // horizontal addressing: pages follow each other
+        0xA1, 0xC8,         // column 0 at the left, page 0 at the top
+        0xDA, 0x12,         // COM pins for 128x64
+        0x81, 0xCF,         // contrast
+        0xD9, 0xF1,         // pre-charge
+        0xDB, 0x40,         // VCOMH
+        0xA4, 0xA6,         // show RAM, not inverted
+        0xAF,               // display on
+    };
+    sleep_ms(100);
+    i2c_write_blocking(I2C_PORT, OLED_ADDR, init_cmds, sizeof(init_cmds), false);
+    memset(fb, 0, sizeof(fb));
+    dirty = 0xFF;           // panel RAM is random after power-up
+
+#if PICO_ON_DEVICE
+    // The blocking write above left the bus target at OLED_ADDR; nothing
+    // else is on this bus, so flushes only feed IC_DATA_CMD
+    if (dma_chan < 0) {
+        dma_chan = dma_claim_unused_channel(true);
+        dma_channel_config c = dma_channel_get_default_config(dma_chan);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+        channel_config_set_read_increment(&c, true);
+        channel_config_set_write_increment(&c, false);
+        channel_config_set_dreq(&c, i2c_get_dreq(I2C_PORT, true));
+        dma_channel_configure(dma_chan, &c, &i2c_get_hw(I2C_PORT)->data_cmd, tx, 0, false);
+    }
+#endif
+}
+
+// One run of pages: set the column and page window, then the page bytes
+static int put_run(int n, int first, int last) {
+    const tx_t window[WINDOW_BYTES] = {
+        0x80, 0x21, 0x80, 0, 0x80, OLED_WIDTH - 1,
+        0x80, 0x22, 0x80, (tx_t)first, 0x80, (tx_t)last,
+        0x40,               // control byte: data to the end of the transfer
+    };
+    memcpy(&tx[n], window, sizeof(window));
+    n += WINDOW_BYTES;
+    const uint8_t *src = fb[first];
+    for (int i = 0; i < (last - first + 1) * OLED_WIDTH; i++) tx[n++] = src[i];
+    return n;
+}
+
+void oled_flush(void) {
+    if (!dirty) return;
+#if PICO_ON_DEVICE
+    dma_channel_wait_for_finish_blocking(dma_chan);     // the last frame still reads tx
+#endif
+    int n = 0;
+    for (int p = 0; p < OLED_PAGES; p++) {
+        if (!(dirty & (1u << p))) continue;
+        int last = p;
+        while (last + 1 < OLED_PAGES && (dirty & (1u << (last + 1)))) last++;
+        int start = n;
+        n = put_run(n, p, last);
+#if PICO_ON_DEVICE
+        if (start) tx[start] |= I2C_IC_DATA_CMD_RESTART_BITS;
+#else
+        bool more = (dirty >> (last + 1)) != 0;
+        i2c_write_blocking(I2C_PORT, OLED_ADDR, &tx[start], (size_t)(n - start), more);
+#endif
+        p = last;
+    }
+#if PICO_ON_DEVICE
+    tx[n - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+    dma_channel_transfer_from_buffer_now(dma_chan, tx, (uint32_t)n);
+#endif
+    dirty = 0;
+}
+
+void oled_clear(void) {
+    for (int p = 0; p < OLED_PAGES; p++) oled_fill(0, p, OLED_WIDTH, 0);
+}
+
+void oled_pixel(int x, int y, bool on) {
+    if (x < 0 || x >= OLED_WIDTH || y < 0 || y >= OLED_HEIGHT) return;
+    uint8_t bit = (uint8_t)(1u << (y & 7));
+    uint8_t b = fb[y >> 3][x];
+    put(y >> 3, x, on ? (uint8_t)(b | bit) : (uint8_t)(b & ~bit));
+}
+
+void oled_fill(int x, int page, int w, uint8_t bits) {
+    if (page < 0 || page >= OLED_PAGES || x < 0) return;
+    for (int i = x; i < x + w && i < OLED_WIDTH; i++) put(page, i, bits);
+}
+
+int oled_text(int x, int page, const char *str, bool invert) {
+    if (page < 0 || page >= OLED_PAGES || x < 0) return x;
+    uint8_t inv = invert ? 0xFF : 0x00;
+    for (; *str && x + OLED_GLYPH_W <= OLED_WIDTH; str++) {
+        unsigned c = (unsigned char)*str;
+        const uint8_t *g = font[(c < 32 || c > 126 ? '?' : c) - 32];
+        for (int i = 0; i < 5; i++) put(page, x + i, g[i] ^ inv);
+        put(page, x + 5, inv);
+        x += OLED_GLYPH_W;
+    }
+    return x;
+}
+
+// Replaces the `box` rows of column x with `bits`, one page byte at a time
+static void put_column(int x, uint64_t box, uint64_t bits) {
+    for (int p = 0; p < OLED_PAGES; p++) {
+        uint8_t m = (uint8_t)(box >> (p * 8));
+        if (m) put(p, x, (uint8_t)((fb[p][x] & ~m) | ((uint8_t)(bits >> (p * 8)) & m)));
+    }
+}
+
+static int value_y(int y, int h, uint8_t v, uint8_t vmax) {
+    if (v > vmax) v = vmax;
+    return y + (h - 1) - (v * (h - 1) + vmax / 2) / vmax;
+}
+
+void oled_sparkline(int x, int y, int w, int h, const uint8_t *v, int n, uint8_t vmax, int mark) {
+    if (x < 0 || y < 0 || w <= 0 || h <= 0 || x + w > OLED_WIDTH || y + h > OLED_HEIGHT || vmax == 0) return;
+    if (n > w) {
+        v += n - w;
+        n = w;
+    }
+    uint64_t box = (h == 64 ? ~0ull : (1ull << h) - 1) << y;
+    int mark_y = mark >= 0 ? value_y(y, h, (uint8_t)(mark > vmax ? vmax : mark), vmax) : -1;
+    int prev = -1;
+    for (int col = 0; col < w; col++) {
+        uint64_t bits = 0;
+        int i = col - (w - n);
+        if (i >= 0) {
+            // Each point joins the previous one with a vertical span
+            int py = value_y(y, h, v[i], vmax);
+            int lo = prev < 0 || py < prev ? py : prev, hi = prev > py ? prev : py;
+            bits = (hi == 63 ? ~0ull : (2ull << hi) - 1) & ~((1ull << lo) - 1);
+            prev = py;
+        }
+        if (mark_y >= 0 && col % 3 == 0) bits |= 1ull << mark_y;
+        put_column(x + col, box, bits);
+    }
+}
+
+const uint8_t *oled_framebuffer(void) {
+    return &fb[0][0];
+}
+
+uint8_t oled_dirty_pages(void) {
+    return dirty;
+}
+
+uint32_t oled_ram_bytes(void) {
+    return sizeof(fb) + sizeof(tx);
+}
+
+// End of oled.c
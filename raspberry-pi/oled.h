@@ -0,0 +1,57 @@
+// ---------------- oled.h ---------------- //
+/*
+ * 128x64 SSD1306 OLED on I2C, drawn into a 1 KB framebuffer.
+ *
+ * The framebuffer is laid out like the panel's RAM: 8 pages of 128
+ * column bytes, bit 0 at the top of each page. Drawing only marks a page
+ * dirty when a byte really changes, so a screen that is redrawn in full
+ * every time still sends only the pages that look different.
+ *
+ * oled_flush() sends the dirty pages in one transfer. Each contiguous run
+ * of pages gets its own column/page window, and the runs are joined with
+ * repeated STARTs (the SSD1306 cannot go back to commands inside a data
+ * write). On the Pico the transfer goes out by DMA and oled_flush()
+ * returns while it runs. Elsewhere (tools/hal_sim) it is one
+ * i2c_write_blocking() per run, and hal_sim.i2c_tap sees the same bytes
+ * the panel would.
+ */
+#ifndef OLED_H
+#define OLED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/i2c.h"
+
+#ifndef DISPLAY_OLED
+#define DISPLAY_OLED 1      // 0: the 16x2 character LCD (lcd.h) instead
+#endif
+
+// --- I2C for the OLED (same bus as the LCD) ---
+#define I2C_PORT i2c0
+#define OLED_ADDR 0x3C
+#define OLED_I2C_HZ (400 * 1000)
+
+#define OLED_WIDTH  128
+#define OLED_HEIGHT 64
+#define OLED_PAGES  (OLED_HEIGHT / 8)
+#define OLED_GLYPH_W 6      // 5x7 font plus one blank column
+#define OLED_COLS   (OLED_WIDTH / OLED_GLYPH_W)
+
+void oled_init(void);                   // panel setup; everything dirty
+void oled_flush(void);                  // send the dirty pages
+void oled_clear(void);
+
+void oled_pixel(int x, int y, bool on);
+// Text on a page row; returns the x after the last glyph.
+int oled_text(int x, int page, const char *str, bool invert);
+// Sets w columns of one page to `bits`.
+void oled_fill(int x, int page, int w, uint8_t bits);
+// Line graph of n values (oldest first, 0..vmax) in a w x h box, newest at
+// the right edge; mark >= 0 adds a dotted reference line at that value.
+void oled_sparkline(int x, int y, int w, int h, const uint8_t *v, int n, uint8_t vmax, int mark);
+
+const uint8_t *oled_framebuffer(void);  // OLED_PAGES x OLED_WIDTH
+uint8_t oled_dirty_pages(void);         // bit n = page n changed since the last flush
+uint32_t oled_ram_bytes(void);
+
+#endif // OLED_H
@@ -0,0 +1,293 @@
+// ---------------- pump_drive.c ---------------- //
+/*
+ * Pump current monitor and PWM motor drive (see pump_drive.h).
+ */
+#include <string.h>
+#include "pump_drive.h"
+
+static const char *state_names[] = {"off", "running", "dry run", "stall"};
+
+const char *pump_state_name(uint8_t state) {
+    return state < 4 ? state_names[state] : "?";
+}
+
+uint16_t pump_ramp_permille(const pump_cfg_t *cfg, uint32_t ms) {
+    if (ms >= cfg->ramp_ms) return 1000;
+    return (uint16_t)(cfg->start_permille + (1000u - cfg->start_permille) * ms / cfg->ramp_ms);
+}
+
+// ---------------- Monitor ---------------- //
+void pump_mon_start(pump_mon_t *m, const pump_cfg_t *cfg) {
+    memset(m, 0, sizeof(*m));
+    m->cfg = cfg;
+    m->state = PUMP_RUNNING;
+}
+
+uint8_t pump_mon_block(pump_mon_t *m, const uint16_t *samples, int n, int stride) {
+    if (m->state == PUMP_OFF || m->frozen || n <= 0) return m->state;
+    const pump_cfg_t *c = m->cfg;
+
+    uint32_t sum = 0;
+    for (int i = 0; i < n; i++) sum += samples[i * stride];
+    uint16_t ma = (uint16_t)((float)sum / n * c->ma_per_count);
+    m->trace[m->trace_pos] = ma;
+    m->trace_pos = (uint16_t)((m->trace_pos + 1) % PUMP_TRACE_LEN);
+    if (m->trace_count < PUMP_TRACE_LEN) m->trace_count++;
+    if (ma > m->peak_ma) m->peak_ma = ma;
+    m->ms++;
+
+    // After a trip: keep recording long enough to show the current falling
+    if (m->state != PUMP_RUNNING) {
+        if (++m->post_ms >= PUMP_TRACE_POST) m->frozen = true;
+        return m->state;
+    }
+
+    // Stall: too much current once the rotor should be turning. During
+    // the ramp a locked rotor draws only duty * its full-on current, so the
+    // threshold follows the duty. Every start draws locked-rotor current
+    // for its first ms, so while spinning up the ceiling sits just under
+    // that and only a rotor that never pulls its current down trips.
+    // Dry run: too little once the ramp has finished and settled.
+    bool inrush = m->ms <= c->inrush_ms;
+    uint32_t stall_ma = (uint32_t)(inrush ? c->inrush_ma : c->stall_ma) * pump_ramp_permille(c, m->ms - 1) / 1000;
+    bool over = ma >= stall_ma;
+    bool under = m->ms > (uint32_t)c->ramp_ms + c->settle_ms && ma < c->dry_ma;
+    m->over_ms = over ? m->over_ms + 1 : 0;
+    m->under_ms = under ? m->under_ms + 1 : 0;
+    if (m->over_ms >= (inrush ? c->inrush_stall_ms : c->stall_ms)) m->state = PUMP_FAULT_STALL;
+    else if (m->under_ms >= c->dry_ms) m->state = PUMP_FAULT_DRY;
+    if (m->state != PUMP_RUNNING) m->trip_ms = m->ms;
+    return m->state;
+}
+
+int pump_mon_trace(const pump_mon_t *m, uint16_t *out) {
+    int first = (m->trace_pos + PUMP_TRACE_LEN - m->trace_count) % PUMP_TRACE_LEN;
+    for (int i = 0; i < m->trace_count; i++) out[i] = m->trace[(first + i) % PUMP_TRACE_LEN];
+    return m->trace_count;
+}
+
+// ---------------- Device drive ---------------- //
+#if PICO_ON_DEVICE
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/pwm.h"
+
+#define BLOCK_SAMPLES   (PUMP_PWM_HZ / 1000)     // 1 ms: current and probe alternating
+#define BLOCK_BYTES     (BLOCK_SAMPLES * 2)
+#define BLOCK_RING_BITS 6
+#define TRIG_COUNT      0x0FFFFFFFu              // conversions per start (~2.3 h)
+
+_Static_assert(BLOCK_BYTES == 1 << BLOCK_RING_BITS, "a block must be one DMA write ring");
+
+static const pump_cfg_t *cfg;
+static uint sense_in, probe_in;
+static uint pump_gpio, slice, channel;
+static uint16_t top;
+static int trig_chan = -1, rd_chan[2] = {-1, -1};
+
+// Each reader wraps inside its own block, so a late IRQ (flash erase)
+// loses samples instead of writing past the buffer.
+static uint16_t blocks[2][BLOCK_SAMPLES] __attribute__((aligned(BLOCK_BYTES)));
+static uint32_t adc_start_word = ADC_CS_START_ONCE_BITS;    // in RAM: read by DMA while flash may be busy
+
+static pump_mon_t mon;
+static volatile bool running, latched, probe_valid;
+static volatile uint16_t probe_raw;
+
+static void set_duty(uint16_t permille) {
+    pwm_set_chan_level(slice, channel, (uint16_t)((top + 1u) * permille / 1000u));
+}
+
+// No more conversions or blocks; the FIFO is left for the next start to drain
+static void halt_sampling(void) {
+    dma_channel_abort(trig_chan);
+    for (int i = 0; i < 2; i++) {
+        dma_channel_set_irq1_enabled(rd_chan[i], false);
+        dma_channel_abort(rd_chan[i]);
+        dma_channel_acknowledge_irq1(rd_chan[i]);
+    }
+}
+
+static void on_block(const uint16_t *b) {
+    uint32_t soil = 0;
+    for (int i = 1; i < BLOCK_SAMPLES; i += 2) soil += b[i];
+    probe_raw = (uint16_t)(soil / (BLOCK_SAMPLES / 2));
+    probe_valid = true;
+
+    uint8_t st = pump_mon_block(&mon, b, BLOCK_SAMPLES / 2, 2);
+    if (st == PUMP_RUNNING) {
+        if (mon.ms <= cfg->ramp_ms) set_duty(pump_ramp_permille(cfg, mon.ms));
+        return;
+    }
+    set_duty(0);            // latched at the next PWM wrap, within 32 us
+    latched = true;
+    if (mon.frozen) {
+        probe_valid = false;
+        halt_sampling();
+    }
+}
+
+static void pump_dma_irq(void) {
+    for (int i = 0; i < 2; i++) {
+        if (rd_chan[i] < 0 || !dma_channel_get_irq1_status(rd_chan[i])) continue;
+        dma_channel_acknowledge_irq1(rd_chan[i]);
+        on_block(blocks[i]);
+    }
+}
+
+void pump_drive_init(const pump_cfg_t *c, uint sense_input, uint probe_input) {
+    cfg = c;
+    sense_in = sense_input;
+    probe_in = probe_input;
+    adc_gpio_init(26 + sense_input);
+
+    trig_chan = dma_claim_unused_channel(true);
+    for (int i = 0; i < 2; i++) rd_chan[i] = dma_claim_unused_channel(true);
+    for (int i = 0; i < 2; i++) {
+        dma_channel_config dc = dma_channel_get_default_config(rd_chan[i]);
+        channel_config_set_transfer_data_size(&dc, DMA_SIZE_16);
+        channel_config_set_read_increment(&dc, false);
+        channel_config_set_write_increment(&dc, true);
+        channel_config_set_ring(&dc, true, BLOCK_RING_BITS);
+        channel_config_set_dreq(&dc, DREQ_ADC);
+        channel_config_set_chain_to(&dc, rd_chan[i ^ 1]);
+        dma_channel_configure(rd_chan[i], &dc, blocks[i], &adc_hw->fifo, BLOCK_SAMPLES, false);
+    }
+    irq_add_shared_handler(DMA_IRQ_1, pump_dma_irq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+}
+
+bool pump_drive_start(uint gpio) {
+    if (latched) return false;
+    if (running) return true;
+    pump_gpio = gpio;
+    slice = pwm_gpio_to_slice_num(gpio);
+    channel = pwm_gpio_to_channel(gpio);
+
+    // Phase-correct: the wrap (counter at 0) is the middle of the on-pulse
+    pwm_config pc = pwm_get_default_config();
+    pwm_config_set_phase_correct(&pc, true);
+    pwm_config_set_clkdiv_int(&pc, 1);
+    top = (uint16_t)(clock_get_hz(clk_sys) / (2 * PUMP_PWM_HZ) - 1);
+    pwm_config_set_wrap(&pc, top);
+    pwm_init(slice, &pc, false);
+    set_duty(cfg->start_permille);
+    gpio_set_function(gpio, GPIO_FUNC_PWM);
+
+    pump_mon_start(&mon, cfg);
+    probe_valid = false;
+
+    // ADC alternates current / probe, starting with the current, into the FIFO
+    adc_run(false);
+    adc_select_input(sense_in);
+    adc_set_round_robin((1u << sense_in) | (1u << probe_in));
+    adc_fifo_setup(true, true, 1, false, false);
+    adc_fifo_drain();
+
+    for (int i = 0; i < 2; i++) {
+        dma_channel_set_write_addr(rd_chan[i], blocks[i], false);
+        dma_channel_set_trans_count(rd_chan[i], BLOCK_SAMPLES, false);
+        dma_channel_acknowledge_irq1(rd_chan[i]);
+        dma_channel_set_irq1_enabled(rd_chan[i], true);
+    }
+    dma_channel_start(rd_chan[0]);
+
+    // One START_ONCE per PWM wrap, through the set alias so AINSEL/RROBIN stay
+    dma_channel_config tc = dma_channel_get_default_config(trig_chan);
+    channel_config_set_transfer_data_size(&tc, DMA_SIZE_32);
+    channel_config_set_read_increment(&tc, false);
+    channel_config_set_write_increment(&tc, false);
+    channel_config_set_dreq(&tc, DREQ_PWM_WRAP0 + slice);
+    dma_channel_configure(trig_chan, &tc, &hw_set_alias(adc_hw)->cs, &adc_start_word, TRIG_COUNT, true);
+
+    running = true;
+    pwm_set_enabled(slice, true);
+    return true;
+}
+
+void pump_drive_stop(void) {
+    if (!running) return;
+    set_duty(0);
+    halt_sampling();
+    pwm_set_enabled(slice, false);
+    gpio_init(pump_gpio);
+    gpio_set_dir(pump_gpio, GPIO_OUT);
+    gpio_put(pump_gpio, 0);
+
+    // Hand the ADC back to plain adc_read()
+    adc_set_round_robin(0);
+    adc_fifo_setup(false, false, 1, false, false);
+    adc_fifo_drain();
+    probe_valid = false;
+    running = false;
+}
+
+uint8_t pump_drive_state(void) {
+    if (latched) return mon.state;
+    return running ? PUMP_RUNNING : PUMP_OFF;
+}
+
+void pump_drive_clear(void) {
+    latched = false;
+}
+
+bool pump_drive_probe(uint16_t *raw) {
+    if (!running || !probe_valid) return false;
+    *raw = probe_raw;
+    return true;
+}
+
+void pump_drive_report(void) {
+    static uint16_t wave[PUMP_TRACE_LEN];
+    printf("\n--- Pump ---\n");
+    printf("Drive: PWM %u kHz, soft start %u%% -> 100%% in %u ms\n", PUMP_PWM_HZ / 1000,
+           cfg->start_permille / 10, cfg->ramp_ms);
+    printf("Cutoff: stall >= %u mA for %u ms (%u mA for %u ms in the first %u ms), dry < %u mA for %u ms\n",
+           cfg->stall_ma, cfg->stall_ms, cfg->inrush_ma, cfg->inrush_stall_ms, cfg->inrush_ms, cfg->dry_ma,
+           cfg->dry_ms);
+    if (mon.ms == 0) {
+        printf("No run yet\n");
+        printf("--------------------\n");
+        return;
+    }
+    if (latched) {
+        printf("State: FAULT (%s) after %lu ms, locked out until \"pump reset\"\n",
+               pump_state_name(mon.state), (unsigned long)mon.trip_ms);
+    } else {
+        printf("State: %s\n", running ? "running" : "stopped");
+    }
+    printf("Last run: %lu ms, peak %u mA\n", (unsigned long)mon.ms, mon.peak_ma);
+
+    // Waveform, 16 points a line; the trip point is marked
+    int n = pump_mon_trace(&mon, wave);
+    int trip = mon.state >= PUMP_FAULT_DRY ? n - 1 - mon.post_ms : -1;
+    printf("Current, mA per ms (last %d ms):\n", n);
+    for (int i = 0; i < n; i++) {
+        printf("%5u%c", wave[i], i == trip ? '*' : ' ');
+        if (i % 16 == 15 || i == n - 1) printf("\n");
+    }
+    printf("--------------------\n");
+}
+
+// Called with interrupts off on both cores, so on_block cannot run meanwhile
+void pump_drive_flash_hold(bool hold) {
+    if (!running || latched) return;
+    if (hold) {
+        set_duty(0);
+        return;
+    }
+    // The rotor has coasted down: start the ramp and the monitor over
+    pump_mon_start(&mon, cfg);
+    set_duty(cfg->start_permille);
+}
+
+uint32_t pump_drive_ram_bytes(void) {
+    return sizeof(mon) + sizeof(blocks);
+}
+#endif
+
+// End of pump_drive.c
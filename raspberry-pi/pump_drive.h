@@ -0,0 +1,101 @@
+// ---------------- pump_drive.h ---------------- //
+/*
+ * Motor drive for the pump, for boards with a logic-level MOSFET on the
+ * relay GPIO and a low-side shunt amplifier on PUMP_SENSE_PIN (build with
+ * -DPUMP_MOTOR_DRIVE=1; the default build keeps the on/off relay).
+ *
+ *   - Soft start: PWM duty ramps from start_permille to full over ramp_ms.
+ *   - Current sensing: the PWM runs phase-correct, so its wrap (counter
+ *     back at 0) is the middle of every on-pulse. The wrap paces a DMA
+ *     channel that starts one ADC conversion, so the current is always
+ *     read at the same point of the period. The ADC round-robins between
+ *     the current and the soil probe, and soil_task keeps its readings
+ *     while the pump owns the ADC.
+ *   - Cutoff: two chained DMA channels drain the FIFO in 1 ms blocks. The
+ *     block IRQ steps the ramp and runs the monitor below. On a dry-run or
+ *     stall signature it sets the duty to 0 right there, dry_ms / stall_ms
+ *     plus about 1 ms after the signature starts.
+ *   - Fault log: the monitor keeps the last PUMP_TRACE_LEN ms of current,
+ *     including PUMP_TRACE_POST ms after the trip, for pump_drive_report().
+ *
+ * The monitor (pump_mon_*) has no hardware calls; tools/pump_sim.c replays
+ * simulated starts, dry runs and jams through it.
+ */
+#ifndef PUMP_DRIVE_H
+#define PUMP_DRIVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef PUMP_MOTOR_DRIVE
+#define PUMP_MOTOR_DRIVE 0      // 1: PWM + current sensing instead of the relay
+#endif
+
+#define PUMP_PWM_HZ     32000   // one conversion per period: 32 per ms
+#define PUMP_TRACE_LEN  256     // 1 ms points kept for the fault log
+#define PUMP_TRACE_POST 16      // points recorded after a trip
+
+enum {
+    PUMP_OFF = 0,
+    PUMP_RUNNING,
+    PUMP_FAULT_DRY,     // current stayed under dry_ma after the ramp
+    PUMP_FAULT_STALL,   // current stayed at or over stall_ma
+};
+
+typedef struct {
+    uint16_t start_permille;    // duty at switch-on
+    uint16_t ramp_ms;           // to full duty
+    uint16_t inrush_ms;         // spin-up, when stall is judged by inrush_ma / inrush_stall_ms
+    uint16_t settle_ms;         // after the ramp, before dry checks start
+    float ma_per_count;         // shunt amplifier scale
+    uint16_t stall_ma, stall_ms;    // stall_ma at full duty, scaled down during the ramp
+    uint16_t inrush_ma, inrush_stall_ms;    // just under locked-rotor current, scaled like stall_ma
+    uint16_t dry_ma, dry_ms;
+} pump_cfg_t;
+
+typedef struct {
+    const pump_cfg_t *cfg;
+    uint8_t state;
+    bool frozen;                // trace complete after a trip
+    uint32_t ms;                // since pump_mon_start()
+    uint32_t trip_ms;           // when the state left RUNNING
+    uint16_t over_ms, under_ms; // consecutive ms inside a signature
+    uint16_t post_ms;
+    uint16_t peak_ma;
+    uint16_t trace[PUMP_TRACE_LEN];
+    uint16_t trace_pos, trace_count;
+} pump_mon_t;
+
+void pump_mon_start(pump_mon_t *m, const pump_cfg_t *cfg);
+// One millisecond of raw ADC current samples (every `stride`-th of n);
+// returns the state. Stops recording PUMP_TRACE_POST ms after a trip.
+uint8_t pump_mon_block(pump_mon_t *m, const uint16_t *samples, int n, int stride);
+// Copies the trace oldest first; returns the number of points.
+int pump_mon_trace(const pump_mon_t *m, uint16_t *out);
+// Soft-start duty (0-1000) at `ms` after switch-on.
+uint16_t pump_ramp_permille(const pump_cfg_t *cfg, uint32_t ms);
+const char *pump_state_name(uint8_t state);
+
+#if PICO_ON_DEVICE
+#include "pico/types.h"
+
+void pump_drive_init(const pump_cfg_t *cfg, uint sense_input, uint probe_input);
+// Starts the ramp on `gpio` and returns; false while a fault is latched.
+bool pump_drive_start(uint gpio);
+void pump_drive_stop(void);
+uint8_t pump_drive_state(void);
+void pump_drive_clear(void);            // CLI "pump reset": unlatch a fault
+// Latest soil probe reading while the pump owns the ADC; false when stopped.
+bool pump_drive_probe(uint16_t *raw);
+void pump_drive_report(void);           // CLI "pump": last run and its waveform
+uint32_t pump_drive_ram_bytes(void);
+// flash_safe_execute runs with interrupts off on both cores, so no block
+// IRQ can cut a stall or dry run during an erase. Every flash op callback
+// calls this with true before it touches flash and false after: the pump
+// is off for the op and soft-starts again, inrush checks included.
+void pump_drive_flash_hold(bool hold);
+#else
+static inline void pump_drive_flash_hold(bool hold) { (void)hold; }
+#endif
+
+#endif // PUMP_DRIVE_H
@@ -12,6 +12,7 @@ Second year computer science students at eduvos
 #include "pico/stdlib.h"
 #include "hardware/adc.h"
 #include "hardware/dma.h"
+#include "soil_sensor.h"
 
 #define SOIL_MOISTURE_PIN 26
 #define BUFFER_SIZE 10
@@ -58,16 +59,9 @@ float soil_moisture_read() {
     dma_channel_wait_for_finish_blocking(dma_chan);
     adc_run(false);
 
-    // Average buffer
-    uint32_t sum = 0;
-    for (int i = 0; i < BUFFER_SIZE; i++) {
-        sum += adc_buffer[i];
-    }
-    uint16_t avg_adc = sum / BUFFER_SIZE;
-
-    // Convert ADC → moisture percentage
-    float soil_moisture = (avg_adc / 4095.0f) * 100.0f;
-    return soil_moisture;
+    // Average buffer, then convert ADC → moisture percentage
+    uint16_t avg_adc = soil_adc_average(adc_buffer, BUFFER_SIZE);
+    return soil_adc_percent(avg_adc);
 }
 
 // End of soil_moisture.c
\ No newline at end of file
@@ -12,26 +12,13 @@ Second year computer science students at eduvos
 #include "hardware/adc.h"
 #include "hardware/gpio.h"
 #include "hardware/timer.h"
+#include "soil_sensor.h"   // calculate_soil_moisture() and the dry/wet calibration
 
 #define SOIL_MOISTURE_PIN 26 // GPIO pin connected to the soil moisture sensor
-#define ADC_MAX_VALUE 4095.0 // Maximum value for 12-bit ADC
 #define VREF 3.3 // Reference voltage for ADC
-#define CALIBRATION_DRY 3000 // ADC value for dry soil (calibration)
-#define CALIBRATION_WET 1000 // ADC value for wet soil (calibration)
 #define MEASUREMENT_INTERVAL_MS 5000 // Measurement interval in milliseconds
 #define LED_PIN 25 // On-board LED pin
 
-float calculate_soil_moisture(int adc_value) {
-    // Simple linear interpolation between dry and wet calibration values
-    if (adc_value >= CALIBRATION_DRY) {
-        return 0.0; // 0% moisture
-    } else if (adc_value <= CALIBRATION_WET) {
-        return 100.0; // 100% moisture
-    } else {
-        return ((CALIBRATION_DRY - adc_value) / (CALIBRATION_DRY - CALIBRATION_WET)) * 100.0;
-    }
-}
-
 void setup() {
     stdio_init_all();
     adc_init();
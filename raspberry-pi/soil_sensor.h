@@ -0,0 +1,35 @@
+// ---------------- soil_sensor.h ---------------- //
+/*
+ * Soil probe conversions shared by soil_moisture.c, water_pump.c,
+ * sensors/soil_moisture.c and the host benchmarks (tools/host_bench.c).
+ * No hardware calls in here.
+ */
+#ifndef SOIL_SENSOR_H
+#define SOIL_SENSOR_H
+
+#include <stdint.h>
+
+#define ADC_MAX_VALUE   4095.0f // Maximum value for 12-bit ADC
+#define CALIBRATION_DRY 3000    // ADC value for dry soil (calibration)
+#define CALIBRATION_WET 1000    // ADC value for wet soil (calibration)
+
+// Linear interpolation between the dry and wet calibration points (0-100%)
+static inline float calculate_soil_moisture(int adc_value) {
+    if (adc_value >= CALIBRATION_DRY) return 0.0f;
+    if (adc_value <= CALIBRATION_WET) return 100.0f;
+    return (float)(CALIBRATION_DRY - adc_value) * (100.0f / (CALIBRATION_DRY - CALIBRATION_WET));
+}
+
+// Mean of one DMA burst of ADC samples
+static inline uint16_t soil_adc_average(const uint16_t *buf, int n) {
+    uint32_t sum = 0;
+    for (int i = 0; i < n; i++) sum += buf[i];
+    return (uint16_t)(sum / n);
+}
+
+// Raw ADC scaled to 0-100% of full range (sensors/soil_moisture.c)
+static inline float soil_adc_percent(uint16_t adc) {
+    return adc / ADC_MAX_VALUE * 100.0f;
+}
+
+#endif // SOIL_SENSOR_H
@@ -0,0 +1,91 @@
+// ---------------- status_screen.c ---------------- //
+/*
+ * OLED status screen layout (see status_screen.h).
+ */
+#include <stdio.h>
+#include <string.h>
+#include "status_screen.h"
+
+#define LABEL_W  14             // "Z1" plus a gap
+#define PCT_X    (OLED_WIDTH - 4 * OLED_GLYPH_W)
+#define SPARK_X  LABEL_W
+#define SPARK_W  (PCT_X - 2 - SPARK_X)
+#define ZONE_PAGE0 2
+
+_Static_assert(SPARK_W == SCREEN_TREND_LEN, "one trend point per sparkline column");
+
+void screen_init(status_screen_t *s, int zones, const uint8_t *threshold_pct) {
+    memset(s, 0, sizeof(*s));
+    s->zones = (uint8_t)(zones < SCREEN_MAX_ZONES ? zones : SCREEN_MAX_ZONES);
+    memcpy(s->threshold_pct, threshold_pct, s->zones);
+}
+
+void screen_moisture(status_screen_t *s, const uint8_t *pct, uint32_t now_s) {
+    memcpy(s->moisture_pct, pct, s->zones);
+    bool first = s->trend[0].count == 0;
+    if (!first && now_s - s->trend_s < SCREEN_TREND_PERIOD_S) return;
+    s->trend_s = now_s;
+    for (int z = 0; z < s->zones; z++) {
+        zone_trend_t *t = &s->trend[z];
+        t->pct[t->head] = pct[z];
+        t->head = (uint8_t)((t->head + 1) % SCREEN_TREND_LEN);
+        if (t->count < SCREEN_TREND_LEN) t->count++;
+    }
+}
+
+void screen_message(status_screen_t *s, const char *msg) {
+    snprintf(s->message, sizeof(s->message), "%s", msg);
+}
+
+// A full-width text row: the text, then blank to the right edge
+static void text_row(int page, const char *str) {
+    oled_fill(oled_text(0, page, str, false), page, OLED_WIDTH, 0);
+}
+
+void screen_draw(const status_screen_t *s, const screen_live_t *live) {
+    char line[OLED_COLS + 1];
+
+    snprintf(line, sizeof(line), "Soil%4u%% %5.1fC %3.0f%%", live->soil_pct, live->temperature,
+             live->humidity);
+    text_row(0, line);
+
+    if (live->watering_zone >= 0) {
+        snprintf(line, sizeof(line), "Watering Z%-6d%4ds", live->watering_zone + 1, live->watering_seconds);
+    } else if (s->message[0]) {
+        snprintf(line, sizeof(line), "%s", s->message);
+    } else if (live->dry_zones) {
+        int n = snprintf(line, sizeof(line), "Dry:");
+        for (int z = 0; z < s->zones && n < (int)sizeof(line) - 3; z++) {
+            if (live->dry_zones & (1u << z)) n += snprintf(line + n, sizeof(line) - n, " Z%d", z + 1);
+        }
+    } else {
+        snprintf(line, sizeof(line), "Idle");
+    }
+    text_row(1, line);
+
+    // Zone rows share pages 2-7; the bottom pixel row of each stays blank
+    int rows = s->zones ? s->zones : 1;
+    int row_pages = (OLED_PAGES - ZONE_PAGE0) / rows;
+    uint8_t trend[SCREEN_TREND_LEN];
+    for (int z = 0; z < s->zones; z++) {
+        int page = ZONE_PAGE0 + z * row_pages;
+        const zone_trend_t *t = &s->trend[z];
+        int first = (t->head + SCREEN_TREND_LEN - t->count) % SCREEN_TREND_LEN;
+        for (int i = 0; i < t->count; i++) trend[i] = t->pct[(first + i) % SCREEN_TREND_LEN];
+
+        snprintf(line, sizeof(line), "Z%d", z + 1);
+        int x = oled_text(0, page, line, z == live->watering_zone);
+        oled_fill(x, page, LABEL_W - x, 0);
+        oled_sparkline(SPARK_X, page * 8, SPARK_W, row_pages * 8 - 1, trend, t->count, 100, s->threshold_pct[z]);
+        oled_fill(SPARK_X + SPARK_W, page, PCT_X - SPARK_X - SPARK_W, 0);
+        snprintf(line, sizeof(line), "%3u%%", s->moisture_pct[z]);
+        oled_text(PCT_X, page, line, false);
+        for (int p = page + 1; p < page + row_pages; p++) {
+            oled_fill(0, p, LABEL_W, 0);
+            oled_fill(SPARK_X + SPARK_W, p, OLED_WIDTH, 0);
+        }
+    }
+    for (int p = ZONE_PAGE0 + s->zones * row_pages; p < OLED_PAGES; p++) oled_fill(0, p, OLED_WIDTH, 0);
+}
+
+// End of status_screen.c
@@ -0,0 +1,53 @@
+// ---------------- status_screen.h ---------------- //
+/*
+ * The OLED status screen, drawn in full into the oled.h framebuffer on
+ * every update; the page diff keeps the flushes small.
+ *
+ *   Soil  62%  23.4C  45%      page 0: probe 0, temperature, humidity
+ *   Watering Z2         12s    page 1: activity, or the last message
+ *   Z1 /\_sparkline_/\.. 62%   pages 2-7: one row per zone, with the
+ *   Z2 ................  48%   moisture trend and a dotted dry threshold
+ *
+ * No hardware calls: tools/oled_render and tools/host_bench draw the
+ * same screen as the firmware.
+ */
+#ifndef STATUS_SCREEN_H
+#define STATUS_SCREEN_H
+
+#include <stdint.h>
+#include "oled.h"
+
+#define SCREEN_TREND_LEN      88    // points per zone, one per pixel column
+#define SCREEN_TREND_PERIOD_S 60    // one point a minute: ~1.5 h on screen
+#define SCREEN_MAX_ZONES      6     // one page each at most
+
+typedef struct {
+    uint8_t pct[SCREEN_TREND_LEN];  // ring of moisture %
+    uint8_t head, count;
+} zone_trend_t;
+
+typedef struct {
+    uint8_t zones;
+    uint8_t moisture_pct[SCREEN_MAX_ZONES];
+    uint8_t threshold_pct[SCREEN_MAX_ZONES];
+    zone_trend_t trend[SCREEN_MAX_ZONES];
+    uint32_t trend_s;               // time of the last trend point
+    char message[OLED_COLS + 1];    // "Zone Done", alert names
+} status_screen_t;
+
+// What the tasks are doing right now
+typedef struct {
+    uint8_t soil_pct;
+    float temperature, humidity;
+    int8_t watering_zone;           // -1 when idle
+    int watering_seconds;
+    uint8_t dry_zones;
+} screen_live_t;
+
+void screen_init(status_screen_t *s, int zones, const uint8_t *threshold_pct);
+// Latest moisture per zone; adds a trend point every SCREEN_TREND_PERIOD_S.
+void screen_moisture(status_screen_t *s, const uint8_t *pct, uint32_t now_s);
+void screen_message(status_screen_t *s, const char *msg);
+void screen_draw(const status_screen_t *s, const screen_live_t *live);
+
+#endif // STATUS_SCREEN_H
@@ -0,0 +1,417 @@
+// ---------------- telemetry.c ---------------- //
+/*
+ * Batched MQTT telemetry publisher (see telemetry.h).
+ *
+ * Frame (CBOR):  { "n": node-id, "t0": first sample time,
+ *                  "s": [[dt, soil, temp_x10, hum_x10, dry_zones], ...] }
+ *
+ * Only one frame is in flight at a time. Every frame gets its spool
+ * sequence number when it is closed: a live frame reserves the slot it
+ * would be spooled in, and only goes there if it is not acknowledged
+ * (broker down, QoS 1 timeout). Frames closed meanwhile, and every frame
+ * while the spool is non-empty, are spooled behind it, so the broker
+ * always sees frames in sampling order. A slot reserved by a frame that
+ * was acknowledged is never written; replay skips it.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/cyw43_arch.h"
+#include "pico/unique_id.h"
+#include "pico/flash.h"
+#include "hardware/flash.h"
+#include "lwip/apps/mqtt.h"
+#include "lwip/ip_addr.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "telemetry.h"
+#include "flash_layout.h"
+#include "pump_drive.h"
+
+#define RECONNECT_MS      5000
+#define PUBLISH_TIMEOUT_MS 35000   // a little longer than lwIP's MQTT_REQ_TIMEOUT
+
+// ---------------- Flash spool ---------------- //
+// SPOOL_OFFSET / SPOOL_BYTES come from flash_layout.h
+#define SPOOL_SLOT_BYTES  512
+#define SPOOL_SLOTS       (SPOOL_BYTES / SPOOL_SLOT_BYTES)
+#define SLOTS_PER_SECTOR  (FLASH_SECTOR_SIZE / SPOOL_SLOT_BYTES)
+#define SPOOL_MAGIC       0x5354    // "ST"
+#define SLOT_PENDING      0xFFFF    // erased state
+#define SLOT_SENT         0x0000    // programmed over the erased state once replayed
+
+typedef struct {
+    uint16_t magic;
+    uint16_t state;
+    uint16_t len;
+    uint16_t reserved;
+    uint32_t seq;
+    uint8_t payload[SPOOL_SLOT_BYTES - 12];
+} spool_slot_t;
+
+_Static_assert(sizeof(spool_slot_t) == SPOOL_SLOT_BYTES, "spool slot must be two flash pages");
+_Static_assert(TELEMETRY_PAYLOAD_MAX <= sizeof(((spool_slot_t *)0)->payload), "frame does not fit a spool slot");
+
+static uint32_t spool_head;   // seq of the next slot to hand out
+static uint32_t spool_tail;   // seq of the oldest unsent slot
+static uint32_t sector_base[SPOOL_SECTORS];   // first seq each sector was last erased for
+static spool_slot_t spool_buf;
+
+typedef struct {
+    uint32_t offset;
+    const void *data;
+    size_t len;
+    bool erase;             // erase the sector holding offset first
+} flash_op_t;
+
+static void flash_op(void *param) {
+    const flash_op_t *op = param;
+    pump_drive_flash_hold(true);
+    if (op->erase) flash_range_erase(op->offset & ~(FLASH_SECTOR_SIZE - 1), FLASH_SECTOR_SIZE);
+    if (op->data) flash_range_program(op->offset, op->data, op->len);
+    pump_drive_flash_hold(false);
+}
+
+static const spool_slot_t *spool_slot(uint32_t seq) {
+    return (const spool_slot_t *)(XIP_BASE + SPOOL_OFFSET + (seq % SPOOL_SLOTS) * SPOOL_SLOT_BYTES);
+}
+
+// Recover head/tail after a reboot from the slot headers left in flash.
+static void spool_scan(void) {
+    bool any = false, any_pending = false;
+    uint32_t max_seq = 0, min_pending = 0;
+    for (uint32_t i = 0; i < SPOOL_SLOTS; i++) {
+        const spool_slot_t *s = (const spool_slot_t *)(XIP_BASE + SPOOL_OFFSET + i * SPOOL_SLOT_BYTES);
+        if (s->magic != SPOOL_MAGIC || s->seq % SPOOL_SLOTS != i) continue;
+        if (!any || s->seq > max_seq) max_seq = s->seq;
+        if (s->state == SLOT_PENDING && (!any_pending || s->seq < min_pending)) min_pending = s->seq;
+        any = true;
+        any_pending |= s->state == SLOT_PENDING;
+    }
+    spool_head = any ? max_seq + 1 : 0;
+    spool_tail = any_pending ? min_pending : spool_head;
+
+    // Only the rest of the head's sector is known to be erased
+    memset(sector_base, 0xFF, sizeof(sector_base));
+    if (spool_head % SLOTS_PER_SECTOR) {
+        sector_base[spool_head % SPOOL_SLOTS / SLOTS_PER_SECTOR] = spool_head - spool_head % SLOTS_PER_SECTOR;
+    }
+}
+
+// Write a frame into the slot of `seq` (handed out from spool_head).
+// Returns the number of unsent frames overwritten to make room (0 normally).
+static uint32_t spool_write(uint32_t seq, const uint8_t *frame, uint16_t len) {
+    if (seq < spool_tail) return 1;   // its slot was already recycled
+    uint32_t lost = 0;
+    uint32_t slot = seq % SPOOL_SLOTS;
+    uint32_t base = seq - slot % SLOTS_PER_SECTOR;
+    flash_op_t op = {
+        .offset = SPOOL_OFFSET + slot * SPOOL_SLOT_BYTES,
+        .data = &spool_buf,
+        .len = SPOOL_SLOT_BYTES,
+        .erase = false,
+    };
+
+    if (sector_base[slot / SLOTS_PER_SECTOR] != base) {
+        // First write to this sector in this lap: erase it, dropping any
+        // unsent frames it still holds from the last lap
+        uint32_t keep_from = base + SLOTS_PER_SECTOR > SPOOL_SLOTS ? base + SLOTS_PER_SECTOR - SPOOL_SLOTS : 0;
+        if (spool_tail < keep_from) {
+            lost = keep_from - spool_tail;
+            spool_tail = keep_from;
+        }
+        sector_base[slot / SLOTS_PER_SECTOR] = base;
+        op.erase = true;
+    }
+
+    memset(&spool_buf, 0xFF, sizeof(spool_buf));
+    spool_buf.magic = SPOOL_MAGIC;
+    spool_buf.state = SLOT_PENDING;
+    spool_buf.len = len;
+    spool_buf.seq = seq;
+    memcpy(spool_buf.payload, frame, len);
+
+    flash_safe_execute(flash_op, &op, UINT32_MAX);
+    return lost;
+}
+
+// Flip the slot's state to SENT by programming only its first page again.
+static void spool_mark_sent(uint32_t seq) {
+    const spool_slot_t *s = spool_slot(seq);
+    memcpy(&spool_buf, s, FLASH_PAGE_SIZE);
+    spool_buf.state = SLOT_SENT;
+    flash_op_t op = {
+        .offset = SPOOL_OFFSET + (seq % SPOOL_SLOTS) * SPOOL_SLOT_BYTES,
+        .data = &spool_buf,
+        .len = FLASH_PAGE_SIZE,
+        .erase = false,
+    };
+    flash_safe_execute(flash_op, &op, UINT32_MAX);
+}
+
+// ---------------- CBOR encoding ---------------- //
+typedef struct {
+    uint8_t *buf;
+    uint16_t len, cap;
+    bool ok;
+} cbor_t;
+
+static void cbor_head(cbor_t *c, uint8_t major, uint32_t v) {
+    uint8_t tmp[5];
+    uint8_t n;
+    if (v < 24)           { tmp[0] = (uint8_t)(major << 5 | v); n = 1; }
+    else if (v <= 0xFF)   { tmp[0] = (uint8_t)(major << 5 | 24); tmp[1] = (uint8_t)v; n = 2; }
+    else if (v <= 0xFFFF) { tmp[0] = (uint8_t)(major << 5 | 25); tmp[1] = (uint8_t)(v >> 8); tmp[2] = (uint8_t)v; n = 3; }
+    else {
+        tmp[0] = (uint8_t)(major << 5 | 26);
+        tmp[1] = (uint8_t)(v >> 24); tmp[2] = (uint8_t)(v >> 16); tmp[3] = (uint8_t)(v >> 8); tmp[4] = (uint8_t)v;
+        n = 5;
+    }
+    if (!c->ok || c->len + n > c->cap) { c->ok = false; return; }
+    memcpy(c->buf + c->len, tmp, n);
+    c->len += n;
+}
+
+static void cbor_int(cbor_t *c, int32_t v) {
+    if (v >= 0) cbor_head(c, 0, (uint32_t)v);
+    else        cbor_head(c, 1, (uint32_t)(-1 - v));
+}
+
+static void cbor_text(cbor_t *c, const char *s) {
+    uint16_t n = (uint16_t)strlen(s);
+    cbor_head(c, 3, n);
+    if (!c->ok || c->len + n > c->cap) { c->ok = false; return; }
+    memcpy(c->buf + c->len, s, n);
+    c->len += n;
+}
+
+static char node_id[2 * PICO_UNIQUE_BOARD_ID_SIZE_BYTES + 1];
+static char topic[48];
+
+static uint16_t encode_batch(const telemetry_sample_t *batch, int n, uint8_t *out) {
+    cbor_t c = { .buf = out, .len = 0, .cap = TELEMETRY_PAYLOAD_MAX, .ok = true };
+    cbor_head(&c, 5, 3);
+    cbor_text(&c, "n");  cbor_text(&c, node_id);
+    cbor_text(&c, "t0"); cbor_int(&c, (int32_t)batch[0].t_s);
+    cbor_text(&c, "s");  cbor_head(&c, 4, (uint32_t)n);
+    for (int i = 0; i < n; i++) {
+        cbor_head(&c, 4, 5);
+        cbor_int(&c, (int32_t)(batch[i].t_s - batch[0].t_s));
+        cbor_int(&c, batch[i].soil);
+        cbor_int(&c, batch[i].temp_x10);
+        cbor_int(&c, batch[i].hum_x10);
+        cbor_int(&c, batch[i].dry_zones);
+    }
+    return c.ok ? c.len : 0;
+}
+
+// ---------------- MQTT state ---------------- //
+enum { PUB_IDLE, PUB_INFLIGHT, PUB_OK, PUB_FAILED };
+
+static QueueHandle_t sample_queue;
+#if configSUPPORT_STATIC_ALLOCATION
+static StaticQueue_t sample_queue_ctrl;
+static uint8_t sample_queue_storage[TELEMETRY_QUEUE_LEN * sizeof(telemetry_sample_t)];
+#endif
+static mqtt_client_t *mqtt;
+static volatile bool wifi_ready = false;
+static volatile bool wifi_failed = false;
+static volatile bool mqtt_up = false;
+static volatile bool mqtt_connecting = false;
+static volatile uint8_t publish_state = PUB_IDLE;
+static volatile uint32_t publish_id;   // tags mqtt_publish_cb calls; older ones are stale
+static bool inflight_from_spool;
+static uint32_t inflight_seq;
+static uint16_t inflight_len;
+static TickType_t inflight_since;
+static uint8_t inflight_buf[TELEMETRY_PAYLOAD_MAX];
+static uint8_t frame_buf[TELEMETRY_PAYLOAD_MAX];
+static telemetry_sample_t batch[TELEMETRY_BATCH];
+static telemetry_stats_t stats;
+
+static void mqtt_connection_cb(mqtt_client_t *client, void *arg, mqtt_connection_status_t status) {
+    mqtt_connecting = false;
+    mqtt_up = (status == MQTT_CONNECT_ACCEPTED);
+    if (!mqtt_up && publish_state == PUB_INFLIGHT) publish_state = PUB_FAILED;
+}
+
+static void mqtt_publish_cb(void *arg, err_t err) {
+    // A late reply to a frame already given up on must not settle the next one
+    if ((uint32_t)(uintptr_t)arg != publish_id || publish_state != PUB_INFLIGHT) return;
+    publish_state = (err == ERR_OK) ? PUB_OK : PUB_FAILED;
+}
+
+static void mqtt_start_connect(void) {
+    static struct mqtt_connect_client_info_t info;
+    ip_addr_t broker;
+    if (!ipaddr_aton(MQTT_BROKER_IP, &broker)) return;
+
+    info.client_id = node_id;
+    info.keep_alive = 60;
+    mqtt_connecting = true;
+    cyw43_arch_lwip_begin();
+    err_t err = mqtt_client_connect(mqtt, &broker, MQTT_BROKER_PORT, mqtt_connection_cb, NULL, &info);
+    cyw43_arch_lwip_end();
+    if (err != ERR_OK) mqtt_connecting = false;
+}
+
+static bool publish_frame(const uint8_t *frame, uint16_t len, bool from_spool, uint32_t seq) {
+    memcpy(inflight_buf, frame, len);
+    inflight_len = len;
+    inflight_from_spool = from_spool;
+    inflight_seq = seq;
+    inflight_since = xTaskGetTickCount();
+    uint32_t id = ++publish_id;
+    publish_state = PUB_INFLIGHT;
+
+    cyw43_arch_lwip_begin();
+    err_t err = mqtt_publish(mqtt, topic, inflight_buf, len, 1, 0, mqtt_publish_cb, (void *)(uintptr_t)id);
+    cyw43_arch_lwip_end();
+    if (err != ERR_OK) {
+        publish_state = PUB_IDLE;
+        return false;
+    }
+    return true;
+}
+
+// Settle the frame in flight: count it on ack, spool it on failure.
+// Either way its slot is done with once the tail passes it.
+static void service_inflight(void) {
+    uint8_t state = publish_state;
+    if (state == PUB_INFLIGHT &&
+        xTaskGetTickCount() - inflight_since > pdMS_TO_TICKS(PUBLISH_TIMEOUT_MS)) {
+        state = PUB_FAILED;
+    }
+
+    if (state == PUB_OK) {
+        stats.batches_published++;
+        stats.bytes_published += inflight_len;
+        if (inflight_from_spool) {
+            // unless the spool wrapped over it meanwhile and its sector is reused
+            if (inflight_seq >= spool_tail) spool_mark_sent(inflight_seq);
+            stats.batches_replayed++;
+        }
+        if (spool_tail == inflight_seq) spool_tail++;
+        publish_state = PUB_IDLE;
+    } else if (state == PUB_FAILED) {
+        // spooled frames stay pending in flash; live frames go to their reserved slot
+        if (!inflight_from_spool) {
+            stats.batches_lost += spool_write(inflight_seq, inflight_buf, inflight_len);
+            stats.batches_spooled++;
+        }
+        publish_state = PUB_IDLE;
+    }
+}
+
+// ---------------- Public API ---------------- //
+void telemetry_init(void) {
+#if configSUPPORT_STATIC_ALLOCATION
+    sample_queue = xQueueCreateStatic(TELEMETRY_QUEUE_LEN, sizeof(telemetry_sample_t),
+                                      sample_queue_storage, &sample_queue_ctrl);
+#else
+    sample_queue = xQueueCreate(TELEMETRY_QUEUE_LEN, sizeof(telemetry_sample_t));
+#endif
+    pico_get_unique_board_id_string(node_id, sizeof(node_id));
+    snprintf(topic, sizeof(topic), "irrigation/%s/telemetry", node_id);
+    spool_scan();
+}
+
+bool telemetry_submit(const telemetry_sample_t *sample) {
+    if (xQueueSend(sample_queue, sample, 0) != pdTRUE) {
+        stats.samples_dropped++;
+        return false;
+    }
+    stats.samples_in++;
+    return true;
+}
+
+bool telemetry_backpressure(void) {
+    return uxQueueMessagesWaiting(sample_queue) >= TELEMETRY_QUEUE_LEN * 3 / 4;
+}
+
+bool telemetry_link_up(void) {
+    return wifi_ready && cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA) == CYW43_LINK_UP;
+}
+
+bool telemetry_wifi_failed(void) {
+    return wifi_failed;
+}
+
+void telemetry_get_stats(telemetry_stats_t *out) {
+    *out = stats;
+    out->spool_pending = spool_head - spool_tail;
+    out->connected = mqtt_up;
+}
+
+uint32_t telemetry_ram_bytes(void) {
+    return TELEMETRY_QUEUE_LEN * sizeof(telemetry_sample_t)
+         + sizeof(batch) + sizeof(frame_buf) + sizeof(inflight_buf) + sizeof(spool_buf)
+         + sizeof(stats) + sizeof(node_id) + sizeof(topic);
+}
+
+// ---------------- Publisher task ---------------- //
+void telemetry_task(void *params) {
+    if (cyw43_arch_init()) {
+        printf("[MQTT] Wi-Fi init failed, telemetry disabled\n");
+        wifi_failed = true;
+        if (params) *(TaskHandle_t *)params = NULL;
+        vTaskDelete(NULL);
+    }
+    cyw43_arch_enable_sta_mode();
+    mqtt = mqtt_client_new();
+    wifi_ready = true;
+
+    int n = 0;
+    TickType_t batch_start = 0;
+    TickType_t last_attempt = xTaskGetTickCount() - pdMS_TO_TICKS(RECONNECT_MS);
+
+    while(1) {
+        telemetry_sample_t s;
+        if (xQueueReceive(sample_queue, &s, pdMS_TO_TICKS(1000)) == pdTRUE) {
+            if (n == 0) batch_start = xTaskGetTickCount();
+            batch[n++] = s;
+        }
+        TickType_t now = xTaskGetTickCount();
+
+        service_inflight();
+
+        // Close the batch when full or stale
+        if (n == TELEMETRY_BATCH || (n > 0 && now - batch_start >= pdMS_TO_TICKS(TELEMETRY_FLUSH_MS))) {
+            uint16_t len = encode_batch(batch, n, frame_buf);
+            n = 0;
+            if (len > 0) {
+                bool live = mqtt_up && publish_state == PUB_IDLE && spool_tail == spool_head;
+                uint32_t seq = spool_head++;
+                if (!live || !publish_frame(frame_buf, len, false, seq)) {
+                    stats.batches_lost += spool_write(seq, frame_buf, len);
+                    stats.batches_spooled++;
+                }
+            }
+        }
+
+        // Replay the spool, oldest first, one frame at a time
+        if (mqtt_up && publish_state == PUB_IDLE && spool_tail != spool_head) {
+            const spool_slot_t *slot = spool_slot(spool_tail);
+            if (slot->magic == SPOOL_MAGIC && slot->seq == spool_tail && slot->state == SLOT_PENDING &&
+                slot->len <= TELEMETRY_PAYLOAD_MAX) {
+                publish_frame(slot->payload, slot->len, true, spool_tail);
+            } else {
+                spool_tail++;   // damaged or already sent, skip it
+            }
+        }
+
+        // Keep Wi-Fi and the broker session up
+        if (!mqtt_up && !mqtt_connecting && now - last_attempt >= pdMS_TO_TICKS(RECONNECT_MS)) {
+            last_attempt = now;
+            int link = cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA);
+            if (link == CYW43_LINK_UP) {
+                mqtt_start_connect();
+            } else if (link == CYW43_LINK_DOWN || link < 0) {
+                cyw43_arch_wifi_connect_async(WIFI_SSID, WIFI_PASSWORD, CYW43_AUTH_WPA2_AES_PSK);
+            }
+        }
+    }
+}
+
+// End of telemetry.c
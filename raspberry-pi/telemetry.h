@@ -0,0 +1,74 @@
+// ---------------- telemetry.h ---------------- //
+/*
+ * Batched MQTT telemetry for the Pico W.
+ * Samples are queued by the sensor tasks, packed into one CBOR frame per
+ * batch and published with QoS 1 through lwIP's MQTT client. While the
+ * broker is unreachable, frames are spooled to the last 64 KB of flash and
+ * replayed in order on reconnect.
+ *
+ * Needs pico_cyw43_arch_lwip_sys_freertos and, in lwipopts.h,
+ * LWIP_MQTT 1 (via pico_lwip_mqtt) with MQTT_OUTPUT_RINGBUF_SIZE >= 1024.
+ */
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- Network configuration (override with -D) ---
+#ifndef WIFI_SSID
+#define WIFI_SSID "irrigation"
+#endif
+#ifndef WIFI_PASSWORD
+#define WIFI_PASSWORD "changeme"
+#endif
+#ifndef MQTT_BROKER_IP
+#define MQTT_BROKER_IP "192.168.4.1"
+#endif
+#ifndef MQTT_BROKER_PORT
+#define MQTT_BROKER_PORT 1883
+#endif
+
+// --- Batching ---
+#define TELEMETRY_BATCH       24      // samples per frame
+#define TELEMETRY_FLUSH_MS    60000   // publish a partial batch after this long
+#ifndef TELEMETRY_QUEUE_LEN
+#define TELEMETRY_QUEUE_LEN   48      // samples buffered between sampler and publisher
+#endif
+#define TELEMETRY_PAYLOAD_MAX 500     // fits one flash spool slot
+
+typedef struct {
+    uint32_t t_s;         // seconds since boot
+    uint16_t soil;        // raw ADC
+    int16_t temp_x10;     // 0.1 C
+    uint16_t hum_x10;     // 0.1 %
+    uint8_t dry_zones;
+} telemetry_sample_t;
+
+typedef struct {
+    uint32_t samples_in, samples_dropped;
+    uint32_t batches_published, batches_spooled, batches_replayed, batches_lost;
+    uint32_t bytes_published;
+    uint32_t spool_pending;
+    bool connected;
+} telemetry_stats_t;
+
+void telemetry_init(void);
+// params: optional TaskHandle_t * holding this task's handle; cleared
+// before the task deletes itself (no Wi-Fi).
+void telemetry_task(void *params);
+
+// Non-blocking; false when the queue is full and the sample was dropped.
+bool telemetry_submit(const telemetry_sample_t *sample);
+// True while the publisher is behind; samplers should stretch their period.
+bool telemetry_backpressure(void);
+
+// True once the Wi-Fi station (owned by telemetry_task) has an IP link.
+bool telemetry_link_up(void);
+// True if the Wi-Fi chip failed to start; the link will never come up.
+bool telemetry_wifi_failed(void);
+
+void telemetry_get_stats(telemetry_stats_t *out);
+uint32_t telemetry_ram_bytes(void);
+
+#endif // TELEMETRY_H
@@ -0,0 +1,579 @@
+// ---------------- alert_compiler.c ---------------- //
+/*
+ * Host tool: compiles the "alerts" section of config/irrigation-settings.json
+ * into the bytecode blob the firmware evaluates (alert_rules.h).
+ *
+ * Build:  cc -O2 -I.. alert_compiler.c ../alert_rules.c ../checksum.c -o alert_compiler -lm
+ * Usage:  alert_compiler [-o rules.bin] [-c header.h] [-x] [-b rules] settings.json
+ *   -o  write the blob
+ *   -c  write it as a C array (the firmware's built-in alert_rules_default.h)
+ *   -x  print it as hex, to paste after the CLI's "alerts load"
+ *   -b  time the evaluator with the rules repeated up to this many
+ *
+ * Rule fields:
+ *   "name"        shown on the console / LCD (<= 15 chars)
+ *   "when"        expression, e.g. "temp > 30 || (hum > 70 && !watering)"
+ *                 signals: soil temp hum intrusion cycles watering
+ *                 rate(sig) = change per minute; && || ! < <= > >= == != ( )
+ *   "for_s"       condition must hold this long (default 0)
+ *   "cooldown_s"  minimum gap between raises (default 0)
+ *   "max_fires"   stop after this many raises, 0 = no limit (default 0)
+ *   "actions"     any of "log" "led" "stop" "lcd" "reset_cycles"
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "alert_rules.h"
+#include "checksum.h"
+
+#define NAME_MAX_LEN 15
+
+static const char *signal_names[ALERT_SIGNALS] = {
+    [SIG_SOIL] = "soil", [SIG_TEMP] = "temp", [SIG_HUM] = "hum",
+    [SIG_INTRUSION] = "intrusion", [SIG_CYCLES] = "cycles", [SIG_WATERING] = "watering",
+};
+
+static const struct { const char *name; uint8_t bit; } action_names[] = {
+    {"log", ALERT_LOG}, {"led", ALERT_LED}, {"stop", ALERT_STOP},
+    {"lcd", ALERT_LCD}, {"reset_cycles", ALERT_RESET_CYCLES},
+};
+
+typedef struct {
+    char name[NAME_MAX_LEN + 1];
+    uint8_t code[255];
+    uint8_t code_len;
+    uint8_t signals;
+    uint16_t for_s, cooldown_s;
+    uint8_t max_fires, actions;
+} rule_src_t;
+
+static rule_src_t rules_src[ALERT_MAX_RULES];
+static int rule_count;
+
+static void fail(const char *what, const char *where) {
+    fprintf(stderr, "error: %s", what);
+    if (where) fprintf(stderr, " near \"%.20s\"", where);
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+// ---------------- Minimal JSON reader ---------------- //
+static const char *js;
+
+static void js_ws(void) {
+    while (isspace((unsigned char)*js)) js++;
+}
+
+static void js_expect(char c) {
+    js_ws();
+    if (*js != c) {
+        char msg[32];
+        snprintf(msg, sizeof(msg), "expected '%c'", c);
+        fail(msg, js);
+    }
+    js++;
+}
+
+static bool js_peek(char c) {
+    js_ws();
+    return *js == c;
+}
+
+static void js_string(char *out, size_t cap) {
+    js_expect('"');
+    size_t n = 0;
+    while (*js && *js != '"') {
+        char c = *js++;
+        if (c == '\\') {
+            c = *js++;
+            if (c == 'n') c = '\n';
+            else if (c == 't') c = '\t';
+            else if (c != '"' && c != '\\' && c != '/') fail("unsupported string escape", js - 2);
+        }
+        if (n + 1 >= cap) fail("string too long", js);
+        out[n++] = c;
+    }
+    if (*js != '"') fail("unterminated string", NULL);
+    js++;
+    out[n] = '\0';
+}
+
+static double js_number(void) {
+    js_ws();
+    char *end;
+    double v = strtod(js, &end);
+    if (end == js) fail("expected a number", js);
+    js = end;
+    return v;
+}
+
+static void js_skip(void) {
+    js_ws();
+    if (*js == '"') {
+        char tmp[1024];
+        js_string(tmp, sizeof(tmp));
+    } else if (*js == '{' || *js == '[') {
+        char close = *js == '{' ? '}' : ']';
+        js++;
+        if (js_peek(close)) {
+            js++;
+            return;
+        }
+        do {
+            if (close == '}') {
+                char key[128];
+                js_string(key, sizeof(key));
+                js_expect(':');
+            }
+            js_skip();
+            js_ws();
+        } while (*js == ',' && js++);
+        js_expect(close);
+    } else if (!strncmp(js, "true", 4) || !strncmp(js, "null", 4)) {
+        js += 4;
+    } else if (!strncmp(js, "false", 5)) {
+        js += 5;
+    } else {
+        js_number();
+    }
+}
+
+// ---------------- Expression compiler ---------------- //
+// expr := and ('||' and)*     and := unary ('&&' unary)*
+// unary := '!' unary | cmp    cmp := term (op term)?
+// term := number | signal | rate(signal) | '(' expr ')'
+typedef struct {
+    const char *p;
+    rule_src_t *r;
+    int depth, max_depth;
+} expr_t;
+
+static void ex_ws(expr_t *x) {
+    while (isspace((unsigned char)*x->p)) x->p++;
+}
+
+static void emit(expr_t *x, const uint8_t *b, int n, int push) {
+    if (x->r->code_len + n > (int)sizeof(x->r->code)) fail("rule too long", x->p);
+    memcpy(x->r->code + x->r->code_len, b, n);
+    x->r->code_len += n;
+    x->depth += push;
+    if (x->depth > x->max_depth) x->max_depth = x->depth;
+}
+
+static int parse_signal(expr_t *x) {
+    ex_ws(x);
+    for (int s = 0; s < ALERT_SIGNALS; s++) {
+        size_t n = strlen(signal_names[s]);
+        if (!strncmp(x->p, signal_names[s], n) && !isalnum((unsigned char)x->p[n]) && x->p[n] != '_') {
+            x->p += n;
+            x->r->signals |= 1u << s;
+            return s;
+        }
+    }
+    return -1;
+}
+
+// A term that is a bare signal or number is held back (kind/val) so the
+// comparison can fuse it into OP_TEST.
+enum { T_DONE, T_SIG, T_NUM };
+
+static int32_t to_fixed(double v, const char *where) {
+    double k = round(v * 10);
+    if (k > INT32_MAX || k < INT32_MIN) fail("number out of range", where);
+    return (int32_t)k;
+}
+
+static void emit_num(expr_t *x, int32_t k) {
+    if (k >= INT16_MIN && k <= INT16_MAX) {
+        uint8_t b[3] = {OP_CONST16, (uint8_t)k, (uint8_t)(k >> 8)};
+        emit(x, b, 3, 1);
+    } else {
+        uint8_t b[5] = {OP_CONST32, (uint8_t)k, (uint8_t)(k >> 8), (uint8_t)(k >> 16), (uint8_t)(k >> 24)};
+        emit(x, b, 5, 1);
+    }
+}
+
+static void flush_term(expr_t *x, int kind, int32_t val) {
+    if (kind == T_SIG) {
+        uint8_t b[2] = {OP_SIG, (uint8_t)val};
+        emit(x, b, 2, 1);
+    } else if (kind == T_NUM) {
+        emit_num(x, val);
+    }
+}
+
+static void parse_or(expr_t *x);
+
+static int parse_term(expr_t *x, int32_t *val) {
+    ex_ws(x);
+    if (*x->p == '(') {
+        x->p++;
+        parse_or(x);
+        ex_ws(x);
+        if (*x->p != ')') fail("expected ')'", x->p);
+        x->p++;
+        return T_DONE;
+    }
+    if (!strncmp(x->p, "rate", 4) && (x->p[4] == '(' || isspace((unsigned char)x->p[4]))) {
+        x->p += 4;
+        ex_ws(x);
+        if (*x->p != '(') fail("expected '(' after rate", x->p);
+        x->p++;
+        int s = parse_signal(x);
+        if (s < 0) fail("unknown signal", x->p);
+        ex_ws(x);
+        if (*x->p != ')') fail("expected ')'", x->p);
+        x->p++;
+        uint8_t b[2] = {OP_RATE, (uint8_t)s};
+        emit(x, b, 2, 1);
+        return T_DONE;
+    }
+    if (isdigit((unsigned char)*x->p) || *x->p == '-' || *x->p == '.') {
+        char *end;
+        double v = strtod(x->p, &end);
+        if (end == x->p) fail("bad number", x->p);
+        *val = to_fixed(v, x->p);
+        x->p = end;
+        return T_NUM;
+    }
+    int s = parse_signal(x);
+    if (s < 0) fail("unknown signal", x->p);
+    *val = s;
+    return T_SIG;
+}
+
+static int parse_cmp_op(expr_t *x) {
+    ex_ws(x);
+    static const struct { const char *s; int op; } ops[] = {
+        {">=", OP_GE}, {"<=", OP_LE}, {"==", OP_EQ}, {"!=", OP_NE}, {">", OP_GT}, {"<", OP_LT},
+    };
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        size_t n = strlen(ops[i].s);
+        if (!strncmp(x->p, ops[i].s, n)) {
+            x->p += n;
+            return ops[i].op;
+        }
+    }
+    return 0;
+}
+
+static int flip(int op) {
+    switch (op) {
+    case OP_GT: return OP_LT;
+    case OP_GE: return OP_LE;
+    case OP_LT: return OP_GT;
+    case OP_LE: return OP_GE;
+    default:    return op;
+    }
+}
+
+static void parse_cmp(expr_t *x) {
+    int32_t a = 0, b = 0;
+    int ka = parse_term(x, &a);
+    int op = parse_cmp_op(x);
+    if (!op) {
+        flush_term(x, ka, a);
+        return;
+    }
+
+    // signal <op> constant, either way round, becomes one OP_TEST
+    const char *right = x->p;
+    uint8_t mark = x->r->code_len;
+    int depth = x->depth;
+    int kb = parse_term(x, &b);
+    if (ka != T_DONE && kb != T_DONE && ka != kb) {
+        int32_t sig = ka == T_SIG ? a : b, k = ka == T_SIG ? b : a;
+        if (k >= INT16_MIN && k <= INT16_MAX) {
+            uint8_t t[5] = {OP_TEST, (uint8_t)sig, (uint8_t)(ka == T_SIG ? op : flip(op)), (uint8_t)k, (uint8_t)(k >> 8)};
+            emit(x, t, 5, 1);
+            return;
+        }
+    }
+
+    // General case: the right operand may already have emitted code, so
+    // drop it and compile it again after the left one
+    x->p = right;
+    x->r->code_len = mark;
+    x->depth = depth;
+    flush_term(x, ka, a);
+    kb = parse_term(x, &b);
+    flush_term(x, kb, b);
+    uint8_t o = (uint8_t)op;
+    emit(x, &o, 1, -1);
+}
+
+static void parse_unary(expr_t *x) {
+    ex_ws(x);
+    if (*x->p == '!' && x->p[1] != '=') {
+        x->p++;
+        parse_unary(x);
+        uint8_t o = OP_NOT;
+        emit(x, &o, 1, 0);
+        return;
+    }
+    parse_cmp(x);
+}
+
+static void parse_and(expr_t *x) {
+    parse_unary(x);
+    for (;;) {
+        ex_ws(x);
+        if (strncmp(x->p, "&&", 2)) return;
+        x->p += 2;
+        parse_unary(x);
+        uint8_t o = OP_AND;
+        emit(x, &o, 1, -1);
+    }
+}
+
+static void parse_or(expr_t *x) {
+    parse_and(x);
+    for (;;) {
+        ex_ws(x);
+        if (strncmp(x->p, "||", 2)) return;
+        x->p += 2;
+        parse_and(x);
+        uint8_t o = OP_OR;
+        emit(x, &o, 1, -1);
+    }
+}
+
+static void compile_expr(rule_src_t *r, const char *src) {
+    expr_t x = {.p = src, .r = r};
+    parse_or(&x);
+    ex_ws(&x);
+    if (*x.p) fail("unexpected text in expression", x.p);
+    if (x.max_depth > ALERT_STACK) fail("expression nests too deep", src);
+}
+
+// ---------------- Settings file ---------------- //
+static uint16_t as_u16(double v, const char *field) {
+    if (v < 0 || v > 65535 || v != floor(v)) fail(field, "must be a whole number 0..65535");
+    return (uint16_t)v;
+}
+
+static void parse_rule(rule_src_t *r) {
+    char key[64], when[512] = "";
+    js_expect('{');
+    if (js_peek('}')) fail("empty rule", js);
+    do {
+        js_string(key, sizeof(key));
+        js_expect(':');
+        if (!strcmp(key, "name")) {
+            js_string(r->name, sizeof(r->name));
+        } else if (!strcmp(key, "when")) {
+            js_string(when, sizeof(when));
+        } else if (!strcmp(key, "for_s")) {
+            r->for_s = as_u16(js_number(), "for_s");
+        } else if (!strcmp(key, "cooldown_s")) {
+            r->cooldown_s = as_u16(js_number(), "cooldown_s");
+        } else if (!strcmp(key, "max_fires")) {
+            double v = js_number();
+            if (v < 0 || v > 255 || v != floor(v)) fail("max_fires must be 0..255", NULL);
+            r->max_fires = (uint8_t)v;
+        } else if (!strcmp(key, "actions")) {
+            js_expect('[');
+            if (!js_peek(']')) {
+                do {
+                    char a[32];
+                    size_t i;
+                    js_string(a, sizeof(a));
+                    for (i = 0; i < sizeof(action_names) / sizeof(action_names[0]); i++) {
+                        if (!strcmp(a, action_names[i].name)) break;
+                    }
+                    if (i == sizeof(action_names) / sizeof(action_names[0])) fail("unknown action", a);
+                    r->actions |= action_names[i].bit;
+                    js_ws();
+                } while (*js == ',' && js++);
+            }
+            js_expect(']');
+        } else {
+            js_skip();   // comments / future fields
+        }
+        js_ws();
+    } while (*js == ',' && js++);
+    js_expect('}');
+
+    if (!r->name[0]) fail("rule without a name", NULL);
+    if (!when[0]) fail("rule without a \"when\"", r->name);
+    compile_expr(r, when);
+}
+
+static void parse_settings(const char *text) {
+    js = text;
+    js_expect('{');
+    if (js_peek('}')) return;
+    do {
+        char key[64];
+        js_string(key, sizeof(key));
+        js_expect(':');
+        if (strcmp(key, "alerts")) {
+            js_skip();
+        } else {
+            js_expect('[');
+            if (!js_peek(']')) {
+                do {
+                    if (rule_count == ALERT_MAX_RULES) fail("too many rules", NULL);
+                    parse_rule(&rules_src[rule_count++]);
+                    js_ws();
+                } while (*js == ',' && js++);
+            }
+            js_expect(']');
+        }
+        js_ws();
+    } while (*js == ',' && js++);
+    js_expect('}');
+}
+
+// ---------------- Blob builder ---------------- //
+static uint32_t build_blob(uint8_t *out, const rule_src_t *src, int n) {
+    alert_blob_hdr_t h = {.magic = ALERT_MAGIC, .version = ALERT_VERSION, .rule_count = (uint16_t)n};
+    uint32_t pos = sizeof(h) + n * sizeof(alert_rule_t);
+    h.index_off = (uint16_t)pos;
+
+    uint16_t *index = (uint16_t *)(out + pos);
+    uint32_t entries = 0;
+    for (int s = 0; s < ALERT_SIGNALS; s++) {
+        h.sig_start[s] = (uint16_t)entries;
+        for (int i = 0; i < n; i++) {
+            if (src[i].signals & (1u << s)) index[entries++] = (uint16_t)i;
+        }
+    }
+    h.sig_start[ALERT_SIGNALS] = (uint16_t)entries;
+    pos += entries * 2;
+
+    alert_rule_t *r = (alert_rule_t *)(out + sizeof(h));
+    for (int i = 0; i < n; i++) {
+        if (pos + src[i].code_len > ALERT_BLOB_MAX) fail("rules exceed the 16 KB blob", NULL);
+        r[i] = (alert_rule_t){
+            .code_off = (uint16_t)pos, .for_s = src[i].for_s, .cooldown_s = src[i].cooldown_s,
+            .max_fires = src[i].max_fires, .actions = src[i].actions,
+            .signals = src[i].signals, .code_len = src[i].code_len,
+        };
+        memcpy(out + pos, src[i].code, src[i].code_len);
+        pos += src[i].code_len;
+    }
+    for (int i = 0; i < n; i++) {
+        size_t len = strlen(src[i].name) + 1;
+        if (pos + len > ALERT_BLOB_MAX) fail("rules exceed the 16 KB blob", NULL);
+        r[i].name_off = (uint16_t)pos;
+        memcpy(out + pos, src[i].name, len);
+        pos += len;
+    }
+    while (pos & 3) out[pos++] = 0;
+
+    h.total_len = pos;
+    memcpy(out, &h, sizeof(h));
+    h.crc = crc32(out + 16, pos - 16);
+    memcpy(out, &h, sizeof(h));
+    return pos;
+}
+
+// ---------------- Outputs ---------------- //
+static void write_header(const char *path, const uint8_t *blob, uint32_t len, const char *source) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+    fprintf(f, "// ---------------- alert_rules_default.h ---------------- //\n");
+    fprintf(f, "// Built-in alert rules, generated from %s by tools/alert_compiler -c.\n", source);
+    fprintf(f, "// %d rules, %u bytes. Do not edit; change the settings file and regenerate.\n", rule_count, len);
+    fprintf(f, "#ifndef ALERT_RULES_DEFAULT_H\n#define ALERT_RULES_DEFAULT_H\n\n#include <stdint.h>\n\n");
+    fprintf(f, "static const uint8_t alert_rules_default[%u] __attribute__((aligned(4))) = {", len);
+    for (uint32_t i = 0; i < len; i++) fprintf(f, "%s0x%02x,", i % 12 ? " " : "\n    ", blob[i]);
+    fprintf(f, "\n};\n\n#endif // ALERT_RULES_DEFAULT_H\n");
+    fclose(f);
+}
+
+static void print_hex(const uint8_t *blob, uint32_t len) {
+    for (uint32_t i = 0; i < len; i++) printf("%02x%s", blob[i], (i % 32 == 31 || i == len - 1) ? "\n" : "");
+    printf("\n");
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Repeats the file's rules up to `target` and feeds every signal in turn
+static void benchmark(int target) {
+    static rule_src_t many[ALERT_MAX_RULES];
+    static uint8_t blob[ALERT_BLOB_MAX];
+    static alert_engine_t e;
+    if (target > ALERT_MAX_RULES) target = ALERT_MAX_RULES;
+    for (int i = 0; i < target; i++) many[i] = rules_src[i % rule_count];
+    uint32_t len = build_blob(blob, many, target);
+    if (!alert_load(&e, blob, len)) fail("benchmark blob failed to load", NULL);
+
+    const int rounds = 200000;
+    uint64_t evaluated = 0;
+    double t0 = now_s();
+    for (int i = 0; i < rounds; i++) {
+        uint8_t sig = (uint8_t)(i % ALERT_SIGNALS);
+        evaluated += alert_sample(&e, sig, (i * 37) % 4000, (uint32_t)i * 100, NULL);
+    }
+    double dt = now_s() - t0;
+    printf("benchmark: %d rules, %u bytes, %.1f rules/sample, %.0f ns/sample, %.1f ns/rule\n",
+           target, len, (double)evaluated / rounds, dt * 1e9 / rounds, evaluated ? dt * 1e9 / evaluated : 0.0);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [-o rules.bin] [-c header.h] [-x] [-b rules] settings.json\n", prog);
+}
+
+int main(int argc, char **argv) {
+    const char *bin_path = NULL, *hdr_path = NULL;
+    bool hex = false;
+    int bench = 0, opt;
+    while ((opt = getopt(argc, argv, "o:c:xb:")) != -1) {
+        switch (opt) {
+        case 'o': bin_path = optarg; break;
+        case 'c': hdr_path = optarg; break;
+        case 'x': hex = true; break;
+        case 'b': bench = atoi(optarg); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    FILE *f = fopen(argv[optind], "rb");
+    if (!f) {
+        perror(argv[optind]);
+        return 1;
+    }
+    static char text[256 * 1024];
+    size_t n = fread(text, 1, sizeof(text) - 1, f);
+    fclose(f);
+    text[n] = '\0';
+    parse_settings(text);
+
+    static uint8_t blob[ALERT_BLOB_MAX];
+    uint32_t len = build_blob(blob, rules_src, rule_count);
+    static alert_engine_t check;
+    if (!alert_load(&check, blob, len)) fail("compiled blob did not verify", NULL);
+    fprintf(stderr, "%d rules, %u bytes\n", rule_count, len);
+
+    if (bin_path) {
+        FILE *o = fopen(bin_path, "wb");
+        if (!o || fwrite(blob, 1, len, o) != len) {
+            perror(bin_path);
+            return 1;
+        }
+        fclose(o);
+    }
+    if (hdr_path) write_header(hdr_path, blob, len, "config/irrigation-settings.json");
+    if (hex) print_hex(blob, len);
+    if (bench > 0 && rule_count > 0) benchmark(bench);
+    return 0;
+}
+
+// End of alert_compiler.c
@@ -0,0 +1,157 @@
+// ---------------- alert_test.c ---------------- //
+/*
+ * Host test for the alert evaluator (alert_rules.c) with the built-in
+ * rules (alert_rules_default.h). Checks that the handler sees raises and
+ * clears strictly paired per rule, the way watering_system_main.c's
+ * alert_action() counts LED_ALERT holders:
+ *   - a condition that stays true raises once, not on every sample,
+ *   - every clear follows a raise, and the LED count returns to zero,
+ *   - a long random run over all signals never breaks the pairing,
+ * and that the loader rejects blobs whose header lies about their length.
+ *
+ * Build:  cc -O2 -I.. alert_test.c ../alert_rules.c ../checksum.c -o alert_test
+ * Usage:  alert_test [-n samples] [-s seed]      exit 1 on a failure
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "alert_rules.h"
+#include "alert_rules_default.h"
+
+static alert_engine_t alerts;
+static bool raised[ALERT_MAX_RULES];
+static int led_holders, raises, clears, failures;
+static uint32_t now_ms;
+
+static void check(bool ok, const char *what) {
+    if (ok) return;
+    printf("FAIL: %s (t=%lu ms)\n", what, (unsigned long)now_ms);
+    failures++;
+}
+
+static int rule_index(const char *name) {
+    for (uint16_t i = 0; i < alert_rule_count(&alerts); i++) {
+        if (!strcmp(alert_rule_name(&alerts, i), name)) return i;
+    }
+    return -1;
+}
+
+// Same bookkeeping as alert_action() for ALERT_LED
+static void sink(const char *name, uint8_t actions, bool up) {
+    int i = rule_index(name);
+    check(i >= 0, "handler called with an unknown rule");
+    if (i < 0) return;
+    check(raised[i] != up, up ? "raised while already raised" : "cleared while not raised");
+    raised[i] = up;
+    if (up) raises++;
+    else clears++;
+    if (actions & ALERT_LED) led_holders += up ? 1 : -1;
+    check(led_holders >= 0, "LED holder count went negative");
+}
+
+static void sample(uint8_t sig, int32_t value_x10) {
+    alert_sample(&alerts, sig, value_x10, now_ms, sink);
+    now_ms += 1000;
+}
+
+static void reset(void) {
+    alert_load(&alerts, alert_rules_default, sizeof(alert_rules_default));
+    memset(raised, 0, sizeof(raised));
+    led_holders = raises = clears = 0;
+    now_ms = 0;
+}
+
+static void test_held_condition(void) {
+    reset();
+    for (int i = 0; i < 10; i++) {
+        sample(SIG_INTRUSION, 10);
+        // Level, not edge: asked on every sample, not only the one that raised
+        check(alert_raised_action(&alerts, ALERT_STOP) != NULL, "INTRUSION held but no stop rule raised");
+    }
+    check(raises == 1, "10 INTRUSION samples should raise once");
+    check(led_holders == 1, "one LED holder while INTRUSION is raised");
+    sample(SIG_INTRUSION, 0);
+    check(clears == 1 && led_holders == 0, "INTRUSION clear should release the LED");
+    check(alert_raised_action(&alerts, ALERT_STOP) == NULL, "stop rule still raised after INTRUSION cleared");
+    sample(SIG_INTRUSION, 10);
+    check(raises == 2, "INTRUSION should raise again after clearing");
+
+    // Cooldown 60 s, max 3: holding for 10 minutes is still one raise
+    reset();
+    sample(SIG_HUM, 400);
+    for (int i = 0; i < 600; i++) sample(SIG_TEMP, 350);
+    check(raises == 1, "Temp/Humidity held for 10 min should raise once");
+}
+
+// Header claims fewer bytes than the header itself, or more than given
+static void test_bad_length(void) {
+    static uint8_t blob[sizeof(alert_rules_default)] __attribute__((aligned(4)));
+    alert_blob_hdr_t *h = (alert_blob_hdr_t *)blob;
+    static const uint32_t lens[] = {0, 4, 15, 16, sizeof(alert_blob_hdr_t) - 1, sizeof(blob) + 1};
+    for (size_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+        memcpy(blob, alert_rules_default, sizeof(blob));
+        h->total_len = lens[i];
+        check(!alert_load(&alerts, blob, sizeof(blob)), "blob with a bad total_len loaded");
+    }
+}
+
+static void test_random(long n, uint32_t seed) {
+    reset();
+    for (long k = 0; k < n; k++) {
+        seed = seed * 1664525u + 1013904223u;
+        uint8_t sig = (uint8_t)((seed >> 16) % ALERT_SIGNALS);
+        int32_t v;
+        switch (sig) {
+        case SIG_SOIL:      v = (int32_t)((seed >> 8) % 4096) * 10; break;
+        case SIG_TEMP:      v = 200 + (int32_t)((seed >> 8) % 150); break;
+        case SIG_HUM:       v = 400 + (int32_t)((seed >> 8) % 400); break;
+        case SIG_CYCLES:    v = (int32_t)((seed >> 8) % 40) * 10; break;
+        default:            v = ((seed >> 12) & 7) == 0 ? 10 : 0; break;
+        }
+        sample(sig, v);
+    }
+    int open = 0;
+    for (uint16_t i = 0; i < alert_rule_count(&alerts); i++) {
+        check(raised[i] == alert_rule_raised(&alerts, i), "handler and engine disagree on a rule");
+        open += raised[i];
+    }
+
+    // Values that clear every built-in rule
+    for (int i = 0; i < ALERT_SIGNALS; i++) sample((uint8_t)i, i == SIG_SOIL ? 40950 : 0);
+    check(raises == clears, "raises and clears do not pair up");
+    check(led_holders == 0, "LED holders left after every rule cleared");
+    printf("random: %ld samples, %d raises, %d clears, %d raised before the final clear\n", n, raises, clears,
+           open);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "usage: %s [-n samples] [-s seed]\n"
+        "  -n samples  length of the random run (default 200000)\n"
+        "  -s seed     random seed\n", prog);
+}
+
+int main(int argc, char **argv) {
+    long n = 200000;
+    uint32_t seed = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:h")) != -1) {
+        switch (opt) {
+        case 'n': n = atol(optarg); break;
+        case 's': seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (!alert_load(&alerts, alert_rules_default, sizeof(alert_rules_default))) {
+        printf("FAIL: built-in rules do not load\n");
+        return 1;
+    }
+    test_bad_length();
+    test_held_condition();
+    test_random(n, seed);
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
+
+// End of alert_test.c
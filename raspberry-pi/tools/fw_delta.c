@@ -0,0 +1,548 @@
+// ---------------- fw_delta.c ---------------- //
+/*
+ * Host tool for delta firmware updates (fw_patch.h, fw_update.h).
+ *
+ * Build:  cc -O2 -I.. fw_delta.c ../fw_patch.c ../checksum.c -o fw_delta
+ * Usage:  fw_delta diff  old.bin new.bin patch.fwd    make a patch
+ *         fw_delta apply old.bin patch.fwd out.bin    rebuild + verify on the host
+ *         fw_delta send  patch.fwd /dev/ttyACM0       push it over the USB CLI
+ *         fw_delta bench old.bin new.bin              size / speed report
+ *
+ * old.bin is the image currently in slot A (the .bin of the running build),
+ * new.bin the build to install; both linked for SLOT_A_OFFSET.
+ *
+ * Matching is bsdiff-like: exact seeds from a hash of 8-byte runs, then
+ * extended forwards and backwards while at least half the bytes agree, so
+ * code that only moved or had a few addresses change becomes an 'A' copy
+ * with a mostly-zero diff. The command stream is then LZSS-compressed with
+ * the same 1 KB window the device decodes with.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include "fw_patch.h"
+#include "fw_update.h"
+
+#define SEED        8       // bytes hashed per old-image position
+#define MIN_COPY    16      // shortest exact seed worth a copy
+#define MIN_RUN     8       // shortest exact run split out as 'C'
+#define CHAIN_LIMIT 64      // candidates tried per position
+#define HASH_BITS   18
+
+typedef struct {
+    uint8_t *data;
+    size_t len, cap;
+} buf_t;
+
+static void buf_put(buf_t *b, const void *p, size_t n) {
+    if (b->len + n > b->cap) {
+        b->cap = (b->len + n) * 2 + 1024;
+        b->data = realloc(b->data, b->cap);
+        if (!b->data) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+    memcpy(b->data + b->len, p, n);
+    b->len += n;
+}
+
+static void buf_byte(buf_t *b, uint8_t c) {
+    buf_put(b, &c, 1);
+}
+
+static void buf_varint(buf_t *b, uint32_t v) {
+    while (v >= 0x80) {
+        buf_byte(b, (uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    buf_byte(b, (uint8_t)v);
+}
+
+static uint8_t *read_file(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *d = malloc(n > 0 ? n : 1);
+    if (!d || fread(d, 1, n, f) != (size_t)n) {
+        perror(path);
+        exit(1);
+    }
+    fclose(f);
+    *len = n;
+    return d;
+}
+
+static void write_file(const char *path, const void *d, size_t n) {
+    FILE *f = fopen(path, "wb");
+    if (!f || fwrite(d, 1, n, f) != n) {
+        perror(path);
+        exit(1);
+    }
+    fclose(f);
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void sha(const uint8_t *d, size_t n, uint8_t out[32]) {
+    sha256_t s;
+    sha256_init(&s);
+    sha256_update(&s, d, n);
+    sha256_final(&s, out);
+}
+
+// ---------------- Diff ---------------- //
+static uint32_t seed_hash(const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return (uint32_t)((v * 0x9E3779B97F4A7C15ull) >> (64 - HASH_BITS));
+}
+
+typedef struct {
+    buf_t *out;
+    const uint8_t *old, *new_;
+    uint32_t prev_end;   // old position after the last 'A'
+} cmds_t;
+
+static void emit_insert(cmds_t *c, size_t from, size_t n) {
+    if (!n) return;
+    buf_byte(c->out, 'I');
+    buf_varint(c->out, (uint32_t)n);
+    buf_put(c->out, c->new_ + from, n);
+}
+
+// One 'C'/'A' command over old[old_pos..] -> new[new_pos..]
+static void emit_copy(cmds_t *c, uint8_t cmd, size_t old_pos, size_t new_pos, size_t n) {
+    int32_t rel = (int32_t)(old_pos - c->prev_end);
+    buf_byte(c->out, cmd);
+    buf_varint(c->out, (uint32_t)(rel << 1) ^ (uint32_t)(rel >> 31));
+    buf_varint(c->out, (uint32_t)n);
+    if (cmd == 'A') {
+        for (size_t i = 0; i < n; i++) buf_byte(c->out, (uint8_t)(c->new_[new_pos + i] - c->old[old_pos + i]));
+    }
+    c->prev_end = (uint32_t)(old_pos + n);
+}
+
+// An approximate match, split into exact runs ('C', no data) and the
+// stretches between them ('A', diff bytes)
+static void emit_add(cmds_t *c, size_t old_pos, size_t new_pos, size_t n) {
+    size_t i = 0, diff_from = 0;
+    while (i < n) {
+        size_t run = 0;
+        while (i + run < n && c->old[old_pos + i + run] == c->new_[new_pos + i + run]) run++;
+        if (run >= MIN_RUN || i + run == n) {
+            if (i > diff_from) emit_copy(c, 'A', old_pos + diff_from, new_pos + diff_from, i - diff_from);
+            if (run) emit_copy(c, 'C', old_pos + i, new_pos + i, run);
+            i += run;
+            diff_from = i;
+        } else {
+            i += run + 1;
+        }
+    }
+    if (n > diff_from) emit_copy(c, 'A', old_pos + diff_from, new_pos + diff_from, n - diff_from);
+}
+
+// Longest prefix where 2 * matches - length peaks (bsdiff's extension rule)
+static size_t extend_fwd(const uint8_t *a, const uint8_t *b, size_t max) {
+    long score = 0, best = 0;
+    size_t best_len = 0;
+    for (size_t i = 0; i < max; i++) {
+        score += a[i] == b[i] ? 1 : -1;
+        if (score > best) {
+            best = score;
+            best_len = i + 1;
+        }
+        if (score < best - 16) break;
+    }
+    return best_len;
+}
+
+static size_t extend_back(const uint8_t *a, const uint8_t *b, size_t max) {
+    long score = 0, best = 0;
+    size_t best_len = 0;
+    for (size_t i = 1; i <= max; i++) {
+        score += a[-(long)i] == b[-(long)i] ? 1 : -1;
+        if (score > best) {
+            best = score;
+            best_len = i;
+        }
+        if (score < best - 16) break;
+    }
+    return best_len;
+}
+
+static void make_commands(const uint8_t *old, size_t old_n, const uint8_t *new_, size_t new_n, buf_t *out) {
+    int32_t *head = malloc(sizeof(int32_t) << HASH_BITS);
+    int32_t *next = malloc(sizeof(int32_t) * (old_n + 1));
+    if (!head || !next) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    memset(head, 0xFF, sizeof(int32_t) << HASH_BITS);
+    for (size_t i = 0; i + SEED <= old_n; i++) {
+        uint32_t h = seed_hash(old + i);
+        next[i] = head[h];
+        head[h] = (int32_t)i;
+    }
+
+    cmds_t c = {.out = out, .old = old, .new_ = new_};
+    size_t pos = 0, lit = 0;    // literals pending from `lit` to `pos`
+    long delta = 0;             // old - new offset of the last copy
+    while (pos < new_n) {
+        size_t best_len = 0, best_old = 0;
+
+        // Same shift as the last copy first: catches edited code in place
+        long guess = (long)pos + delta;
+        if (guess >= 0 && (size_t)guess < old_n) {
+            size_t max = old_n - guess < new_n - pos ? old_n - guess : new_n - pos;
+            size_t n = 0;
+            while (n < max && old[guess + n] == new_[pos + n]) n++;
+            if (n >= MIN_COPY) {
+                best_len = n;
+                best_old = (size_t)guess;
+            }
+        }
+        if (!best_len && pos + SEED <= new_n) {
+            int tries = CHAIN_LIMIT;
+            for (int32_t o = head[seed_hash(new_ + pos)]; o >= 0 && tries--; o = next[o]) {
+                size_t max = old_n - o < new_n - pos ? old_n - o : new_n - pos;
+                size_t n = 0;
+                while (n < max && old[o + n] == new_[pos + n]) n++;
+                if (n > best_len) {
+                    best_len = n;
+                    best_old = (size_t)o;
+                }
+            }
+            if (best_len < MIN_COPY) best_len = 0;
+        }
+        if (!best_len) {
+            pos++;
+            continue;
+        }
+
+        size_t back_max = pos - lit < best_old ? pos - lit : best_old;
+        size_t back = extend_back(old + best_old, new_ + pos, back_max);
+        size_t fwd_max = old_n - best_old < new_n - pos ? old_n - best_old : new_n - pos;
+        size_t len = best_len + extend_fwd(old + best_old + best_len, new_ + pos + best_len, fwd_max - best_len);
+
+        emit_insert(&c, lit, pos - back - lit);
+        emit_add(&c, best_old - back, pos - back, back + len);
+        delta = (long)best_old - (long)pos;
+        pos += len;
+        lit = pos;
+    }
+    emit_insert(&c, lit, new_n - lit);
+    free(head);
+    free(next);
+}
+
+// ---------------- LZSS (matches fwp_feed) ---------------- //
+#define LZ_HASH_BITS 12
+
+static void lzss(const uint8_t *in, size_t n, buf_t *out) {
+    int32_t head[1 << LZ_HASH_BITS];
+    int32_t *prev = malloc(sizeof(int32_t) * (n + 1));
+    if (!prev) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    memset(head, 0xFF, sizeof(head));
+
+    size_t flag_at = 0;
+    int bit = 8;
+    for (size_t i = 0; i < n;) {
+        if (bit == 8) {
+            flag_at = out->len;
+            buf_byte(out, 0);
+            bit = 0;
+        }
+        size_t best = 0, best_off = 0;
+        if (i + FWP_MIN_MATCH <= n) {
+            uint32_t h = ((in[i] << 8 | in[i + 1]) * 31 + in[i + 2]) & ((1 << LZ_HASH_BITS) - 1);
+            int tries = 32;
+            for (int32_t j = head[h]; j >= 0 && i - j <= FWP_WINDOW && tries--; j = prev[j]) {
+                size_t max = n - i < FWP_MAX_MATCH ? n - i : FWP_MAX_MATCH;
+                size_t k = 0;
+                while (k < max && in[j + k] == in[i + k]) k++;   // overlap is fine, as in the decoder
+                if (k > best) {
+                    best = k;
+                    best_off = i - j;
+                    if (k == FWP_MAX_MATCH) break;
+                }
+            }
+        }
+        size_t step = best >= FWP_MIN_MATCH ? best : 1;
+        if (best >= FWP_MIN_MATCH) {
+            uint16_t token = (uint16_t)((best - FWP_MIN_MATCH) << FWP_WINDOW_BITS | (best_off - 1));
+            buf_byte(out, (uint8_t)token);
+            buf_byte(out, (uint8_t)(token >> 8));
+        } else {
+            out->data[flag_at] |= (uint8_t)(1u << bit);
+            buf_byte(out, in[i]);
+        }
+        bit++;
+        for (size_t s = 0; s < step; s++, i++) {
+            if (i + FWP_MIN_MATCH <= n) {
+                uint32_t h = ((in[i] << 8 | in[i + 1]) * 31 + in[i + 2]) & ((1 << LZ_HASH_BITS) - 1);
+                prev[i] = head[h];
+                head[h] = (int32_t)i;
+            }
+        }
+    }
+    free(prev);
+}
+
+static void make_patch(const uint8_t *old, size_t old_n, const uint8_t *new_, size_t new_n, buf_t *patch) {
+    buf_t cmds = {0};
+    make_commands(old, old_n, new_, new_n, &cmds);
+
+    fw_patch_hdr_t h = {.magic = FWP_MAGIC, .old_size = (uint32_t)old_n, .new_size = (uint32_t)new_n};
+    sha(old, old_n, h.old_sha);
+    sha(new_, new_n, h.new_sha);
+    buf_put(patch, &h, sizeof(h));
+    lzss(cmds.data, cmds.len, patch);
+    ((fw_patch_hdr_t *)patch->data)->body_len = (uint32_t)(patch->len - sizeof(h));
+    free(cmds.data);
+}
+
+// ---------------- Apply ---------------- //
+typedef struct {
+    uint8_t *out;
+    size_t cap;
+    uint32_t pages;
+} host_sink_t;
+
+static bool host_sink(void *ctx, uint32_t offset, const uint8_t *page) {
+    host_sink_t *s = ctx;
+    size_t n = offset + FWP_PAGE <= s->cap ? FWP_PAGE : s->cap - offset;
+    memcpy(s->out + offset, page, n);
+    s->pages++;
+    return true;
+}
+
+static const char *fwp_error(int status) {
+    switch (status) {
+    case FWP_DONE: return "ok";
+    case FWP_ERR_FORMAT: return "bad patch format";
+    case FWP_ERR_RANGE: return "patch out of range";
+    case FWP_ERR_SINK: return "write failed";
+    case FWP_ERR_HASH: return "hash mismatch";
+    default: return "incomplete patch";
+    }
+}
+
+static int apply_patch(const uint8_t *old, size_t old_n, const uint8_t *patch, size_t patch_n,
+                       uint8_t *out, uint32_t *pages) {
+    const fw_patch_hdr_t *h = (const fw_patch_hdr_t *)patch;
+    if (patch_n < sizeof(*h) || h->magic != FWP_MAGIC || h->body_len != patch_n - sizeof(*h)) return FWP_ERR_FORMAT;
+    uint8_t digest[32];
+    sha(old, old_n, digest);
+    if (old_n != h->old_size || memcmp(digest, h->old_sha, 32)) return FWP_ERR_HASH;
+
+    static fwp_t p;
+    host_sink_t s = {.out = out, .cap = h->new_size};
+    fwp_init(&p, h, old, host_sink, &s);
+    fwp_feed(&p, patch + sizeof(*h), h->body_len);
+    int r = fwp_finish(&p);
+    if (pages) *pages = s.pages;
+    return r;
+}
+
+// ---------------- Send ---------------- //
+static int serial_open(const char *dev) {
+    int fd = open(dev, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        perror(dev);
+        exit(1);
+    }
+    struct termios t;
+    tcgetattr(fd, &t);
+    cfmakeraw(&t);
+    cfsetspeed(&t, B115200);   // ignored by USB CDC
+    tcsetattr(fd, TCSANOW, &t);
+    tcflush(fd, TCIOFLUSH);
+    return fd;
+}
+
+// Reads lines until one starts with "UPD "; other tasks' console output is skipped
+static bool serial_reply(int fd, char *line, size_t cap, int timeout_ms) {
+    size_t n = 0;
+    double deadline = now_s() + timeout_ms / 1000.0;
+    while (now_s() < deadline) {
+        fd_set rd;
+        FD_ZERO(&rd);
+        FD_SET(fd, &rd);
+        struct timeval tv = {0, 100000};
+        if (select(fd + 1, &rd, NULL, NULL, &tv) <= 0) continue;
+        char c;
+        if (read(fd, &c, 1) != 1) continue;
+        if (c == '\r') continue;
+        if (c != '\n') {
+            if (n + 1 < cap) line[n++] = c;
+            continue;
+        }
+        line[n] = '\0';
+        if (!strncmp(line, "UPD ", 4)) return true;
+        n = 0;
+    }
+    return false;
+}
+
+static int send_patch(const uint8_t *patch, size_t patch_n, const char *dev) {
+    int fd = serial_open(dev);
+    char line[160];
+    if (write(fd, "update\r", 7) != 7 || !serial_reply(fd, line, sizeof(line), 3000) || strncmp(line, "UPD READY", 9)) {
+        fprintf(stderr, "device did not enter update mode\n");
+        return 1;
+    }
+    fprintf(stderr, "%s\n", line);
+
+    double t0 = now_s();
+    size_t sent = 0, retries = 0;
+    while (sent < patch_n) {
+        // The header travels alone in the first frame
+        size_t n = sent == 0 ? sizeof(fw_patch_hdr_t) : patch_n - sent;
+        if (n > FWU_FRAME_MAX) n = FWU_FRAME_MAX;
+        uint8_t frame[FWU_FRAME_MAX + 6];
+        frame[0] = (uint8_t)n;
+        frame[1] = (uint8_t)(n >> 8);
+        memcpy(frame + 2, patch + sent, n);
+        uint32_t crc = crc32(frame + 2, n);
+        memcpy(frame + 2 + n, &crc, 4);
+        if (write(fd, frame, n + 6) != (ssize_t)(n + 6) || !serial_reply(fd, line, sizeof(line), 5000)) {
+            fprintf(stderr, "\nlink timeout at %zu/%zu bytes\n", sent, patch_n);
+            return 1;
+        }
+        if (!strncmp(line, "UPD NAK", 7) && ++retries < 10) continue;
+        if (strncmp(line, "UPD ACK", 7)) {
+            fprintf(stderr, "\n%s\n", line);
+            return 1;
+        }
+        sent += n;
+        fprintf(stderr, "\r%zu/%zu bytes", sent, patch_n);
+    }
+    double dt = now_s() - t0;
+    fprintf(stderr, "\nsent %zu bytes in %.2f s (%.1f KB/s, %zu resends)\n", patch_n, dt, patch_n / dt / 1024, retries);
+
+    // Final verdict after the device re-hashes slot B
+    if (!serial_reply(fd, line, sizeof(line), 20000)) {
+        fprintf(stderr, "no result from device\n");
+        return 1;
+    }
+    fprintf(stderr, "%s\n", line);
+    close(fd);
+    return strncmp(line, "UPD OK", 6) ? 1 : 0;
+}
+
+// ---------------- Bench ---------------- //
+static int bench(const uint8_t *old, size_t old_n, const uint8_t *new_, size_t new_n) {
+    buf_t patch = {0};
+    double t0 = now_s();
+    make_patch(old, old_n, new_, new_n, &patch);
+    double t_diff = now_s() - t0;
+
+    uint8_t *out = malloc(new_n + FWP_PAGE);
+    uint32_t pages = 0;
+    const int rounds = 20;
+    int r = FWP_DONE;
+    t0 = now_s();
+    for (int i = 0; i < rounds && r == FWP_DONE; i++) r = apply_patch(old, old_n, patch.data, patch.len, out, &pages);
+    double t_apply = (now_s() - t0) / rounds;
+    if (r != FWP_DONE || memcmp(out, new_, new_n)) {
+        fprintf(stderr, "round trip failed: %s\n", fwp_error(r));
+        return 1;
+    }
+
+    uint32_t sectors = (uint32_t)((new_n + FLASH_SECTOR_SIZE - 1) / FLASH_SECTOR_SIZE);
+    // Boot-time swap only exchanges sectors that differ between the slots
+    size_t span = old_n > new_n ? old_n : new_n;
+    uint32_t swapped = 0;
+    for (size_t off = 0; off < span; off += FLASH_SECTOR_SIZE) {
+        size_t n = FLASH_SECTOR_SIZE;
+        if (off + n > old_n || off + n > new_n || memcmp(old + off, new_ + off, n)) swapped++;
+    }
+    uint32_t frames = (uint32_t)((patch.len - sizeof(fw_patch_hdr_t) + FWU_FRAME_MAX - 1) / FWU_FRAME_MAX) + 1;
+    printf("old image      %8zu bytes\n", old_n);
+    printf("new image      %8zu bytes\n", new_n);
+    printf("patch          %8zu bytes (%.2f%% of the new image)\n", patch.len, 100.0 * patch.len / new_n);
+    printf("link frames    %8u x %d bytes max\n", frames, FWU_FRAME_MAX);
+    printf("flash writes   %8u pages, %u sector erases in slot B\n", pages, sectors);
+    printf("boot swap      %8u of %zu sectors differ (3 erases each)\n", swapped, (span + FLASH_SECTOR_SIZE - 1) / FLASH_SECTOR_SIZE);
+    printf("diff           %8.1f ms\n", t_diff * 1e3);
+    printf("apply (host)   %8.2f ms, %.1f MB/s of new image\n", t_apply * 1e3, new_n / t_apply / 1e6);
+    free(out);
+    free(patch.data);
+    return 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "usage: %s diff old.bin new.bin patch.fwd\n"
+        "       %s apply old.bin patch.fwd out.bin\n"
+        "       %s send patch.fwd /dev/ttyACM0\n"
+        "       %s bench old.bin new.bin\n", prog, prog, prog, prog);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return 2;
+    }
+    const char *cmd = argv[1];
+    size_t a_n, b_n;
+
+    if (!strcmp(cmd, "diff") && argc == 5) {
+        uint8_t *old = read_file(argv[2], &a_n), *new_ = read_file(argv[3], &b_n);
+        if (b_n > SLOT_BYTES) {
+            fprintf(stderr, "new image (%zu bytes) does not fit a %u byte slot\n", b_n, (unsigned)SLOT_BYTES);
+            return 1;
+        }
+        buf_t patch = {0};
+        make_patch(old, a_n, new_, b_n, &patch);
+        write_file(argv[4], patch.data, patch.len);
+        fprintf(stderr, "%zu -> %zu bytes, patch %zu bytes (%.2f%%)\n", a_n, b_n, patch.len, 100.0 * patch.len / b_n);
+        return 0;
+    }
+    if (!strcmp(cmd, "apply") && argc == 5) {
+        uint8_t *old = read_file(argv[2], &a_n), *patch = read_file(argv[3], &b_n);
+        const fw_patch_hdr_t *h = (const fw_patch_hdr_t *)patch;
+        if (b_n < sizeof(*h)) {
+            fprintf(stderr, "not a patch\n");
+            return 1;
+        }
+        uint8_t *out = malloc(h->new_size + FWP_PAGE);
+        int r = apply_patch(old, a_n, patch, b_n, out, NULL);
+        if (r != FWP_DONE) {
+            fprintf(stderr, "apply failed: %s\n", fwp_error(r));
+            return 1;
+        }
+        write_file(argv[4], out, h->new_size);
+        return 0;
+    }
+    if (!strcmp(cmd, "send") && argc == 4) {
+        uint8_t *patch = read_file(argv[2], &a_n);
+        return send_patch(patch, a_n, argv[3]);
+    }
+    if (!strcmp(cmd, "bench") && argc == 4) {
+        uint8_t *old = read_file(argv[2], &a_n), *new_ = read_file(argv[3], &b_n);
+        return bench(old, a_n, new_, b_n);
+    }
+    usage(argv[0]);
+    return 2;
+}
+
+// End of fw_delta.c
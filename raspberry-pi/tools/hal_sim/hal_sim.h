@@ -0,0 +1,85 @@
+// ---------------- hal_sim.h ---------------- //
+/*
+ * Host stand-in for the parts of the Pico SDK that the hardware-free
+ * modules and the small drivers (lcd.c, topology.h) call. Build host
+ * tools with -Ihal_sim and "pico/stdlib.h", "hardware/i2c.h", ... resolve
+ * here instead of the SDK.
+ *
+ * Nothing waits: sleeps and I2C transfers advance a simulated clock
+ * (hal_sim.wait_us) by the time the device would spend in them, and bus
+ * traffic is counted, so tools can report both host CPU time and what
+ * the real bus would cost. Set hal_sim.adc[] / hal_sim.gpio_in to feed
+ * inputs; hal_sim.i2c_tap sees every write (e.g. a display model).
+ */
+#ifndef HAL_SIM_H
+#define HAL_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef unsigned int uint;
+
+#define GPIO_IN  false
+#define GPIO_OUT true
+#define PICO_ERROR_GENERIC -1
+
+typedef struct {
+    uint baudrate;
+} i2c_inst_t;
+
+typedef void (*hal_i2c_tap_fn)(uint8_t addr, const uint8_t *src, size_t len);
+
+typedef struct {
+    uint32_t gpio_out;          // levels driven by gpio_put
+    uint32_t gpio_in;           // levels returned by gpio_get for inputs
+    uint32_t gpio_dir;          // 1 = output
+    uint16_t adc[5];            // value adc_read() returns per channel
+    uint adc_input;
+    uint64_t i2c_writes;
+    uint64_t i2c_bytes;         // payload bytes, address byte excluded
+    double wait_us;             // simulated sleeps + bus time
+    hal_i2c_tap_fn i2c_tap;
+} hal_sim_t;
+
+extern hal_sim_t hal_sim;
+extern i2c_inst_t hal_sim_i2c0, hal_sim_i2c1;
+
+#define i2c0 (&hal_sim_i2c0)
+#define i2c1 (&hal_sim_i2c1)
+
+void hal_sim_reset(void);        // clear counters and the clock, keep inputs
+
+// ---------------- pico/stdlib.h ---------------- //
+static inline void sleep_ms(uint32_t ms) { hal_sim.wait_us += ms * 1000.0; }
+static inline void sleep_us(uint64_t us) { hal_sim.wait_us += (double)us; }
+
+// ---------------- hardware/gpio.h ---------------- //
+static inline void gpio_init(uint gpio) {
+    hal_sim.gpio_dir &= ~(1u << gpio);
+    hal_sim.gpio_out &= ~(1u << gpio);
+}
+static inline void gpio_set_dir(uint gpio, bool out) {
+    if (out) hal_sim.gpio_dir |= 1u << gpio;
+    else hal_sim.gpio_dir &= ~(1u << gpio);
+}
+static inline void gpio_put(uint gpio, bool value) {
+    if (value) hal_sim.gpio_out |= 1u << gpio;
+    else hal_sim.gpio_out &= ~(1u << gpio);
+}
+static inline bool gpio_get(uint gpio) {
+    uint32_t levels = hal_sim.gpio_dir & (1u << gpio) ? hal_sim.gpio_out : hal_sim.gpio_in;
+    return (levels >> gpio) & 1u;
+}
+
+// ---------------- hardware/adc.h ---------------- //
+static inline void adc_init(void) {}
+static inline void adc_gpio_init(uint gpio) { gpio_init(gpio); }
+static inline void adc_select_input(uint input) { hal_sim.adc_input = input; }
+static inline uint16_t adc_read(void) { return hal_sim.adc[hal_sim.adc_input % 5] & 0x0FFF; }
+
+// ---------------- hardware/i2c.h ---------------- //
+uint i2c_init(i2c_inst_t *i2c, uint baudrate);
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+
+#endif // HAL_SIM_H
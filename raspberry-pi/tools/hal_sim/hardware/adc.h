@@ -0,0 +1,3 @@
+// ---------------- adc.h (host) ---------------- //
+// Host builds of hardware/adc.h resolve here; everything lives in hal_sim.h.
+#include "hal_sim.h"
@@ -0,0 +1,3 @@
+// ---------------- gpio.h (host) ---------------- //
+// Host builds of hardware/gpio.h resolve here; everything lives in hal_sim.h.
+#include "hal_sim.h"
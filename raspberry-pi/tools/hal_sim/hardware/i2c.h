@@ -0,0 +1,3 @@
+// ---------------- i2c.h (host) ---------------- //
+// Host builds of hardware/i2c.h resolve here; everything lives in hal_sim.h.
+#include "hal_sim.h"
@@ -0,0 +1,3 @@
+// ---------------- stdlib.h (host) ---------------- //
+// Host builds of pico/stdlib.h resolve here; everything lives in hal_sim.h.
+#include "hal_sim.h"
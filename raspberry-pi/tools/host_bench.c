@@ -0,0 +1,581 @@
+// ---------------- host_bench.c ---------------- //
+/*
+ * Host tool: times the firmware's hot kernels and task bodies, built
+ * against tools/hal_sim instead of the Pico SDK, and gates regressions
+ * against a stored JSON baseline.
+ *
+ * Build:  cc -O2 -I.. -Ihal_sim host_bench.c hal_sim/hal_sim.c ../lcd.c ../oled.c ../status_screen.c \
+ *             ../alert_rules.c ../checksum.c ../irrigation_cycle.c -o host_bench -lm
+ * Usage:  host_bench [-f filter] [-r reps] [-m min_ms]     results table
+ *         host_bench -o local.json                         also write JSON
+ *         host_bench -b -o bench_baseline.json             bus figures only
+ *         host_bench -c baseline.json [-t pct]             exit 1 on a regression
+ *
+ * Each benchmark runs in batches sized to take at least min_ms. Each batch
+ * is repeated reps times, and the tool reports the median and the fastest
+ * ns per call. The simulator also counts the I2C bytes per call and the
+ * time the device would wait on them (bus clock plus sleeps), over a fixed
+ * sequence of calls so the counts do not depend on the batch size. For
+ * the LCD paths that wait, not the CPU time, is what the firmware really
+ * pays.
+ *
+ * A comparison fails when a benchmark puts more bytes on the bus than the
+ * baseline (those counts are exact), or when its fastest repetition is
+ * slower than the baseline's by more than the allowed slowdown. That is
+ * pct (default 20) percent, widened to three times the interquartile
+ * spread of the repetitions, now or in the baseline, so a noisy host
+ * does not fail a build on noise. Noise only ever adds time, so the
+ * fastest run is the steadiest figure, and a benchmark that looks slower
+ * is measured twice more before it counts.
+ *
+ * Host times only mean something against a baseline taken on the same
+ * machine, so the checked-in tools/bench_baseline.json holds only the bus
+ * figures (-b) and gates only those. For timings, write a local baseline
+ * with -o before a change and compare with -c after it.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "soil_sensor.h"
+#include "irrigation_logic.h"
+#include "irrigation_cycle.h"
+#include "topology.h"
+#include "lcd.h"
+#include "status_screen.h"
+#include "cli_commands.h"
+#include "alert_rules.h"
+#include "alert_rules_default.h"
+
+#define TRACE_LEN   4096            // power of two
+#define BURST       10              // sensors/soil_moisture.c BUFFER_SIZE
+#define MAX_RESULTS 32
+
+// As in watering_system_main.c
+static const irrigation_params_t irrigation_params = {
+    .zone_count = ZONE_COUNT,
+    .cutoff = { SITE_ZONES(TOPO_ZONE_THR) },
+    .probe = { SITE_ZONES(TOPO_ZONE_PROBE) },
+    .dry_above = SITE_DRY_ABOVE,
+    .humidity_skip = 80,
+    .water_seconds = 30,
+};
+
+static uint16_t adc_trace[TRACE_LEN];
+static float hum_trace[TRACE_LEN];
+static alert_engine_t alerts;
+static status_screen_t screen;
+static uint32_t sim_ms;
+static volatile uint32_t cycles;
+
+// Keeps a result alive without the compiler seeing through it
+static void keep(uint32_t v) {
+    __asm__ volatile("" : : "r"(v) : "memory");
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Slow drift across the ADC range with sensor noise, like a drying bed
+static void make_traces(void) {
+    uint32_t seed = 12345;
+    for (int i = 0; i < TRACE_LEN; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        int noise = (int)(seed >> 24) - 128;
+        adc_trace[i] = (uint16_t)(500 + (i * 3000) / TRACE_LEN + noise);
+        hum_trace[i] = 40.0f + (float)((seed >> 8) % 500) / 10.0f;
+    }
+}
+
+// ---------------- Firmware I/O on hal_sim ---------------- //
+// What watering_system_main.c plugs into irrigation_cycle.c in the default
+// build (relays, OLED status screen); delays only advance sim_ms.
+static volatile float temperature = 24.5f, humidity = 55.0f;
+static screen_live_t live = {.temperature = 24.5f, .watering_zone = -1};
+
+static void alert_sink(const char *name, uint8_t actions, bool raised) {
+    (void)name;
+    if (raised && (actions & ALERT_RESET_CYCLES)) cycles = 0;
+}
+
+static void io_signal(uint8_t sig, float value) {
+    alert_sample(&alerts, sig, (int32_t)(value * 10 + (value < 0 ? -0.5f : 0.5f)), sim_ms, alert_sink);
+}
+
+static void io_pump_on(int zone) {
+    gpio_put(zone_relay_gpio(zone), 1);
+}
+
+static void io_pump_off(int zone) {
+    gpio_put(zone_relay_gpio(zone), 0);
+}
+
+static bool io_pump_fault(void) {
+    return false;
+}
+
+static void io_pump_report(void) {}
+
+static bool io_intrusion(void) {
+    return gpio_get(PROX_PIN);
+}
+
+static void io_servo(float angle) {
+    keep((uint32_t)angle);
+}
+
+// draw_screen()
+static void io_draw(void) {
+    live.humidity = humidity;
+    screen_draw(&screen, &live);
+    oled_flush();
+}
+
+static void io_message(const char *msg) {
+    screen_message(&screen, msg);
+    io_draw();
+}
+
+static void io_countdown(int seconds) {
+    live.watering_seconds = seconds;
+    io_draw();
+}
+
+static void io_watering(int zone) {
+    live.watering_zone = (int8_t)zone;
+    if (zone < 0) live.watering_seconds = 0;
+}
+
+static void io_log(const char *line) {
+    keep((uint32_t)strlen(line));
+}
+
+static void io_delay(uint32_t ms) {
+    sim_ms += ms;
+}
+
+static bool io_abort(void) {
+    return false;
+}
+
+static const char *io_stop_rule(void) {
+    return NULL;
+}
+
+static const irrigation_io_t bench_io = {
+    .read_probes = topology_read_probes,
+    .signal = io_signal,
+    .pump_on = io_pump_on,
+    .pump_off = io_pump_off,
+    .pump_fault = io_pump_fault,
+    .pump_report = io_pump_report,
+    .intrusion = io_intrusion,
+    .servo = io_servo,
+    .message = io_message,
+    .countdown = io_countdown,
+    .watering = io_watering,
+    .log = io_log,
+    .delay_ms = io_delay,
+    .abort_requested = io_abort,
+    .stop_rule = io_stop_rule,
+    .temperature = &temperature,
+    .humidity = &humidity,
+    .cycles = &cycles,
+};
+
+// ---------------- Kernels ---------------- //
+static uint32_t b_soil_moisture(uint64_t n) {
+    float acc = 0;
+    for (uint64_t i = 0; i < n; i++) acc += calculate_soil_moisture(adc_trace[i & (TRACE_LEN - 1)]);
+    return (uint32_t)acc;
+}
+
+// soil_moisture_read() once the DMA burst has landed
+static uint32_t b_soil_read_avg(uint64_t n) {
+    float acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        const uint16_t *burst = &adc_trace[(i * 16) & (TRACE_LEN - 16)];
+        acc += soil_adc_percent(soil_adc_average(burst, BURST));
+    }
+    return (uint32_t)acc;
+}
+
+// soil_task's irrigation_soil_pass(): read the probes, signal the alert
+// rules, classify zones, distance for the sampling rate
+static uint32_t b_soil_classify(uint64_t n) {
+    uint32_t acc = 0;
+    uint16_t probes[PROBE_COUNT];
+    for (uint64_t i = 0; i < n; i++) {
+        hal_sim.adc[PROBE_ADC_CHANNEL(PROBE_GPIO[0])] = adc_trace[i & (TRACE_LEN - 1)];
+        humidity = hum_trace[i & (TRACE_LEN - 1)];
+        float distance;
+        acc += irrigation_soil_pass(&irrigation_params, &bench_io, probes, &distance);
+        acc += (uint32_t)distance;
+    }
+    return acc;
+}
+
+static uint32_t b_lcd_format(uint64_t n) {
+    uint32_t acc = 0;
+    char buf[64];       // as display_status(): room for any reading and humidity
+    for (uint64_t i = 0; i < n; i++) {
+        acc += (uint32_t)snprintf(buf, sizeof(buf), "Val:%d Hum:%.0f%%", adc_trace[i & (TRACE_LEN - 1)],
+                                  hum_trace[i & (TRACE_LEN - 1)]);
+    }
+    return acc;
+}
+
+// soil_task's whole LCD update: clear, two lines, one formatted
+static uint32_t b_lcd_status(uint64_t n) {
+    char buf[64];
+    for (uint64_t i = 0; i < n; i++) {
+        lcd_clear();
+        lcd_set_cursor(0, 0);
+        lcd_print("Soil Dryness:");
+        lcd_set_cursor(0, 1);
+        snprintf(buf, sizeof(buf), "Val:%d Hum:%.0f%%", adc_trace[i & (TRACE_LEN - 1)],
+                 hum_trace[i & (TRACE_LEN - 1)]);
+        buf[LCD_COLS] = '\0';
+        lcd_print(buf);
+    }
+    return (uint32_t)hal_sim.i2c_bytes;
+}
+
+// The OLED status screen with a full day of zone trends: drawn in full,
+// then only the changed pages sent. `full` clears first, so every page goes.
+static uint32_t oled_status(uint64_t n, bool full) {
+    screen_live_t live = {.temperature = 24.5f, .watering_zone = 0};
+    i2c_init(I2C_PORT, OLED_I2C_HZ);
+    for (uint64_t i = 0; i < n; i++) {
+        live.soil_pct = site_moisture_pct(adc_trace[i & (TRACE_LEN - 1)]);
+        live.humidity = hum_trace[i & (TRACE_LEN - 1)];
+        live.watering_seconds = 30 - (int)(i % 30);
+        if (full) oled_clear();
+        screen_draw(&screen, &live);
+        oled_flush();
+    }
+    i2c_init(I2C_PORT, 100 * 1000);
+    return (uint32_t)hal_sim.i2c_bytes;
+}
+
+static uint32_t b_oled_full(uint64_t n) {
+    return oled_status(n, true);
+}
+
+// A new reading during a watering second: soil, humidity and countdown rows
+static uint32_t b_oled_update(uint64_t n) {
+    return oled_status(n, false);
+}
+
+static uint32_t b_cli_parse(uint64_t n) {
+    static const char *lines[8] = {"status", "start", "alerts load", "update", "bogus", "", "telemetry", "stop"};
+    uint32_t acc = 0;
+    for (uint64_t i = 0; i < n; i++) acc += (uint32_t)cli_parse(lines[i & 7]);
+    return acc;
+}
+
+// irrigation_task, one pass with every zone dry: irrigation_water_zone()
+// for each, on the OLED build's display, without the delays
+static uint32_t b_irrigation_cycle(uint64_t n) {
+    static const uint16_t dry_probes[PROBE_COUNT] = {0};   // driest reading on every probe
+    uint32_t acc = 0;
+    humidity = 55.0f;
+    i2c_init(I2C_PORT, OLED_I2C_HZ);
+    for (uint64_t i = 0; i < n; i++) {
+        uint8_t dry = irrigation_dry_zones(&irrigation_params, dry_probes, humidity);
+        live.dry_zones = dry;
+        for (int zone = irrigation_next_zone(&irrigation_params, dry, 0); zone >= 0;
+             zone = irrigation_next_zone(&irrigation_params, dry, zone + 1)) {
+            acc += irrigation_water_zone(&irrigation_params, &bench_io, zone, dry);
+        }
+    }
+    i2c_init(I2C_PORT, 100 * 1000);
+    return acc;
+}
+
+typedef struct {
+    const char *name;
+    uint32_t (*fn)(uint64_t n);
+    uint32_t bus_calls;         // calls in the bus pass (TRACE_LEN: one walk over the traces)
+} bench_t;
+
+static const bench_t benches[] = {
+    {"calculate_soil_moisture", b_soil_moisture,    TRACE_LEN},
+    {"soil_moisture_read_avg",  b_soil_read_avg,    TRACE_LEN},
+    {"soil_task_classify",      b_soil_classify,    TRACE_LEN},
+    {"lcd_format",              b_lcd_format,       TRACE_LEN},
+    {"lcd_status_update",       b_lcd_status,       TRACE_LEN},
+    {"oled_status_full",        b_oled_full,        TRACE_LEN},
+    {"oled_status_update",      b_oled_update,      TRACE_LEN},
+    {"cli_parse",               b_cli_parse,        TRACE_LEN},
+    {"irrigation_cycle",        b_irrigation_cycle, 4},
+};
+#define BENCH_COUNT (sizeof(benches) / sizeof(benches[0]))
+
+// ---------------- Runner ---------------- //
+typedef struct {
+    const bench_t *bench;
+    const char *name;
+    uint64_t iters;
+    double ns, min_ns;          // median / fastest ns per call
+    double spread;              // interquartile range of the repetitions / median
+    double bus_bytes;           // I2C payload bytes per call
+    double wait_us;             // device bus + sleep time per call
+} result_t;
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+static result_t run(const bench_t *b, int reps, double min_s) {
+    result_t r = {.bench = b, .name = b->name};
+
+    // Batch size: double until one batch takes min_s, then scale to it
+    uint64_t n = 1;
+    double dt;
+    for (;;) {
+        double t0 = now_s();
+        keep(b->fn(n));
+        dt = now_s() - t0;
+        if (dt >= min_s / 4 || n >= (1ull << 40)) break;
+        n *= 2;
+    }
+    if (dt < min_s) n = (uint64_t)(n * (min_s / (dt > 1e-9 ? dt : 1e-9))) + 1;
+    r.iters = n;
+
+    double per[64];
+    if (reps > 64) reps = 64;
+    for (int i = 0; i < reps; i++) {
+        double t0 = now_s();
+        keep(b->fn(n));
+        per[i] = (now_s() - t0) * 1e9 / (double)n;
+    }
+    qsort(per, (size_t)reps, sizeof(double), cmp_double);
+    r.ns = per[reps / 2];
+    r.min_ns = per[0];
+    r.spread = (per[reps * 3 / 4] - per[reps / 4]) / r.ns;
+
+    // Bus traffic over a fixed sequence, not the timed batches: what the
+    // display sends depends on the frame before, so the sequence runs
+    // twice and only the second pass, which starts from the same last
+    // frame whatever ran before, is counted
+    uint32_t calls = b->bus_calls;
+    keep(b->fn(calls));
+    hal_sim_reset();
+    keep(b->fn(calls));
+    r.bus_bytes = (double)hal_sim.i2c_bytes / calls;
+    r.wait_us = hal_sim.wait_us / calls;
+    return r;
+}
+
+static void print_ns(double ns) {
+    if (ns >= 1e6) printf(" %10.2f ms", ns / 1e6);
+    else if (ns >= 1e3) printf(" %10.2f us", ns / 1e3);
+    else printf(" %10.2f ns", ns);
+}
+
+// bus_only: the exact, host-independent figures, for a baseline kept in the repo
+static int write_json(const char *path, const result_t *r, int count, int reps, double min_ms, bool bus_only) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    if (bus_only) {
+        fprintf(f, "{\n  \"context\": {\"tool\": \"host_bench\", \"bus_only\": true},\n  \"benchmarks\": [\n");
+    } else {
+        char host[64] = "unknown";
+        gethostname(host, sizeof(host) - 1);
+        fprintf(f, "{\n  \"context\": {\"tool\": \"host_bench\", \"host\": \"%s\", \"compiler\": \"%s\", "
+                   "\"reps\": %d, \"min_ms\": %.0f},\n  \"benchmarks\": [\n", host, __VERSION__, reps, min_ms);
+    }
+    for (int i = 0; i < count; i++) {
+        fprintf(f, "    {\"name\": \"%s\", ", r[i].name);
+        if (!bus_only) {
+            fprintf(f, "\"ns_per_op\": %.3f, \"min_ns_per_op\": %.3f, \"spread\": %.3f, \"iterations\": %llu, ",
+                    r[i].ns, r[i].min_ns, r[i].spread, (unsigned long long)r[i].iters);
+        }
+        fprintf(f, "\"i2c_bytes_per_op\": %.1f, \"device_wait_us_per_op\": %.1f}%s\n", r[i].bus_bytes, r[i].wait_us,
+                i + 1 < count ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+    return 0;
+}
+
+// Value of "key": after the entry for `name`; false when missing
+static bool json_field(const char *json, const char *name, const char *key, double *out) {
+    char pat[96];
+    snprintf(pat, sizeof(pat), "\"name\": \"%s\"", name);
+    const char *entry = strstr(json, pat);
+    if (!entry) return false;
+    const char *end = strchr(entry, '}');
+    snprintf(pat, sizeof(pat), "\"%s\":", key);
+    const char *field = strstr(entry, pat);
+    if (!field || (end && field > end)) return false;
+    *out = strtod(field + strlen(pat), NULL);
+    return true;
+}
+
+static char *read_text(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *s = malloc((size_t)len + 1);
+    if (s && fread(s, 1, (size_t)len, f) != (size_t)len) {
+        free(s);
+        s = NULL;
+    }
+    if (s) s[len] = '\0';
+    fclose(f);
+    return s;
+}
+
+// Allowed slowdown in percent: pct, or three interquartile spreads if wider
+static double allowed_pct(double threshold_pct, double spread_now, double spread_base) {
+    double noise = 3 * 100 * (spread_now > spread_base ? spread_now : spread_base);
+    return noise > threshold_pct ? noise : threshold_pct;
+}
+
+// Returns the number of regressions; re-measures suspects in place
+static int compare(const char *path, result_t *r, int count, double threshold_pct, int reps, double min_s) {
+    char *json = read_text(path);
+    if (!json) return -1;
+    if (!strstr(json, "\"benchmarks\"")) {
+        fprintf(stderr, "%s: not a host_bench baseline\n", path);
+        free(json);
+        return -1;
+    }
+    int regressions = 0;
+    printf("\n%-26s %13s %13s %8s %8s\n", "vs baseline (fastest)", "baseline", "now", "change", "allowed");
+    for (int i = 0; i < count; i++) {
+        double base_ns, base_spread = 0, base_bytes;
+        bool timed = json_field(json, r[i].name, "min_ns_per_op", &base_ns);
+        if (!json_field(json, r[i].name, "i2c_bytes_per_op", &base_bytes)) {
+            printf("%-26s %13s", r[i].name, "-");
+            print_ns(r[i].min_ns);
+            printf(" %8s\n", "new");
+            continue;
+        }
+        json_field(json, r[i].name, "spread", &base_spread);
+
+        bool slower = false;
+        printf("%-26s", r[i].name);
+        if (timed) {
+            double allowed = allowed_pct(threshold_pct, r[i].spread, base_spread);
+            for (int retry = 0; retry < 2 && (r[i].min_ns / base_ns - 1) * 100 > allowed; retry++) {
+                result_t again = run(r[i].bench, reps, min_s);
+                if (again.min_ns < r[i].min_ns) r[i] = again;
+                allowed = allowed_pct(threshold_pct, r[i].spread, base_spread);
+            }
+            double change = (r[i].min_ns / base_ns - 1) * 100;
+            slower = change > allowed;
+            print_ns(base_ns);
+            print_ns(r[i].min_ns);
+            printf(" %+7.1f%% %7.0f%%", change, allowed);
+            if (slower) printf("  REGRESSED");
+        } else {
+            printf(" %13s", "-");
+            print_ns(r[i].min_ns);
+            printf(" %8s", "bus only");
+        }
+        bool chattier = r[i].bus_bytes > base_bytes + 0.05;
+        if (chattier) printf("  I2C %.1f -> %.1f bytes", base_bytes, r[i].bus_bytes);
+        printf("\n");
+        regressions += slower || chattier;
+    }
+    free(json);
+    return regressions;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  -f text        only benchmarks whose name contains text\n"
+        "  -r reps        timed repetitions per benchmark (default 21)\n"
+        "  -m ms          minimum time per repetition      (default 20)\n"
+        "  -o file.json   write results as a baseline\n"
+        "  -b             with -o: bus figures only, no host timings\n"
+        "  -c file.json   compare against a baseline, exit 1 on a regression\n"
+        "  -t pct         allowed slowdown for -c, widened on a noisy host (default 20)\n", prog);
+}
+
+int main(int argc, char **argv) {
+    const char *filter = NULL, *out = NULL, *baseline = NULL;
+    int reps = 21;
+    double min_ms = 20, threshold = 20;
+    bool bus_only = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:r:m:o:bc:t:h")) != -1) {
+        switch (opt) {
+        case 'f': filter = optarg; break;
+        case 'r': reps = atoi(optarg); break;
+        case 'm': min_ms = atof(optarg); break;
+        case 'o': out = optarg; break;
+        case 'b': bus_only = true; break;
+        case 'c': baseline = optarg; break;
+        case 't': threshold = atof(optarg); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (reps < 1 || reps > 64 || min_ms <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    make_traces();
+    i2c_init(I2C_PORT, 100 * 1000);     // as main() sets it up
+    if (!alert_load(&alerts, alert_rules_default, sizeof(alert_rules_default))) {
+        fprintf(stderr, "built-in alert rules do not load\n");
+        return 1;
+    }
+    uint8_t dry_pct[ZONE_COUNT], pct[ZONE_COUNT];
+    for (int z = 0; z < ZONE_COUNT; z++) dry_pct[z] = site_moisture_pct(irrigation_params.cutoff[z]);
+    oled_init();
+    screen_init(&screen, ZONE_COUNT, dry_pct);
+    for (int i = 0; i < SCREEN_TREND_LEN; i++) {
+        for (int z = 0; z < ZONE_COUNT; z++) pct[z] = site_moisture_pct(adc_trace[(i * 40 + z * 700) & (TRACE_LEN - 1)]);
+        screen_moisture(&screen, pct, (uint32_t)i * SCREEN_TREND_PERIOD_S);
+    }
+
+    result_t results[MAX_RESULTS];
+    int count = 0;
+    printf("%-26s %13s %13s %12s %10s %12s\n", "benchmark", "median", "fastest", "iterations", "I2C B/op",
+           "device wait");
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        if (filter && !strstr(benches[i].name, filter)) continue;
+        result_t r = run(&benches[i], reps, min_ms / 1000);
+        printf("%-26s", r.name);
+        print_ns(r.ns);
+        print_ns(r.min_ns);
+        printf(" %12llu %10.1f", (unsigned long long)r.iters, r.bus_bytes);
+        if (r.wait_us > 0) print_ns(r.wait_us * 1000);
+        printf("\n");
+        results[count++] = r;
+    }
+
+    if (out && write_json(out, results, count, reps, min_ms, bus_only) != 0) return 1;
+    if (baseline) {
+        int bad = compare(baseline, results, count, threshold, reps, min_ms / 1000);
+        if (bad < 0) return 1;
+        if (bad > 0) {
+            printf("%d benchmark(s) regressed\n", bad);
+            return 1;
+        }
+        printf("no regressions\n");
+    }
+    return 0;
+}
+
+// End of host_bench.c
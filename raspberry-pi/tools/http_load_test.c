@@ -0,0 +1,353 @@
+// ---------------- http_load_test.c ---------------- //
+/*
+ * Host load test for the web dashboard (http_dashboard.c), run unchanged
+ * on tools/net_sim, with real HTTP clients on 127.0.0.1:
+ *
+ *   load        HTTP_MAX_SSE browsers on /events while others fetch the
+ *               page in a loop and a sensor value changes every 250 ms.
+ *               Reports the concurrent clients, update latency (sensor
+ *               change -> the browser has it), page fetches/s and the
+ *               server's own counters. One /events client too many must
+ *               get a 503, a connection burst past the table must not
+ *               hurt anyone, and every connection is freed at the end.
+ *   listen-fail tcp_listen_with_backlog returns NULL: the task ends and
+ *               no pcb is left allocated.
+ *   no-wifi     Wi-Fi never starts: the task ends instead of waiting.
+ * In both, the task clears the handle slot it was given before it goes.
+ *
+ * Build:  cc -O2 -pthread -I.. -Inet_sim -Ihal_sim http_load_test.c ../http_dashboard.c net_sim/net_sim.c \
+ *             -o http_load_test
+ * Usage:  http_load_test [-d seconds] [-p page_clients]     exit 1 on a failure
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "net_sim.h"
+#include "http_dashboard.h"
+#include "dashboard_page.h"
+#include "telemetry.h"
+
+// --- What watering_system_main.c and telemetry.c provide on the device ---
+volatile uint8_t dry_zones = 0x05;
+volatile uint32_t irrigation_count;
+volatile bool manual_abort_flag, manual_start_flag;
+volatile float temperature = 21.5f, humidity = 48;
+volatile uint16_t soil_level = 1400;
+volatile int8_t watering_zone = -1;
+volatile int watering_seconds;
+
+static volatile bool link_up = true, wifi_failed;
+bool telemetry_link_up(void) { return link_up; }
+bool telemetry_wifi_failed(void) { return wifi_failed; }
+
+#define CHANGE_MS    250
+#define MAX_CHANGES  4096
+#define MAX_SAMPLES  (HTTP_MAX_SSE * MAX_CHANGES)
+
+static double duration_s = 5;
+static int page_clients = HTTP_MAX_CONNS - HTTP_MAX_SSE;
+static int failures;
+
+static double change_t[MAX_CHANGES];            // wall time irrigation_count became k
+static double latency_ms[MAX_SAMPLES];
+static int latency_n;
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static volatile bool stop;
+
+static void check(bool ok, const char *what) {
+    if (ok) return;
+    printf("FAIL: %s\n", what);
+    failures++;
+}
+
+static double wall_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// ---------------- Clients ---------------- //
+static int dial(void) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in sa = { .sin_family = AF_INET, .sin_port = htons(net_sim.tcp_bound_port) };
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    struct timeval tv = { 3, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    if (connect(fd, (struct sockaddr *)&sa, sizeof(sa)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// One request on a fresh connection; reads to EOF. Returns the status
+// code (0 if the connection failed) and the body length.
+static int request(const char *req, char *body, size_t cap, size_t *body_len) {
+    int fd = dial();
+    if (fd < 0) return 0;
+    send(fd, req, strlen(req), MSG_NOSIGNAL);
+    static __thread char buf[4096];
+    size_t n = 0;
+    ssize_t r;
+    while (n < sizeof(buf) - 1 && (r = recv(fd, buf + n, sizeof(buf) - 1 - n, 0)) > 0) n += (size_t)r;
+    close(fd);
+    buf[n] = '\0';
+    int status = 0;
+    sscanf(buf, "HTTP/1.1 %d", &status);
+    char *end = strstr(buf, "\r\n\r\n");
+    size_t len = end ? n - (size_t)(end + 4 - buf) : 0;
+    if (body) {
+        size_t c = len < cap - 1 ? len : cap - 1;
+        if (end) memcpy(body, end + 4, c);
+        body[c] = '\0';
+    }
+    if (body_len) *body_len = len;
+    return status;
+}
+
+typedef struct {
+    int fd;
+    bool connected;
+    uint32_t events;
+} sse_client_t;
+
+static void *sse_client(void *arg) {
+    sse_client_t *c = arg;
+    int fd = c->fd;
+    if (fd < 0) return NULL;
+    const char *req = "GET /events HTTP/1.1\r\nHost: pico\r\nAccept: text/event-stream\r\n\r\n";
+    send(fd, req, strlen(req), MSG_NOSIGNAL);
+
+    char buf[2048];
+    size_t n = 0;
+    uint32_t seen = 0;
+    while (!stop) {
+        ssize_t r = recv(fd, buf + n, sizeof(buf) - 1 - n, 0);
+        if (r <= 0) break;
+        n += (size_t)r;
+        buf[n] = '\0';
+        if (!c->connected && strstr(buf, "200 OK")) c->connected = true;
+
+        // Complete events end in a blank line
+        char *ev, *rest = buf;
+        while ((ev = strstr(rest, "data: ")) && strstr(ev, "\n\n")) {
+            char *end = strstr(ev, "\n\n");
+            const char *cnt = strstr(ev, "\"count\":");
+            if (cnt && cnt < end) {
+                uint32_t count = (uint32_t)strtoul(cnt + 8, NULL, 10);
+                double now = wall_s();
+                pthread_mutex_lock(&stats_lock);
+                for (uint32_t k = seen + 1; k <= count && k < MAX_CHANGES && latency_n < MAX_SAMPLES; k++) {
+                    latency_ms[latency_n++] = (now - change_t[k]) * 1e3;
+                }
+                pthread_mutex_unlock(&stats_lock);
+                if (count > seen) seen = count;
+            }
+            c->events++;
+            rest = end + 2;
+        }
+        n -= (size_t)(rest - buf);
+        memmove(buf, rest, n);
+    }
+    return NULL;
+}
+
+typedef struct {
+    uint32_t ok, bad;
+} page_client_t;
+
+static void *page_client(void *arg) {
+    page_client_t *c = arg;
+    while (!stop) {
+        size_t len = 0;
+        int status = request("GET / HTTP/1.1\r\nHost: pico\r\n\r\n", NULL, 0, &len);
+        if (status == 200 && len == sizeof(dashboard_page_gz)) c->ok++;
+        else c->bad++;
+    }
+    return NULL;
+}
+
+static void *sensor(void *arg) {
+    (void)arg;
+    for (uint32_t k = 1; k < MAX_CHANGES && !stop; k++) {
+        usleep(CHANGE_MS * 1000);
+        change_t[k] = wall_s();
+        irrigation_count = k;
+    }
+    return NULL;
+}
+
+// ---------------- Scenarios ---------------- //
+// The creator's handle slot, as watering_system_main.c passes it
+static TaskHandle_t task_handle;
+
+static void start(void) {
+    net_sim.tcp_port = 0;
+    net_sim_start();
+    task_handle = (TaskHandle_t)&task_handle;      // any non-NULL value
+    net_sim_task_start(http_dashboard_task, &task_handle);
+}
+
+static bool wait_for(volatile int *v, int want, double timeout_s) {
+    double until = wall_s() + timeout_s;
+    while (*v != want && wall_s() < until) usleep(1000);
+    return *v == want;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void scenario_load(void) {
+    start();
+    while (net_sim.tcp_bound_port == 0 || net_sim.tcp_pcbs < 1) usleep(1000);
+    usleep(100 * 1000);
+
+    sse_client_t sse[HTTP_MAX_SSE] = {0};
+    page_client_t pages[HTTP_MAX_CONNS] = {0};
+    pthread_t sse_t[HTTP_MAX_SSE], page_t[HTTP_MAX_CONNS], sensor_t;
+    for (int i = 0; i < HTTP_MAX_SSE; i++) {
+        sse[i].fd = dial();
+        pthread_create(&sse_t[i], NULL, sse_client, &sse[i]);
+    }
+    usleep(300 * 1000);
+
+    // One browser too many, and a button, while the table still has room
+    int extra = request("GET /events HTTP/1.1\r\n\r\n", NULL, 0, NULL);
+    check(extra == 503, "an /events client past HTTP_MAX_SSE was not refused");
+    request("POST /start HTTP/1.1\r\nContent-Length: 0\r\n\r\n", NULL, 0, NULL);
+
+    // A burst of idle connections past the table: the extra ones are reset,
+    // the streams keep running, and the slots come back once they close
+    int burst[HTTP_MAX_CONNS + 2];
+    for (int i = 0; i < HTTP_MAX_CONNS + 2; i++) burst[i] = dial();
+    usleep(200 * 1000);
+    for (int i = 0; i < HTTP_MAX_CONNS + 2; i++) if (burst[i] >= 0) close(burst[i]);
+    usleep(200 * 1000);
+
+    double t0 = wall_s();
+    for (int i = 0; i < page_clients; i++) pthread_create(&page_t[i], NULL, page_client, &pages[i]);
+    pthread_create(&sensor_t, NULL, sensor, NULL);
+    while (wall_s() < t0 + duration_s) usleep(10 * 1000);
+    stop = true;
+    for (int i = 0; i < page_clients; i++) pthread_join(page_t[i], NULL);
+    char stats_json[256];
+    request("GET /stats HTTP/1.1\r\n\r\n", stats_json, sizeof(stats_json), NULL);
+    pthread_join(sensor_t, NULL);
+    for (int i = 0; i < HTTP_MAX_SSE; i++) {
+        if (sse[i].fd >= 0) shutdown(sse[i].fd, SHUT_RDWR);
+        pthread_join(sse_t[i], NULL);
+        if (sse[i].fd >= 0) close(sse[i].fd);
+    }
+
+    // Results
+    uint32_t page_ok = 0, page_bad = 0, ev_min = UINT32_MAX, connected = 0;
+    for (int i = 0; i < page_clients; i++) page_ok += pages[i].ok, page_bad += pages[i].bad;
+    for (int i = 0; i < HTTP_MAX_SSE; i++) {
+        connected += sse[i].connected;
+        if (sse[i].events < ev_min) ev_min = sse[i].events;
+    }
+    qsort(latency_ms, (size_t)latency_n, sizeof(double), cmp_double);
+    double sum = 0;
+    for (int i = 0; i < latency_n; i++) sum += latency_ms[i];
+    double avg = latency_n ? sum / latency_n : 0;
+    double p95 = latency_n ? latency_ms[latency_n * 95 / 100] : 0;
+    double max = latency_n ? latency_ms[latency_n - 1] : 0;
+
+    printf("load: %d /events clients + %d page clients for %.0f s\n", HTTP_MAX_SSE, page_clients, duration_s);
+    printf("  updates: %u+ events per client, sensor change -> browser avg %.0f ms, p95 %.0f ms, max %.0f ms"
+           " (%d changes seen)\n", ev_min, avg, p95, max, latency_n);
+    printf("  page: %u fetches (%.0f/s), %u failed; extra /events client got %d\n", page_ok,
+           page_ok / duration_s, page_bad, extra);
+    printf("  server: %s\n", stats_json);
+    printf("  RAM: %lu bytes static\n", (unsigned long)http_ram_bytes());
+
+    check(connected == HTTP_MAX_SSE, "not every /events client was accepted");
+    check(ev_min + 2 >= (uint32_t)(duration_s * 1000 / HTTP_UPDATE_MS), "an /events client missed updates");
+    check(latency_n > 0 && max < HTTP_UPDATE_MS + 250, "update latency above one publish period");
+    check(page_ok > 0 && page_bad == 0, "page fetches failed");
+    check(manual_start_flag, "POST /start did not set manual_start_flag");
+
+    // Everyone gone: only the listen pcb is left, and no client is counted
+    double until = wall_s() + 3;
+    http_stats_t st;
+    do {
+        usleep(10 * 1000);
+        cyw43_arch_lwip_begin();
+        http_get_stats(&st);
+        cyw43_arch_lwip_end();
+    } while ((st.clients != 0 || net_sim.tcp_pcbs != 1) && wall_s() < until);
+    check(st.clients == 0, "/events clients still counted after they left");
+    check(net_sim.tcp_pcbs == 1, "connections left allocated after every client left");
+}
+
+static void scenario_listen_fail(void) {
+    net_sim.tcp_listen_fail = true;
+    start();
+    bool ended = wait_for(&net_sim.tasks_running, 0, 3);
+    wait_for(&net_sim.tcp_pcbs, 0, 1);         // closed pcbs are freed by the lwIP thread
+    printf("listen-fail: task %s, %d pcbs left\n", ended ? "ended" : "still running", net_sim.tcp_pcbs);
+    check(ended, "task kept running without a listening socket");
+    check(net_sim.tcp_pcbs == 0, "the bound pcb leaked");
+    check(task_handle == NULL, "task handle left set after the task deleted itself");
+}
+
+static void scenario_no_wifi(void) {
+    link_up = false;
+    wifi_failed = true;
+    start();
+    bool ended = wait_for(&net_sim.tasks_running, 0, 3);
+    printf("no-wifi: task %s\n", ended ? "ended" : "still waiting for a link");
+    check(ended, "task waits forever for a link that cannot come up");
+    check(task_handle == NULL, "task handle left set after the task deleted itself");
+}
+
+static int run(void (*scenario)(void)) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        scenario();
+        fflush(stdout);
+        _exit(failures ? 1 : 0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "usage: %s [-d seconds] [-p page_clients]\n"
+        "  -d seconds       length of the load run (default 5)\n"
+        "  -p page_clients  clients fetching / in a loop (default %d)\n", prog, HTTP_MAX_CONNS - HTTP_MAX_SSE);
+}
+
+int main(int argc, char **argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "d:p:h")) != -1) {
+        switch (opt) {
+        case 'd': duration_s = atof(optarg); break;
+        case 'p': page_clients = atoi(optarg); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (duration_s < 2 || page_clients < 0 || page_clients > HTTP_MAX_CONNS) {
+        usage(argv[0]);
+        return 2;
+    }
+    int rc = run(scenario_load);
+    rc |= run(scenario_listen_fail);
+    rc |= run(scenario_no_wifi);
+    printf("%s\n", rc ? "FAILED" : "ok");
+    return rc ? 1 : 0;
+}
+
+// End of http_load_test.c
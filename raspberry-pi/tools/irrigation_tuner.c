@@ -0,0 +1,404 @@
+// ---------------- irrigation_tuner.c ---------------- //
+/*
+ * Host tool: replays recorded sensor traces through the firmware's
+ * irrigation rules (irrigation_logic.h) for every combination of
+ * zone cutoffs, humidity skip and pump time, and ranks them by
+ *   cost = seconds below target moisture + weight * pump seconds
+ *
+ * Build:  cc -O2 -pthread -I.. irrigation_tuner.c -o irrigation_tuner -lm
+ * Usage:  irrigation_tuner -i trace.csv [options]    (CSV: t_s,soil,temp,hum)
+ *         irrigation_tuner -s 120 [options]           (synthetic 120-day trace)
+ *
+ * The trace is held as separate arrays (SoA) and every combination is a
+ * single pass over them. Combinations are split into one contiguous range
+ * per thread; idle threads steal the back half of the busiest range.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "irrigation_logic.h"
+
+#define STEAL_CHUNK 8   // combinations taken per grab from a thread's own range
+
+// ---------------- Trace (SoA) ---------------- //
+typedef struct {
+    size_t n;
+    float *soil;    // raw ADC as recorded (low = dry)
+    float *hum;     // %
+    float *dt;      // seconds since previous sample
+    float *decay;   // exp(-dt / tau), shared by every combination
+} trace_t;
+
+typedef struct {
+    float gain;     // ADC counts added per pump-second
+    float tau_h;    // drainage time constant (hours)
+    float target;   // soil reading we want to stay above
+    float weight;   // cost of one pump-second, in below-target seconds
+} model_t;
+
+typedef struct {
+    irrigation_params_t params;
+    double pump_s;
+    double below_s;
+    double cost;
+} result_t;
+
+static void trace_alloc(trace_t *tr, size_t cap) {
+    tr->soil = malloc(cap * sizeof(float));
+    tr->hum = malloc(cap * sizeof(float));
+    tr->dt = malloc(cap * sizeof(float));
+    tr->decay = malloc(cap * sizeof(float));
+    if (!tr->soil || !tr->hum || !tr->dt || !tr->decay) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+}
+
+static int trace_load_csv(trace_t *tr, const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    size_t cap = 1 << 16;
+    trace_alloc(tr, cap);
+    tr->n = 0;
+
+    char line[256];
+    double t_prev = 0;
+    while (fgets(line, sizeof(line), f)) {
+        double t, soil, temp, hum;
+        if (sscanf(line, "%lf,%lf,%lf,%lf", &t, &soil, &temp, &hum) != 4) continue;  // header / junk
+        if (tr->n == cap) {
+            cap *= 2;
+            tr->soil = realloc(tr->soil, cap * sizeof(float));
+            tr->hum = realloc(tr->hum, cap * sizeof(float));
+            tr->dt = realloc(tr->dt, cap * sizeof(float));
+            tr->decay = realloc(tr->decay, cap * sizeof(float));
+            if (!tr->soil || !tr->hum || !tr->dt || !tr->decay) {
+                fprintf(stderr, "out of memory\n");
+                exit(1);
+            }
+        }
+        tr->soil[tr->n] = (float)soil;
+        tr->hum[tr->n] = (float)hum;
+        tr->dt[tr->n] = tr->n == 0 || t < t_prev ? 0.0f : (float)(t - t_prev);
+        t_prev = t;
+        tr->n++;
+    }
+    fclose(f);
+    return tr->n > 0 ? 0 : -1;
+}
+
+// Unwatered soil drying with the daily temperature cycle, plus the odd rain.
+static void trace_synthetic(trace_t *tr, int days) {
+    const int step = 60;
+    tr->n = (size_t)days * 86400 / step;
+    trace_alloc(tr, tr->n);
+    srand(1);
+
+    float soil = 2600;
+    for (size_t i = 0; i < tr->n; i++) {
+        double day_frac = fmod((double)i * step / 86400.0, 1.0);
+        float sun = (float)fmax(0.0, sin(2 * M_PI * (day_frac - 0.25)));
+        soil -= 0.06f + 0.5f * sun;                 // evapotranspiration
+        if (rand() % 20000 == 0) soil += 900;       // rain
+        if (soil < 300) soil = 300;
+        if (soil > 3500) soil = 3500;
+        tr->soil[i] = soil + (float)(rand() % 16 - 8);
+        tr->hum[i] = 85 - 40 * sun + (float)(rand() % 10);
+        tr->dt[i] = i == 0 ? 0.0f : (float)step;
+    }
+}
+
+static void trace_prepare(trace_t *tr, const model_t *m) {
+    for (size_t i = 0; i < tr->n; i++) tr->decay[i] = expf(-tr->dt[i] / (m->tau_h * 3600.0f));
+}
+
+// ---------------- Replay kernel ---------------- //
+// Same cycle as irrigation_task: water each dry zone in turn for
+// water_seconds, re-reading the dry mask between zones.
+static void simulate(const trace_t *tr, const model_t *m, result_t *r) {
+    const irrigation_params_t *p = &r->params;
+    const float *soil_in = tr->soil, *hum = tr->hum, *dt = tr->dt, *decay = tr->decay;
+    float boost = 0, pump_left = 0;
+    double pump = 0, below = 0;
+    int zone = -1;
+
+    for (size_t i = 0; i < tr->n; i++) {
+        boost *= decay[i];
+        if (zone >= 0) {
+            float on = dt[i] < pump_left ? dt[i] : pump_left;
+            pump_left -= on;
+            pump += on;
+            boost += m->gain * on;
+        }
+
+        float soil = soil_in[i] + boost;
+        if (soil > 4095) soil = 4095;
+        uint16_t raw = (uint16_t)soil;
+        uint8_t dry = irrigation_dry_zones(p, &raw, hum[i]);
+
+        if (zone >= 0 && pump_left <= 0) {
+            zone = irrigation_next_zone(p, dry, zone + 1);
+            pump_left = zone >= 0 ? p->water_seconds : 0;
+        } else if (zone < 0 && dry) {
+            zone = irrigation_next_zone(p, dry, 0);
+            pump_left = p->water_seconds;
+        }
+        if (soil < m->target) below += dt[i];
+    }
+    r->pump_s = pump;
+    r->below_s = below;
+    r->cost = below + m->weight * pump;
+}
+
+// ---------------- Work-stealing pool ---------------- //
+typedef struct {
+    pthread_mutex_t lock;
+    size_t next, end;
+} work_range_t;
+
+typedef struct {
+    const trace_t *trace;
+    const model_t *model;
+    result_t *results;
+    work_range_t *ranges;
+    int threads;
+} pool_t;
+
+typedef struct {
+    pool_t *pool;
+    int id;
+} worker_t;
+
+static int take_own(work_range_t *w, size_t *lo, size_t *hi) {
+    pthread_mutex_lock(&w->lock);
+    int ok = w->next < w->end;
+    if (ok) {
+        *lo = w->next;
+        *hi = w->next + STEAL_CHUNK < w->end ? w->next + STEAL_CHUNK : w->end;
+        w->next = *hi;
+    }
+    pthread_mutex_unlock(&w->lock);
+    return ok;
+}
+
+// Move the back half of the largest remaining range into our own.
+static int steal(pool_t *pool, int self) {
+    int victim = -1;
+    size_t best = 0;
+    for (int i = 0; i < pool->threads; i++) {
+        if (i == self) continue;
+        pthread_mutex_lock(&pool->ranges[i].lock);
+        size_t left = pool->ranges[i].end - pool->ranges[i].next;
+        pthread_mutex_unlock(&pool->ranges[i].lock);
+        if (left > best) { best = left; victim = i; }
+    }
+    if (victim < 0) return 0;
+
+    work_range_t *v = &pool->ranges[victim], *me = &pool->ranges[self];
+    size_t lo = 0, hi = 0;
+    pthread_mutex_lock(&v->lock);
+    if (v->end > v->next) {
+        size_t left = v->end - v->next;
+        size_t mid = left > STEAL_CHUNK ? v->next + left / 2 : v->next;
+        lo = mid;
+        hi = v->end;
+        v->end = mid;
+    }
+    pthread_mutex_unlock(&v->lock);
+    if (hi == lo) return 1;   // emptied meanwhile; look again
+
+    pthread_mutex_lock(&me->lock);
+    me->next = lo;
+    me->end = hi;
+    pthread_mutex_unlock(&me->lock);
+    return 1;
+}
+
+static void *worker_main(void *arg) {
+    worker_t *w = arg;
+    pool_t *pool = w->pool;
+    for (;;) {
+        size_t lo, hi;
+        while (take_own(&pool->ranges[w->id], &lo, &hi)) {
+            for (size_t i = lo; i < hi; i++) simulate(pool->trace, pool->model, &pool->results[i]);
+        }
+        if (!steal(pool, w->id)) break;
+    }
+    return NULL;
+}
+
+// ---------------- Parameter grid ---------------- //
+typedef struct {
+    int lo, hi, step;
+} span_t;
+
+static int span_count(span_t s) {
+    return (s.hi - s.lo) / s.step + 1;
+}
+
+// The grid loops below rely on step > 0 and hi >= lo
+static int parse_span(const char *arg, span_t *s) {
+    span_t t;
+    char end;
+    if (sscanf(arg, "%d:%d:%d%c", &t.lo, &t.hi, &t.step, &end) != 3) return -1;
+    if (t.step <= 0 || t.hi < t.lo) return -1;
+    *s = t;
+    return 0;
+}
+
+static int cmp_cost(const void *a, const void *b) {
+    double ca = ((const result_t *)a)->cost, cb = ((const result_t *)b)->cost;
+    return (ca > cb) - (ca < cb);
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "usage: %s (-i trace.csv | -s days) [options]\n"
+        "  -j threads     worker threads (default: all cores)\n"
+        "  -c lo:hi:step  first zone cutoff          (default 600:2000:200)\n"
+        "  -g lo:hi:step  gap between zone cutoffs   (default 0:1000:250)\n"
+        "  -u lo:hi:step  humidity skip %%            (default 60:100:10)\n"
+        "  -w lo:hi:step  pump seconds per zone      (default 10:60:10)\n"
+        "  -t target      soil reading to stay above (default 1500)\n"
+        "  -k weight      cost of a pump-second      (default 20)\n"
+        "  -G gain        ADC counts per pump-second (default 15)\n"
+        "  -T hours       drainage time constant     (default 12)\n"
+        "  -n top         results to print           (default 10)\n", prog);
+}
+
+int main(int argc, char **argv) {
+    const char *csv = NULL;
+    int synthetic_days = 0, threads = (int)sysconf(_SC_NPROCESSORS_ONLN), top = 10;
+    span_t cut = {600, 2000, 200}, gap = {0, 1000, 250}, hum = {60, 100, 10}, water = {10, 60, 10};
+    model_t model = {.gain = 15, .tau_h = 12, .target = 1500, .weight = 20};
+
+    int opt;
+    while ((opt = getopt(argc, argv, "i:s:j:c:g:u:w:t:k:G:T:n:h")) != -1) {
+        switch (opt) {
+        case 'i': csv = optarg; break;
+        case 's': synthetic_days = atoi(optarg); break;
+        case 'j': threads = atoi(optarg); break;
+        case 'c': if (parse_span(optarg, &cut)) { usage(argv[0]); return 2; } break;
+        case 'g': if (parse_span(optarg, &gap)) { usage(argv[0]); return 2; } break;
+        case 'u': if (parse_span(optarg, &hum)) { usage(argv[0]); return 2; } break;
+        case 'w': if (parse_span(optarg, &water)) { usage(argv[0]); return 2; } break;
+        case 't': model.target = (float)atof(optarg); break;
+        case 'k': model.weight = (float)atof(optarg); break;
+        case 'G': model.gain = (float)atof(optarg); break;
+        case 'T': model.tau_h = (float)atof(optarg); break;
+        case 'n': top = atoi(optarg); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if ((!csv && synthetic_days <= 0) || threads < 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    trace_t trace;
+    if (csv) {
+        if (trace_load_csv(&trace, csv)) {
+            fprintf(stderr, "%s: no samples\n", csv);
+            return 1;
+        }
+    } else {
+        trace_synthetic(&trace, synthetic_days);
+    }
+    trace_prepare(&trace, &model);
+
+    // Grid: three cutoffs (c, c+g1, c+g1+g2) like the 1000/1500/2000 bands
+    size_t combos = (size_t)span_count(cut) * span_count(gap) * span_count(gap) * span_count(hum) * span_count(water);
+    result_t *results = calloc(combos + 1, sizeof(result_t));
+    if (!results) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    size_t k = 0;
+    for (int c = cut.lo; c <= cut.hi; c += cut.step)
+    for (int g1 = gap.lo; g1 <= gap.hi; g1 += gap.step)
+    for (int g2 = gap.lo; g2 <= gap.hi; g2 += gap.step)
+    for (int u = hum.lo; u <= hum.hi; u += hum.step)
+    for (int w = water.lo; w <= water.hi; w += water.step) {
+        irrigation_params_t *p = &results[k++].params;
+        p->zone_count = 3;
+        p->cutoff[0] = (uint16_t)c;
+        p->cutoff[1] = (uint16_t)(c + g1);
+        p->cutoff[2] = (uint16_t)(c + g1 + g2);
+        p->humidity_skip = (float)u;
+        p->water_seconds = (uint16_t)w;
+    }
+    combos = k;
+
+    // The firmware's current settings, for reference (last slot, not ranked)
+    result_t *baseline = &results[combos];
+    baseline->params = (irrigation_params_t){
+        .zone_count = 3, .cutoff = {1000, 1500, 2000}, .humidity_skip = 80, .water_seconds = 30,
+    };
+    simulate(&trace, &model, baseline);
+
+    // Sweep
+    if ((size_t)threads > combos) threads = (int)combos;
+    pool_t pool = {.trace = &trace, .model = &model, .results = results, .threads = threads};
+    pool.ranges = calloc((size_t)threads, sizeof(work_range_t));
+    worker_t *workers = calloc((size_t)threads, sizeof(worker_t));
+    pthread_t *tids = calloc((size_t)threads, sizeof(pthread_t));
+    for (int i = 0; i < threads; i++) {
+        pthread_mutex_init(&pool.ranges[i].lock, NULL);
+        pool.ranges[i].next = combos * i / threads;
+        pool.ranges[i].end = combos * (i + 1) / threads;
+        workers[i] = (worker_t){.pool = &pool, .id = i};
+    }
+
+    double t0 = now_s();
+    for (int i = 0; i < threads; i++) pthread_create(&tids[i], NULL, worker_main, &workers[i]);
+    for (int i = 0; i < threads; i++) pthread_join(tids[i], NULL);
+    double elapsed = now_s() - t0;
+
+    double span_h = 0;
+    for (size_t i = 0; i < trace.n; i++) span_h += trace.dt[i];
+    span_h /= 3600.0;
+    double rate = (double)combos * trace.n / (elapsed > 0 ? elapsed : 1e-9);
+    printf("trace: %zu samples over %.1f days\n", trace.n, span_h / 24);
+    printf("sweep: %zu combinations on %d threads in %.2f s, %.1f M samples/s (%.1f M/s per thread)\n",
+           combos, threads, elapsed, rate / 1e6, rate / 1e6 / threads);
+
+    qsort(results, combos, sizeof(result_t), cmp_cost);
+    printf("\nrank  cutoffs          hum  pump/zone  pump h  below-target h  cost\n");
+    printf("base  %4u/%4u/%4u  %3.0f  %6us    %6.1f  %14.1f  %.0f\n",
+           baseline->params.cutoff[0], baseline->params.cutoff[1], baseline->params.cutoff[2],
+           baseline->params.humidity_skip, baseline->params.water_seconds,
+           baseline->pump_s / 3600, baseline->below_s / 3600, baseline->cost);
+    for (int i = 0; i < top && (size_t)i < combos; i++) {
+        const result_t *r = &results[i];
+        printf("%4d  %4u/%4u/%4u  %3.0f  %6us    %6.1f  %14.1f  %.0f\n", i + 1,
+               r->params.cutoff[0], r->params.cutoff[1], r->params.cutoff[2],
+               r->params.humidity_skip, r->params.water_seconds,
+               r->pump_s / 3600, r->below_s / 3600, r->cost);
+    }
+
+    for (int i = 0; i < threads; i++) pthread_mutex_destroy(&pool.ranges[i].lock);
+    free(tids);
+    free(workers);
+    free(pool.ranges);
+    free(results);
+    free(trace.soil);
+    free(trace.hum);
+    free(trace.dt);
+    free(trace.decay);
+    return 0;
+}
+
+// End of irrigation_tuner.c
@@ -0,0 +1,3 @@
+// ---------------- FreeRTOS.h (host) ---------------- //
+// Host builds of FreeRTOS.h resolve here; everything lives in net_sim.h.
+#include "net_sim.h"
@@ -0,0 +1,3 @@
+// ---------------- flash.h (host) ---------------- //
+// Host builds of hardware/flash.h resolve here; everything lives in net_sim.h.
+#include "net_sim.h"
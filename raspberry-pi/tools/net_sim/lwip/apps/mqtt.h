@@ -0,0 +1,3 @@
+// ---------------- mqtt.h (host) ---------------- //
+// Host builds of lwip/apps/mqtt.h resolve here; everything lives in net_sim.h.
+#include "net_sim.h"
@@ -0,0 +1,3 @@
+// ---------------- err.h (host) ---------------- //
+// Host builds of lwip/err.h resolve here; everything lives in net_sim.h.
+#include "net_sim.h"
@@ -0,0 +1,3 @@
+// ---------------- ip_addr.h (host) ---------------- //
+// Host builds of lwip/ip_addr.h resolve here; everything lives in net_sim.h.
+#include "net_sim.h"
@@ -0,0 +1,3 @@
+// ---------------- tcp.h (host) ---------------- //
+// Host builds of lwip/tcp.h resolve here; everything lives in net_sim.h.
+#include "net_sim.h"
@@ -0,0 +1,569 @@
+// ---------------- net_sim.c ---------------- //
+/*
+ * Tasks, queues, clock, flash and the MQTT client stand-in (see net_sim.h).
+ */
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <linux/sockios.h>
+#include "net_sim.h"
+#include "flash_layout.h"
+
+net_sim_t net_sim = { .speed = 1, .link = CYW43_LINK_UP, .broker_up = true, .tcp_port = -1 };
+const ip_addr_t net_sim_ip_any;
+cyw43_t cyw43_state;
+uint8_t net_sim_flash[PICO_FLASH_SIZE_BYTES];
+
+static struct timespec t_start;
+static pthread_mutex_t lwip_lock;   // recursive, like the cyw43 lwIP lock
+
+// ---------------- Clock ---------------- //
+static double wall_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec - t_start.tv_sec) * 1e3 + (ts.tv_nsec - t_start.tv_nsec) * 1e-6;
+}
+
+absolute_time_t get_absolute_time(void) {
+    return (absolute_time_t)(wall_ms() * net_sim.speed * 1000.0);
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(wall_ms() * net_sim.speed);
+}
+
+void net_sim_sleep(uint32_t ms) {
+    double us = ms * 1000.0 / net_sim.speed;
+    struct timespec ts = { (time_t)(us / 1e6), (long)(us * 1000) % 1000000000L };
+    nanosleep(&ts, NULL);
+}
+
+// Absolute CLOCK_REALTIME deadline `ticks` simulated ms from now, for condvar waits.
+static struct timespec deadline(TickType_t ticks) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    double ns = ticks * 1e6 / net_sim.speed + ts.tv_nsec;
+    ts.tv_sec += (time_t)(ns / 1e9);
+    ts.tv_nsec = (long)(ns - (double)(time_t)(ns / 1e9) * 1e9);
+    return ts;
+}
+
+// ---------------- Tasks ---------------- //
+struct net_sim_task {
+    pthread_t thread;
+    void (*fn)(void *);
+    void *params;
+};
+
+static __thread struct net_sim_task *current_task;
+
+static void *task_main(void *arg) {
+    current_task = arg;
+    current_task->fn(current_task->params);
+    __atomic_sub_fetch(&net_sim.tasks_running, 1, __ATOMIC_SEQ_CST);
+    return NULL;
+}
+
+TaskHandle_t net_sim_task_start(void (*fn)(void *), void *params) {
+    struct net_sim_task *t = calloc(1, sizeof(*t));
+    t->fn = fn;
+    t->params = params;
+    __atomic_add_fetch(&net_sim.tasks_running, 1, __ATOMIC_SEQ_CST);
+    pthread_create(&t->thread, NULL, task_main, t);
+    pthread_detach(t->thread);
+    return t;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return current_task;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    net_sim_sleep(ticks);
+}
+
+void vTaskDelayUntil(TickType_t *prev, TickType_t period) {
+    *prev += period;
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(*prev - now) > 0) net_sim_sleep(*prev - now);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task == NULL || task == current_task) {
+        __atomic_sub_fetch(&net_sim.tasks_running, 1, __ATOMIC_SEQ_CST);
+        pthread_exit(NULL);
+    }
+    fprintf(stderr, "net_sim: vTaskDelete of another task is not modelled\n");
+    abort();
+}
+
+// ---------------- Queues ---------------- //
+struct net_sim_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    uint8_t *storage;
+    UBaseType_t len, item_size, head, count;
+};
+
+_Static_assert(sizeof(struct net_sim_queue) <= sizeof(StaticQueue_t), "StaticQueue_t too small");
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t len, UBaseType_t item_size, uint8_t *storage, StaticQueue_t *ctrl) {
+    struct net_sim_queue *q = (struct net_sim_queue *)ctrl;
+    memset(q, 0, sizeof(*q));
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->changed, NULL);
+    q->storage = storage;
+    q->len = len;
+    q->item_size = item_size;
+    return q;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t len, UBaseType_t item_size) {
+    return xQueueCreateStatic(len, item_size, malloc(len * item_size), malloc(sizeof(StaticQueue_t)));
+}
+
+static bool queue_wait(QueueHandle_t q, bool want_room, TickType_t wait) {
+    struct timespec until = deadline(wait);
+    while (want_room ? q->count == q->len : q->count == 0) {
+        if (wait == 0) return false;
+        int rc = wait == portMAX_DELAY ? pthread_cond_wait(&q->changed, &q->lock)
+                                       : pthread_cond_timedwait(&q->changed, &q->lock, &until);
+        if (rc != 0 && (want_room ? q->count == q->len : q->count == 0)) return false;
+    }
+    return true;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t wait) {
+    pthread_mutex_lock(&q->lock);
+    bool ok = queue_wait(q, true, wait);
+    if (ok) {
+        memcpy(q->storage + (q->head + q->count) % q->len * q->item_size, item, q->item_size);
+        q->count++;
+        pthread_cond_broadcast(&q->changed);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return ok ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t wait) {
+    pthread_mutex_lock(&q->lock);
+    bool ok = queue_wait(q, false, wait);
+    if (ok) {
+        memcpy(item, q->storage + q->head * q->item_size, q->item_size);
+        q->head = (q->head + 1) % q->len;
+        q->count--;
+        pthread_cond_broadcast(&q->changed);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return ok ? pdTRUE : pdFALSE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+    pthread_mutex_lock(&q->lock);
+    UBaseType_t n = q->count;
+    pthread_mutex_unlock(&q->lock);
+    return n;
+}
+
+// ---------------- Board ---------------- //
+void pico_get_unique_board_id_string(char *id_out, unsigned len) {
+    snprintf(id_out, len, "E6614103E7452D2F");
+}
+
+// Same alignment rules as the SDK, which asserts on them
+static void flash_check(const char *what, uint32_t offset, size_t count, uint32_t align) {
+    if (offset % align == 0 && count % align == 0 && offset + count <= PICO_FLASH_SIZE_BYTES) return;
+    fprintf(stderr, "net_sim: %s of %zu bytes at 0x%x is misaligned or out of range\n", what, count, offset);
+    abort();
+}
+
+void flash_range_erase(uint32_t offset, size_t count) {
+    flash_check("erase", offset, count, FLASH_SECTOR_SIZE);
+    memset(net_sim_flash + offset, 0xFF, count);
+    net_sim.flash_erases++;
+}
+
+void flash_range_program(uint32_t offset, const uint8_t *data, size_t count) {
+    flash_check("program", offset, count, FLASH_PAGE_SIZE);
+    for (size_t i = 0; i < count; i++) {
+        if (data[i] & ~net_sim_flash[offset + i]) {
+            net_sim.flash_bad_programs++;
+            break;
+        }
+    }
+    for (size_t i = 0; i < count; i++) net_sim_flash[offset + i] &= data[i];
+    net_sim.flash_programs++;
+}
+
+int flash_safe_execute(void (*fn)(void *), void *param, uint32_t timeout_ms) {
+    (void)timeout_ms;
+    fn(param);
+    return 0;
+}
+
+int cyw43_arch_init(void) { return net_sim.wifi_init_err; }
+void cyw43_arch_enable_sta_mode(void) {}
+int cyw43_arch_wifi_connect_async(const char *ssid, const char *pw, uint32_t auth) {
+    (void)ssid; (void)pw; (void)auth;
+    return 0;
+}
+int cyw43_tcpip_link_status(cyw43_t *self, int itf) {
+    (void)self; (void)itf;
+    return net_sim.link;
+}
+
+void cyw43_arch_lwip_begin(void) { pthread_mutex_lock(&lwip_lock); }
+void cyw43_arch_lwip_end(void) { pthread_mutex_unlock(&lwip_lock); }
+
+int ipaddr_aton(const char *cp, ip_addr_t *addr) {
+    unsigned a, b, c, d;
+    if (sscanf(cp, "%u.%u.%u.%u", &a, &b, &c, &d) != 4) return 0;
+    addr->addr = a << 24 | b << 16 | c << 8 | d;
+    return 1;
+}
+
+// ---------------- lwIP thread: deferred callbacks ---------------- //
+typedef struct event {
+    TickType_t due;
+    uint32_t session;          // MQTT session the event belongs to
+    void (*fn)(struct event *);
+    mqtt_request_cb_t req_cb;
+    void *arg;
+    err_t err;
+    struct event *next;
+} event_t;
+
+static event_t *events;        // unsorted; guarded by lwip_lock
+
+static void defer(TickType_t delay, void (*fn)(event_t *), event_t *proto) {
+    event_t *e = malloc(sizeof(*e));
+    *e = *proto;
+    e->due = xTaskGetTickCount() + delay;
+    e->fn = fn;
+    e->next = events;
+    events = e;
+}
+
+static void tcp_service(TickType_t now);
+
+static void *lwip_thread(void *arg) {
+    (void)arg;
+    for (;;) {
+        pthread_mutex_lock(&lwip_lock);
+        TickType_t now = xTaskGetTickCount();
+        for (event_t **pp = &events; *pp;) {
+            event_t *e = *pp;
+            if ((int32_t)(now - e->due) < 0) { pp = &e->next; continue; }
+            *pp = e->next;
+            e->fn(e);
+            free(e);
+        }
+        tcp_service(now);
+        pthread_mutex_unlock(&lwip_lock);
+        struct timespec ts = { 0, 100 * 1000 };
+        nanosleep(&ts, NULL);
+    }
+    return NULL;
+}
+
+void net_sim_start(void) {
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&lwip_lock, &attr);
+    memset(net_sim_flash, 0xFF, sizeof(net_sim_flash));
+    pthread_t t;
+    pthread_create(&t, NULL, lwip_thread, NULL);
+    pthread_detach(t);
+}
+
+// ---------------- MQTT client ---------------- //
+struct mqtt_client_s {
+    mqtt_connection_cb_t cb;
+    void *arg;
+    bool connected;
+    uint32_t session;          // bumped on every connect and disconnect
+};
+
+static mqtt_client_t client;
+
+mqtt_client_t *mqtt_client_new(void) {
+    return &client;
+}
+
+static void on_connect(event_t *e) {
+    if (e->session != client.session) return;
+    client.connected = net_sim.broker_up;
+    client.cb(&client, client.arg, client.connected ? MQTT_CONNECT_ACCEPTED : MQTT_CONNECT_REFUSED_SERVER);
+}
+
+err_t mqtt_client_connect(mqtt_client_t *c, const ip_addr_t *ip, u16_t port, mqtt_connection_cb_t cb, void *arg,
+                          const struct mqtt_connect_client_info_t *info) {
+    (void)ip; (void)port; (void)info;
+    cyw43_arch_lwip_begin();
+    c->cb = cb;
+    c->arg = arg;
+    c->session++;
+    defer(20, on_connect, &(event_t){ .session = c->session });
+    cyw43_arch_lwip_end();
+    return ERR_OK;
+}
+
+static void on_reply(event_t *e) {
+    if (e->session == client.session && client.connected) e->req_cb(e->arg, e->err);
+}
+
+err_t mqtt_publish(mqtt_client_t *c, const char *topic, const void *payload, u16_t len, u8_t qos, u8_t retain,
+                   mqtt_request_cb_t cb, void *arg) {
+    (void)topic; (void)qos; (void)retain;
+    if (!c->connected) return ERR_CONN;
+    net_sim.publishes++;
+    uint32_t reply_ms = 0;
+    int verdict = net_sim.broker ? net_sim.broker(payload, len, &reply_ms) : ERR_OK;
+    if (verdict != NET_SIM_NO_REPLY && cb) {
+        defer(reply_ms, on_reply, &(event_t){ .session = c->session, .req_cb = cb, .arg = arg, .err = (err_t)verdict });
+    }
+    return ERR_OK;
+}
+
+static void on_disconnect(event_t *e) {
+    (void)e;
+    if (!client.connected) return;
+    client.connected = false;
+    client.session++;
+    client.cb(&client, client.arg, MQTT_CONNECT_DISCONNECTED);
+}
+
+void net_sim_mqtt_disconnect(void) {
+    cyw43_arch_lwip_begin();
+    defer(0, on_disconnect, &(event_t){ 0 });
+    cyw43_arch_lwip_end();
+}
+
+// ---------------- Raw TCP over host sockets ---------------- //
+struct tcp_pcb {
+    int fd;
+    bool listening, eof, dead;    // dead: closed or aborted, freed by tcp_service
+    void *arg;
+    tcp_accept_fn accept;
+    tcp_recv_fn recv;
+    tcp_sent_fn sent;
+    tcp_poll_fn poll;
+    tcp_err_fn err;
+    u8_t poll_interval;
+    TickType_t next_poll;
+    uint32_t queued;              // written, not yet taken by the kernel
+    uint32_t unacked;             // taken by the kernel, still in its send queue
+    uint8_t out[TCP_SND_BUF];
+    struct tcp_pcb *next;
+};
+
+static struct tcp_pcb *pcbs;      // guarded by lwip_lock
+
+static struct tcp_pcb *pcb_new(int fd) {
+    struct tcp_pcb *pcb = calloc(1, sizeof(*pcb));
+    pcb->fd = fd;
+    pcb->next = pcbs;
+    pcbs = pcb;
+    net_sim.tcp_pcbs++;
+    return pcb;
+}
+
+// Mark for freeing; lwIP callers may still hold the pointer until they return
+static void pcb_kill(struct tcp_pcb *pcb, bool reset) {
+    if (pcb->fd >= 0) {
+        if (reset) setsockopt(pcb->fd, SOL_SOCKET, SO_LINGER, &(struct linger){ 1, 0 }, sizeof(struct linger));
+        close(pcb->fd);
+        pcb->fd = -1;
+    }
+    pcb->dead = true;
+}
+
+struct tcp_pcb *tcp_new_ip_type(u8_t type) {
+    (void)type;
+    return pcb_new(-1);
+}
+
+err_t tcp_bind(struct tcp_pcb *pcb, const ip_addr_t *ip, u16_t port) {
+    (void)ip;
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &(int){ 1 }, sizeof(int));
+    struct sockaddr_in sa = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    sa.sin_port = htons(net_sim.tcp_port >= 0 ? (uint16_t)net_sim.tcp_port : port);
+    socklen_t sl = sizeof(sa);
+    if (bind(fd, (struct sockaddr *)&sa, sizeof(sa)) != 0 || getsockname(fd, (struct sockaddr *)&sa, &sl) != 0) {
+        close(fd);
+        return ERR_USE;
+    }
+    net_sim.tcp_bound_port = ntohs(sa.sin_port);
+    pcb->fd = fd;
+    return ERR_OK;
+}
+
+// Like lwIP: on success the bound pcb is freed and a listen pcb returned
+struct tcp_pcb *tcp_listen_with_backlog(struct tcp_pcb *pcb, u8_t backlog) {
+    if (net_sim.tcp_listen_fail || pcb->fd < 0 || listen(pcb->fd, backlog) != 0) return NULL;
+    struct tcp_pcb *l = pcb_new(pcb->fd);
+    l->listening = true;
+    l->arg = pcb->arg;
+    pcb->fd = -1;
+    pcb_kill(pcb, false);
+    return l;
+}
+
+void tcp_arg(struct tcp_pcb *pcb, void *arg) { pcb->arg = arg; }
+void tcp_accept(struct tcp_pcb *pcb, tcp_accept_fn fn) { pcb->accept = fn; }
+void tcp_recv(struct tcp_pcb *pcb, tcp_recv_fn fn) { pcb->recv = fn; }
+void tcp_sent(struct tcp_pcb *pcb, tcp_sent_fn fn) { pcb->sent = fn; }
+void tcp_err(struct tcp_pcb *pcb, tcp_err_fn fn) { pcb->err = fn; }
+void tcp_recved(struct tcp_pcb *pcb, u16_t len) { (void)pcb; (void)len; }
+
+void tcp_poll(struct tcp_pcb *pcb, tcp_poll_fn fn, u8_t interval) {
+    pcb->poll = fn;
+    pcb->poll_interval = interval;
+    pcb->next_poll = xTaskGetTickCount() + interval * 500u;
+}
+
+void tcp_nagle_disable(struct tcp_pcb *pcb) {
+    setsockopt(pcb->fd, IPPROTO_TCP, TCP_NODELAY, &(int){ 1 }, sizeof(int));
+}
+
+u16_t tcp_sndbuf(struct tcp_pcb *pcb) {
+    return (u16_t)(TCP_SND_BUF - pcb->queued - pcb->unacked);
+}
+
+err_t tcp_write(struct tcp_pcb *pcb, const void *data, u16_t len, u8_t flags) {
+    (void)flags;                  // always copied; zero-copy lifetimes are not checked
+    if (pcb->dead || pcb->fd < 0) return ERR_CONN;
+    if (len > tcp_sndbuf(pcb)) return ERR_MEM;
+    memcpy(pcb->out + pcb->queued, data, len);
+    pcb->queued += len;
+    return ERR_OK;
+}
+
+err_t tcp_output(struct tcp_pcb *pcb) {
+    if (pcb->dead || pcb->fd < 0 || pcb->queued == 0) return ERR_OK;
+    ssize_t n = send(pcb->fd, pcb->out, pcb->queued, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n > 0) {
+        memmove(pcb->out, pcb->out + n, pcb->queued - (uint32_t)n);
+        pcb->queued -= (uint32_t)n;
+        pcb->unacked += (uint32_t)n;
+    }
+    return ERR_OK;
+}
+
+err_t tcp_close(struct tcp_pcb *pcb) {
+    tcp_output(pcb);
+    pcb_kill(pcb, false);
+    return ERR_OK;
+}
+
+void tcp_abort(struct tcp_pcb *pcb) {
+    tcp_err_fn err = pcb->err;
+    void *arg = pcb->arg;
+    pcb_kill(pcb, true);
+    if (err) err(arg, ERR_ABRT);
+}
+
+u16_t pbuf_copy_partial(const struct pbuf *p, void *dst, u16_t len, u16_t offset) {
+    if (offset >= p->len) return 0;
+    u16_t n = (u16_t)(p->len - offset) < len ? (u16_t)(p->len - offset) : len;
+    memcpy(dst, (const uint8_t *)p->payload + offset, n);
+    return n;
+}
+
+u8_t pbuf_free(struct pbuf *p) {
+    free(p);
+    return 1;
+}
+
+// Connection lost: like lwIP, the pcb is gone before the error callback runs
+static void pcb_lost(struct tcp_pcb *pcb, err_t why) {
+    tcp_err_fn err = pcb->err;
+    void *arg = pcb->arg;
+    pcb_kill(pcb, false);
+    if (err) err(arg, why);
+}
+
+static void service_listen(struct tcp_pcb *l) {
+    int fd;
+    while (!l->dead && (fd = accept4(l->fd, NULL, NULL, SOCK_NONBLOCK)) >= 0) {
+        struct tcp_pcb *pcb = pcb_new(fd);
+        pcb->arg = l->arg;
+        if (!l->accept || l->accept(l->arg, pcb, ERR_OK) != ERR_OK) {
+            if (!pcb->dead) pcb_kill(pcb, true);
+        }
+    }
+}
+
+static void service_conn(struct tcp_pcb *pcb, TickType_t now) {
+    tcp_output(pcb);
+
+    // Acked = left the kernel's send queue
+    int outq = 0;
+    if (pcb->unacked && ioctl(pcb->fd, SIOCOUTQ, &outq) == 0 && (uint32_t)outq < pcb->unacked) {
+        uint32_t acked = pcb->unacked - (uint32_t)outq;
+        pcb->unacked = (uint32_t)outq;
+        while (acked && !pcb->dead && pcb->sent) {
+            u16_t n = acked > 0xFFFF ? 0xFFFF : (u16_t)acked;
+            acked -= n;
+            if (pcb->sent(pcb->arg, pcb, n) == ERR_ABRT) return;
+        }
+    }
+
+    while (!pcb->dead && !pcb->eof) {
+        uint8_t buf[1024];
+        ssize_t n = recv(pcb->fd, buf, sizeof(buf), 0);
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) pcb_lost(pcb, ERR_RST);
+            break;
+        }
+        struct pbuf *p = NULL;
+        if (n == 0) {
+            pcb->eof = true;
+        } else {
+            p = malloc(sizeof(*p) + (size_t)n);
+            *p = (struct pbuf){ .payload = p + 1, .tot_len = (u16_t)n, .len = (u16_t)n };
+            memcpy(p->payload, buf, (size_t)n);
+        }
+        if (!pcb->recv) {             // lwIP's tcp_recv_null
+            if (p) pbuf_free(p);
+            else tcp_close(pcb);
+        } else if (pcb->recv(pcb->arg, pcb, p, ERR_OK) == ERR_ABRT) {
+            return;
+        }
+    }
+
+    if (!pcb->dead && pcb->poll && (int32_t)(now - pcb->next_poll) >= 0) {
+        pcb->next_poll = now + pcb->poll_interval * 500u;
+        pcb->poll(pcb->arg, pcb);
+    }
+}
+
+static void tcp_service(TickType_t now) {
+    for (struct tcp_pcb *pcb = pcbs; pcb; pcb = pcb->next) {
+        if (pcb->dead || pcb->fd < 0) continue;
+        if (pcb->listening) service_listen(pcb);
+        else service_conn(pcb, now);
+    }
+    for (struct tcp_pcb **pp = &pcbs; *pp;) {
+        struct tcp_pcb *pcb = *pp;
+        if (!pcb->dead) { pp = &pcb->next; continue; }
+        *pp = pcb->next;
+        free(pcb);
+        net_sim.tcp_pcbs--;
+    }
+}
+
+// End of net_sim.c
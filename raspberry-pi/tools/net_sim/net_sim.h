@@ -0,0 +1,214 @@
+// ---------------- net_sim.h ---------------- //
+/*
+ * Host stand-in for the FreeRTOS, cyw43, flash and lwIP calls made by the
+ * networked modules (telemetry.c, http_dashboard.c), so they build and run
+ * unchanged on a PC. Build host tools with -Inet_sim -Ihal_sim: "FreeRTOS.h", "task.h",
+ * "lwip/apps/mqtt.h", ... resolve here, "pico/stdlib.h" in hal_sim.
+ *
+ *   - tasks are pthreads (net_sim_task_start), queues are mutex + condvar;
+ *   - one tick is one simulated ms, and the simulated clock runs
+ *     net_sim.speed times faster than the wall clock, so minute-long
+ *     timeouts take milliseconds;
+ *   - an "lwIP thread" runs deferred callbacks under the same lock that
+ *     cyw43_arch_lwip_begin/end take, like the real tcpip thread;
+ *   - flash is a RAM array with NOR rules (erase sets bits, programming
+ *     only clears them); net_sim.flash_bad_programs counts attempts to set
+ *     a bit without an erase, and misaligned operations abort;
+ *   - the MQTT client hands every publish to net_sim.broker, which stores
+ *     it (or not) and says how and when to reply;
+ *   - raw TCP pcbs are non-blocking host sockets on 127.0.0.1, polled by
+ *     the lwIP thread. tcp_write copies into a TCP_SND_BUF-sized buffer,
+ *     and bytes count as acked once the kernel's send queue (SIOCOUTQ)
+ *     has drained them, so a client that stops reading holds its window
+ *     the way it would on the device.
+ */
+#ifndef NET_SIM_H
+#define NET_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// ---------------- FreeRTOS ---------------- //
+#define configSUPPORT_STATIC_ALLOCATION 1
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef struct net_sim_task *TaskHandle_t;
+typedef struct net_sim_queue *QueueHandle_t;
+typedef struct { uint8_t opaque[256]; } StaticQueue_t;   // control block, holds a net_sim_queue
+
+#define pdTRUE  1
+#define pdFALSE 0
+#define pdPASS  pdTRUE
+#define portMAX_DELAY 0xFFFFFFFFu
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+TickType_t xTaskGetTickCount(void);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t *prev, TickType_t period);
+void vTaskDelete(TaskHandle_t task);      // NULL only: ends the calling thread
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+
+QueueHandle_t xQueueCreate(UBaseType_t len, UBaseType_t item_size);
+QueueHandle_t xQueueCreateStatic(UBaseType_t len, UBaseType_t item_size, uint8_t *storage, StaticQueue_t *ctrl);
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t wait);
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t wait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q);
+
+// ---------------- pico time ---------------- //
+typedef uint64_t absolute_time_t;         // simulated us since start
+absolute_time_t get_absolute_time(void);
+static inline uint32_t to_ms_since_boot(absolute_time_t t) { return (uint32_t)(t / 1000); }
+static inline uint32_t time_us_32(void) { return (uint32_t)get_absolute_time(); }
+
+// ---------------- pico/unique_id.h ---------------- //
+#define PICO_UNIQUE_BOARD_ID_SIZE_BYTES 8
+void pico_get_unique_board_id_string(char *id_out, unsigned len);
+
+// ---------------- flash ---------------- //
+extern uint8_t net_sim_flash[];
+#define XIP_BASE ((uintptr_t)net_sim_flash)
+void flash_range_erase(uint32_t offset, size_t count);
+void flash_range_program(uint32_t offset, const uint8_t *data, size_t count);
+int flash_safe_execute(void (*fn)(void *), void *param, uint32_t timeout_ms);
+
+// ---------------- lwIP basics ---------------- //
+typedef int8_t err_t;
+typedef uint8_t u8_t;
+typedef uint16_t u16_t;
+typedef uint32_t u32_t;
+#define ERR_OK       0
+#define ERR_MEM     -1
+#define ERR_TIMEOUT -3
+#define ERR_VAL     -6
+#define ERR_USE     -8
+#define ERR_CONN   -11
+#define ERR_ABRT   -13
+#define ERR_RST    -14
+
+typedef struct { uint32_t addr; } ip_addr_t;
+int ipaddr_aton(const char *cp, ip_addr_t *addr);
+
+#define IPADDR_TYPE_ANY 46
+extern const ip_addr_t net_sim_ip_any;
+#define IP_ANY_TYPE (&net_sim_ip_any)
+
+// ---------------- cyw43 ---------------- //
+#define CYW43_ITF_STA 0
+#define CYW43_LINK_DOWN 0
+#define CYW43_LINK_JOIN 1
+#define CYW43_LINK_UP   3
+#define CYW43_AUTH_WPA2_AES_PSK 0x00400004
+
+typedef struct { int unused; } cyw43_t;
+extern cyw43_t cyw43_state;
+
+int cyw43_arch_init(void);
+void cyw43_arch_enable_sta_mode(void);
+int cyw43_arch_wifi_connect_async(const char *ssid, const char *pw, uint32_t auth);
+int cyw43_tcpip_link_status(cyw43_t *self, int itf);
+void cyw43_arch_lwip_begin(void);
+void cyw43_arch_lwip_end(void);
+
+// ---------------- lwip/apps/mqtt.h ---------------- //
+typedef struct mqtt_client_s mqtt_client_t;
+
+typedef enum {
+    MQTT_CONNECT_ACCEPTED = 0,
+    MQTT_CONNECT_REFUSED_SERVER = 3,
+    MQTT_CONNECT_DISCONNECTED = 256,
+    MQTT_CONNECT_TIMEOUT = 257,
+} mqtt_connection_status_t;
+
+struct mqtt_connect_client_info_t {
+    const char *client_id;
+    const char *client_user, *client_pass;
+    u16_t keep_alive;
+    const char *will_topic, *will_msg;
+    u8_t will_qos, will_retain;
+};
+
+typedef void (*mqtt_connection_cb_t)(mqtt_client_t *client, void *arg, mqtt_connection_status_t status);
+typedef void (*mqtt_request_cb_t)(void *arg, err_t err);
+
+mqtt_client_t *mqtt_client_new(void);
+err_t mqtt_client_connect(mqtt_client_t *client, const ip_addr_t *ip, u16_t port, mqtt_connection_cb_t cb,
+                          void *arg, const struct mqtt_connect_client_info_t *info);
+err_t mqtt_publish(mqtt_client_t *client, const char *topic, const void *payload, u16_t len, u8_t qos,
+                   u8_t retain, mqtt_request_cb_t cb, void *arg);
+
+// ---------------- lwip/tcp.h ---------------- //
+#define TCP_SND_BUF (8 * 1460)     // 8 * TCP_MSS, as in the firmware's lwipopts.h
+#define TCP_WRITE_FLAG_COPY 0x01
+
+struct pbuf {
+    struct pbuf *next;
+    void *payload;
+    u16_t tot_len, len;
+};
+u16_t pbuf_copy_partial(const struct pbuf *p, void *dst, u16_t len, u16_t offset);
+u8_t pbuf_free(struct pbuf *p);
+
+struct tcp_pcb;
+typedef err_t (*tcp_accept_fn)(void *arg, struct tcp_pcb *newpcb, err_t err);
+typedef err_t (*tcp_recv_fn)(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err);
+typedef err_t (*tcp_sent_fn)(void *arg, struct tcp_pcb *pcb, u16_t len);
+typedef err_t (*tcp_poll_fn)(void *arg, struct tcp_pcb *pcb);
+typedef void (*tcp_err_fn)(void *arg, err_t err);
+
+struct tcp_pcb *tcp_new_ip_type(u8_t type);
+err_t tcp_bind(struct tcp_pcb *pcb, const ip_addr_t *ip, u16_t port);
+struct tcp_pcb *tcp_listen_with_backlog(struct tcp_pcb *pcb, u8_t backlog);
+void tcp_arg(struct tcp_pcb *pcb, void *arg);
+void tcp_accept(struct tcp_pcb *pcb, tcp_accept_fn fn);
+void tcp_recv(struct tcp_pcb *pcb, tcp_recv_fn fn);
+void tcp_sent(struct tcp_pcb *pcb, tcp_sent_fn fn);
+void tcp_err(struct tcp_pcb *pcb, tcp_err_fn fn);
+void tcp_poll(struct tcp_pcb *pcb, tcp_poll_fn fn, u8_t interval);   // interval in 500 ms ticks
+void tcp_nagle_disable(struct tcp_pcb *pcb);
+err_t tcp_write(struct tcp_pcb *pcb, const void *data, u16_t len, u8_t flags);
+err_t tcp_output(struct tcp_pcb *pcb);
+u16_t tcp_sndbuf(struct tcp_pcb *pcb);
+void tcp_recved(struct tcp_pcb *pcb, u16_t len);
+err_t tcp_close(struct tcp_pcb *pcb);
+void tcp_abort(struct tcp_pcb *pcb);
+
+// ---------------- Simulator control ---------------- //
+#define NET_SIM_NO_REPLY 1   // broker verdict: never answer this publish
+
+// Called from mqtt_publish(), under the lwIP lock. Returns the err_t the
+// client's callback gets (ERR_OK = PUBACK) after *reply_ms simulated ms,
+// or NET_SIM_NO_REPLY.
+typedef int (*net_sim_broker_fn)(const uint8_t *payload, uint16_t len, uint32_t *reply_ms);
+
+typedef struct {
+    double speed;               // simulated ms per wall-clock ms (default 1)
+    int wifi_init_err;          // cyw43_arch_init() result
+    int link;                   // cyw43_tcpip_link_status() result
+    bool broker_up;             // connects are accepted
+    net_sim_broker_fn broker;
+    uint32_t publishes;         // mqtt_publish calls accepted
+    uint32_t flash_erases, flash_programs;
+    uint32_t flash_bad_programs;    // programs that tried to set an already-cleared bit
+    int tcp_port;               // host port tcp_bind uses: -1 = the one asked for, 0 = any free
+    uint16_t tcp_bound_port;    // where the last tcp_bind landed
+    bool tcp_listen_fail;       // tcp_listen_with_backlog returns NULL (out of pcbs)
+    int tcp_pcbs;               // pcbs allocated and not yet freed
+    int tasks_running;          // net_sim_task_start tasks that have not returned or deleted themselves
+} net_sim_t;
+
+extern net_sim_t net_sim;
+
+// Start the clock and the lwIP thread. Call once, after setting net_sim.
+void net_sim_start(void);
+// Run fn(params) as a task on its own thread.
+TaskHandle_t net_sim_task_start(void (*fn)(void *), void *params);
+// Drop the broker session: the connection callback sees DISCONNECTED and
+// replies still pending for the old session are never delivered.
+void net_sim_mqtt_disconnect(void);
+// Wall-clock sleep for `ms` simulated ms.
+void net_sim_sleep(uint32_t ms);
+
+#endif // NET_SIM_H
@@ -0,0 +1,3 @@
+// ---------------- cyw43_arch.h (host) ---------------- //
+// Host builds of pico/cyw43_arch.h resolve here; everything lives in net_sim.h.
+#include "net_sim.h"
@@ -0,0 +1,3 @@
+// ---------------- unique_id.h (host) ---------------- //
+// Host builds of pico/unique_id.h resolve here; everything lives in net_sim.h.
+#include "net_sim.h"
@@ -0,0 +1,3 @@
+// ---------------- queue.h (host) ---------------- //
+// Host builds of queue.h resolve here; everything lives in net_sim.h.
+#include "net_sim.h"
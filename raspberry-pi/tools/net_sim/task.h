@@ -0,0 +1,3 @@
+// ---------------- task.h (host) ---------------- //
+// Host builds of task.h resolve here; everything lives in net_sim.h.
+#include "net_sim.h"
@@ -0,0 +1,311 @@
+// ---------------- oled_render.c ---------------- //
+/*
+ * Host tool: draws the firmware's OLED status screen (status_screen.c,
+ * oled.c) against tools/hal_sim and decodes the I2C traffic with a model
+ * of the SSD1306's RAM. For a few typical frames it
+ *   - checks that the panel RAM matches the framebuffer after every
+ *     flush (exit 1 if not),
+ *   - reports the pages and bytes each flush puts on the bus,
+ *   - writes what the panel shows as a PNG (or ASCII with -a),
+ * and then times full and typical status refreshes.
+ *
+ * Build:  cc -O2 -I.. -Ihal_sim oled_render.c hal_sim/hal_sim.c ../oled.c ../status_screen.c \
+ *             ../checksum.c -o oled_render
+ * Usage:  oled_render [-z zones] [-o dir] [-s scale] [-a]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "pico/stdlib.h"
+#include "oled.h"
+#include "status_screen.h"
+#include "checksum.h"
+
+#define TARGET_US 5000      // full status refresh budget on the device
+
+// ---------------- SSD1306 model ---------------- //
+static struct {
+    uint8_t gram[OLED_PAGES][OLED_WIDTH];
+    uint8_t col0, col1, page0, page1, col, page;
+    uint8_t cmd, need, got, arg[2];
+    uint32_t unknown_ctrl;
+} panel = {.col1 = OLED_WIDTH - 1, .page1 = OLED_PAGES - 1};
+
+static int cmd_arg_count(uint8_t cmd) {
+    switch (cmd) {
+    case 0x21: case 0x22: return 2;
+    case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3: case 0xD5: case 0xD9: case 0xDA: case 0xDB: return 1;
+    default: return 0;
+    }
+}
+
+static void panel_cmd(uint8_t b) {
+    if (panel.need) {
+        panel.arg[panel.got++] = b;
+        if (panel.got < panel.need) return;
+        panel.need = 0;
+    } else {
+        panel.cmd = b;
+        panel.got = 0;
+        panel.need = (uint8_t)cmd_arg_count(b);
+        if (panel.need) return;
+    }
+    if (panel.cmd == 0x21) {
+        panel.col0 = panel.col = panel.arg[0] & 0x7F;
+        panel.col1 = panel.arg[1] & 0x7F;
+    } else if (panel.cmd == 0x22) {
+        panel.page0 = panel.page = panel.arg[0] & 7;
+        panel.page1 = panel.arg[1] & 7;
+    }
+}
+
+// Horizontal addressing: along the column window, then the next page
+static void panel_data(uint8_t b) {
+    panel.gram[panel.page][panel.col] = b;
+    if (panel.col++ < panel.col1) return;
+    panel.col = panel.col0;
+    panel.page = panel.page < panel.page1 ? panel.page + 1 : panel.page0;
+}
+
+static void panel_tap(uint8_t addr, const uint8_t *src, size_t len) {
+    if (addr != OLED_ADDR) return;
+    size_t i = 0;
+    while (i < len) {
+        uint8_t ctrl = src[i++];
+        if (ctrl & 0x3F) panel.unknown_ctrl++;
+        void (*sink)(uint8_t) = ctrl & 0x40 ? panel_data : panel_cmd;
+        if (ctrl & 0x80) {
+            if (i < len) sink(src[i++]);    // Co: one byte, then another control byte
+        } else {
+            while (i < len) sink(src[i++]);
+        }
+    }
+}
+
+static bool panel_matches(void) {
+    return memcmp(panel.gram, oled_framebuffer(), sizeof(panel.gram)) == 0 && !panel.unknown_ctrl;
+}
+
+// ---------------- Output ---------------- //
+static bool lit(int x, int y) {
+    return (panel.gram[y / 8][x] >> (y % 8)) & 1;
+}
+
+static void put_be32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static void png_chunk(FILE *f, const char *type, const uint8_t *data, uint32_t len) {
+    uint8_t hdr[8], crc[4];
+    put_be32(hdr, len);
+    memcpy(hdr + 4, type, 4);
+    fwrite(hdr, 1, 8, f);
+    fwrite(data, 1, len, f);
+    put_be32(crc, crc32_update(crc32_update(0, hdr + 4, 4), data, len));
+    fwrite(crc, 1, 4, f);
+}
+
+// 1-bit greyscale, lit pixels white, stored (uncompressed) deflate blocks
+static bool write_png(const char *path, int scale) {
+    int w = OLED_WIDTH * scale, h = OLED_HEIGHT * scale, stride = 1 + (w + 7) / 8;
+    size_t raw_len = (size_t)stride * h;
+    uint8_t *raw = calloc(raw_len, 1);
+    uint8_t *z = malloc(raw_len + raw_len / 65535 * 5 + 16);
+    FILE *f = fopen(path, "wb");
+    if (!raw || !z || !f) {
+        perror(path);
+        free(raw);
+        free(z);
+        if (f) fclose(f);
+        return false;
+    }
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            if (lit(x / scale, y / scale)) raw[y * stride + 1 + x / 8] |= (uint8_t)(0x80 >> (x % 8));
+        }
+    }
+
+    size_t n = 0;
+    uint32_t a = 1, b = 0;
+    z[n++] = 0x78;
+    z[n++] = 0x01;
+    for (size_t off = 0; off < raw_len;) {
+        size_t len = raw_len - off > 65535 ? 65535 : raw_len - off;
+        z[n++] = off + len == raw_len;
+        z[n++] = (uint8_t)len;
+        z[n++] = (uint8_t)(len >> 8);
+        z[n++] = (uint8_t)~len;
+        z[n++] = (uint8_t)(~len >> 8);
+        memcpy(z + n, raw + off, len);
+        n += len;
+        off += len;
+    }
+    for (size_t i = 0; i < raw_len; i++) {
+        a = (a + raw[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    put_be32(z + n, b << 16 | a);
+    n += 4;
+
+    uint8_t ihdr[13] = {0};
+    put_be32(ihdr, (uint32_t)w);
+    put_be32(ihdr + 4, (uint32_t)h);
+    ihdr[8] = 1;            // bit depth; colour type 0, deflate, no filter, no interlace
+    static const uint8_t sig[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    fwrite(sig, 1, 8, f);
+    png_chunk(f, "IHDR", ihdr, 13);
+    png_chunk(f, "IDAT", z, (uint32_t)n);
+    png_chunk(f, "IEND", NULL, 0);
+    fclose(f);
+    free(raw);
+    free(z);
+    return true;
+}
+
+static void print_ascii(void) {
+    for (int y = 0; y < OLED_HEIGHT; y++) {
+        for (int x = 0; x < OLED_WIDTH; x++) putchar(lit(x, y) ? '#' : '.');
+        putchar('\n');
+    }
+}
+
+// ---------------- Scenario ---------------- //
+static status_screen_t screen;
+static screen_live_t live = {.soil_pct = 48, .temperature = 23.4f, .humidity = 45, .watering_zone = -1};
+static uint8_t thresholds[SCREEN_MAX_ZONES] = {50, 25, 0, 40, 60, 30};
+
+// Beds drying slowly, each watered back up when it crosses its threshold
+static void fill_trends(int zones, int points) {
+    uint8_t pct[SCREEN_MAX_ZONES];
+    float m[SCREEN_MAX_ZONES];
+    for (int z = 0; z < zones; z++) m[z] = 70.0f - 9 * z;
+    for (int i = 0; i < points; i++) {
+        for (int z = 0; z < zones; z++) {
+            m[z] -= 0.35f + 0.1f * z + (float)((i * 7 + z * 13) % 5) * 0.08f;
+            if (m[z] < thresholds[z] - 2) m[z] += 40;
+            if (m[z] < 0) m[z] = 0;
+            pct[z] = (uint8_t)m[z];
+        }
+        screen_moisture(&screen, pct, (uint32_t)i * SCREEN_TREND_PERIOD_S);
+    }
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static bool refresh(void) {
+    screen_draw(&screen, &live);
+    oled_flush();
+    return panel_matches();
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "usage: %s [-z zones] [-o dir] [-s scale] [-a]\n"
+        "  -z zones  zone rows on the screen, 1-%d (default 3, the virtual-zone site)\n"
+        "  -o dir    where the PNGs go (default .)\n"
+        "  -s scale  pixels per OLED pixel in the PNGs (default 4)\n"
+        "  -a        print the frames as ASCII instead of writing PNGs\n", prog, SCREEN_MAX_ZONES);
+}
+
+int main(int argc, char **argv) {
+    int zones = 3, scale = 4;
+    const char *dir = ".";
+    bool ascii = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "z:o:s:ah")) != -1) {
+        switch (opt) {
+        case 'z': zones = atoi(optarg); break;
+        case 'o': dir = optarg; break;
+        case 's': scale = atoi(optarg); break;
+        case 'a': ascii = true; break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (zones < 1 || zones > SCREEN_MAX_ZONES || scale < 1 || scale > 16) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    hal_sim.i2c_tap = panel_tap;
+    i2c_init(I2C_PORT, OLED_I2C_HZ);
+    oled_init();
+    screen_init(&screen, zones, thresholds);
+    fill_trends(zones, SCREEN_TREND_LEN + 20);
+
+    // Frames as the firmware would produce them, in order
+    static const struct { const char *name; int8_t zone; int seconds; uint8_t dry; const char *msg; } frames[] = {
+        {"boot",     -1,  0, 0,    NULL},
+        {"dry",      -1,  0, 0x02, NULL},
+        {"watering",  1, 30, 0x02, NULL},
+        {"countdown", 1, 29, 0x02, NULL},
+        {"done",     -1,  0, 0,    "Zone Done"},
+        {"alert",    -1,  0, 0,    "INTRUSION"},
+    };
+    bool ok = true;
+    printf("%-10s %-6s %6s %9s\n", "frame", "pages", "bytes", "bus ms");
+    for (size_t i = 0; i < sizeof(frames) / sizeof(frames[0]); i++) {
+        live.watering_zone = (int8_t)(frames[i].zone < zones ? frames[i].zone : zones - 1);
+        live.watering_seconds = frames[i].seconds;
+        live.dry_zones = frames[i].dry;
+        if (frames[i].msg) screen_message(&screen, frames[i].msg);
+        hal_sim_reset();
+        screen_draw(&screen, &live);
+        uint8_t pages = oled_dirty_pages();
+        oled_flush();
+        bool match = panel_matches();
+        ok &= match;
+
+        char list[OLED_PAGES * 2 + 1] = "";
+        for (int p = 0; p < OLED_PAGES; p++) if (pages & (1u << p)) list[strlen(list)] = (char)('0' + p);
+        printf("%-10s %-6s %6lu %9.2f%s\n", frames[i].name, list[0] ? list : "-",
+               (unsigned long)hal_sim.i2c_bytes, hal_sim.wait_us / 1000, match ? "" : "  PANEL MISMATCH");
+        if (ascii) {
+            printf("\n");
+            print_ascii();
+            printf("\n");
+        } else {
+            char path[512];
+            snprintf(path, sizeof(path), "%s/oled_%s.png", dir, frames[i].name);
+            if (!write_png(path, scale)) return 1;
+        }
+    }
+
+    // Full refresh: every page redrawn and sent. Typical: a second of countdown.
+    const int iters = 2000;
+    double t0 = now_s();
+    hal_sim_reset();
+    for (int i = 0; i < iters; i++) {
+        oled_clear();
+        ok &= refresh();
+    }
+    double full_us = (now_s() - t0) * 1e6 / iters;
+    double full_bytes = (double)hal_sim.i2c_bytes / iters, full_bus = hal_sim.wait_us / iters;
+
+    live.watering_zone = 0;
+    t0 = now_s();
+    hal_sim_reset();
+    for (int i = 0; i < iters; i++) {
+        live.watering_seconds = 30 - i % 30;
+        ok &= refresh();
+    }
+    double tick_us = (now_s() - t0) * 1e6 / iters;
+    double tick_bytes = (double)hal_sim.i2c_bytes / iters, tick_bus = hal_sim.wait_us / iters;
+
+    printf("\nHost CPU per status refresh (draw + flush): full %.1f us, countdown %.1f us (device target < %d us)\n",
+           full_us, tick_us, TARGET_US);
+    printf("I2C at %u kHz: full %.0f bytes / %.2f ms, countdown %.0f bytes / %.2f ms\n", OLED_I2C_HZ / 1000,
+           full_bytes, full_bus / 1000, tick_bytes, tick_bus / 1000);
+    printf("Panel RAM %s the framebuffer after every flush\n", ok ? "matched" : "DID NOT match");
+    return ok ? 0 : 1;
+}
+
+// End of oled_render.c
@@ -0,0 +1,210 @@
+// ---------------- pump_sim.c ---------------- //
+/*
+ * Host tool: runs the pump monitor (pump_drive.h) against a simulated
+ * 12 V DC pump. The model has armature resistance, back-EMF, rotor
+ * inertia and a centrifugal load that collapses when the pump draws air.
+ * Current is sampled mid on-pulse at the PWM rate, like the firmware's
+ * DMA path, and fed to the monitor in 1 ms blocks. The tool reports:
+ *   - supply current peaks with and without the soft start,
+ *   - time from a dry-run / jam onset to the trip and to the cutoff,
+ *   - false trips over many normal runs with noise and air bubbles.
+ *
+ * Build:  cc -O2 -I.. pump_sim.c ../pump_drive.c -o pump_sim -lm
+ * Usage:  pump_sim [-n runs] [-s seed]
+ *         pump_sim -w dry|jam|normal > wave.csv    (ms,mA of one run)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "pump_drive.h"
+
+// Same settings as watering_system_main.c
+static const pump_cfg_t cfg = {
+    .start_permille = 300, .ramp_ms = 250,
+    .inrush_ms = 60, .settle_ms = 200,
+    .ma_per_count = 0.806f,     // 0.1 ohm shunt, x10 amplifier, 3.3 V / 4096
+    .stall_ma = 1200, .stall_ms = 3,
+    .inrush_ma = 1350, .inrush_stall_ms = 10,
+    .dry_ma = 180, .dry_ms = 8,
+};
+
+// Pump model (currents in A; torques in the amps that balance them)
+#define SUPPLY_V   12.0f
+#define R_OHM      8.0f     // 1.5 A locked rotor
+#define EMF_V      9.2f     // back-EMF at rated speed (w = 1)
+#define FRICTION   0.05f
+#define LOAD_WET   0.30f    // 0.35 A running wet
+#define LOAD_DRY   0.03f    // ~0.09 A running dry
+#define LOAD_JAM   6.0f
+#define INERTIA    0.05f    // A*s per unit speed: ~0.1 s spin-up
+#define NOISE_A    0.03f
+#define STEP_S     (1.0f / PUMP_PWM_HZ)
+#define RUN_MS     30000    // WATER_SECONDS
+#define NONE       UINT32_MAX
+
+enum { RUN_NORMAL, RUN_DRY, RUN_JAM, RUN_JAM_AT_START };
+
+typedef struct {
+    uint8_t state;
+    uint32_t trip_ms;
+    uint32_t onset_ms;      // when the fault began (NONE: normal run)
+    uint32_t signature_ms;  // first ms the current crossed the threshold
+    float supply_peak;      // highest 1 ms mean of duty * current
+    float on_peak;          // highest 1 ms mean of the sensed current
+} run_t;
+
+static uint64_t rng = 88172645463325252ull;
+
+static float uniform(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return (float)((rng >> 11) * (1.0 / 9007199254740992.0));
+}
+
+static float gauss(void) {
+    float u = uniform() + 1e-9f, v = uniform();
+    return sqrtf(-2 * logf(u)) * cosf(6.2831853f * v);
+}
+
+static uint16_t to_counts(float amps) {
+    float c = amps * 1000 / cfg.ma_per_count;
+    return (uint16_t)(c < 0 ? 0 : c > 4095 ? 4095 : c);
+}
+
+// One watering run. soft = false drives full duty from the start.
+// Bubbles are short load dips that must not trip anything.
+static run_t simulate(int kind, bool soft, uint32_t fault_ms, float bubbles_per_s, FILE *wave) {
+    pump_mon_t m;
+    pump_mon_start(&m, &cfg);
+    run_t r = {.onset_ms = NONE, .signature_ms = NONE};
+    float w = 0, duty = soft ? cfg.start_permille / 1000.0f : 1.0f;
+    uint32_t bubble_until = 0;
+    uint16_t block[PUMP_PWM_HZ / 2000];
+    int samples = 0;
+    float supply_sum = 0, on_sum = 0;
+    bool cut = false;
+
+    if (kind == RUN_JAM_AT_START) fault_ms = 0;
+    if (kind != RUN_NORMAL) r.onset_ms = fault_ms;
+
+    for (uint32_t ms = 0; ms < RUN_MS && !m.frozen; ms++) {
+        // Load for this millisecond
+        float load = LOAD_WET;
+        if (kind == RUN_DRY && ms >= fault_ms) {
+            float f = (ms - fault_ms) / 30.0f;          // air takes ~30 ms to fill the impeller
+            load = LOAD_WET + (LOAD_DRY - LOAD_WET) * (f > 1 ? 1 : f);
+        }
+        if ((kind == RUN_JAM || kind == RUN_JAM_AT_START) && ms >= fault_ms) load = LOAD_JAM;
+        if (kind == RUN_NORMAL && bubbles_per_s > 0 && uniform() < bubbles_per_s / 1000) {
+            bubble_until = ms + 2 + (uint32_t)(uniform() * 3);
+        }
+        if (ms < bubble_until) load = LOAD_DRY;
+
+        samples = 0;
+        supply_sum = on_sum = 0;
+        for (int step = 0; step < PUMP_PWM_HZ / 1000; step++) {
+            float i = (duty * SUPPLY_V - EMF_V * w) / R_OHM;
+            if (i < 0) i = 0;
+            float torque = i - (w > 0 ? FRICTION + load * w * w : 0);
+            w += torque / INERTIA * STEP_S;
+            if (w < 0 || load >= LOAD_JAM) w = load >= LOAD_JAM ? 0 : w < 0 ? 0 : w;
+            supply_sum += duty * i;
+            on_sum += i;
+            // Low-side shunt: current only flows through it while on
+            if (step % 2 == 0) block[samples++] = duty > 0 ? to_counts(i + NOISE_A * gauss()) : to_counts(0);
+        }
+        float supply = supply_sum / (PUMP_PWM_HZ / 1000), on = on_sum / (PUMP_PWM_HZ / 1000);
+        if (supply > r.supply_peak) r.supply_peak = supply;
+        if (on > r.on_peak && !cut) r.on_peak = on;
+        uint32_t stall_ma = (uint32_t)cfg.stall_ma * (uint32_t)(duty * 1000 + 0.5f) / 1000;
+        if (r.onset_ms != NONE && r.signature_ms == NONE && ms >= r.onset_ms &&
+            (kind == RUN_DRY ? on * 1000 < cfg.dry_ma : on * 1000 >= stall_ma)) {
+            r.signature_ms = ms;
+        }
+
+        uint8_t st = pump_mon_block(&m, block, samples, 1);
+        if (wave) fprintf(wave, "%lu,%u\n", (unsigned long)ms, m.trace[(m.trace_pos + PUMP_TRACE_LEN - 1) % PUMP_TRACE_LEN]);
+
+        // What the block IRQ does next
+        if (st == PUMP_RUNNING) {
+            if (soft) duty = pump_ramp_permille(&cfg, m.ms) / 1000.0f;
+        } else if (!cut) {
+            cut = true;
+            duty = 0;
+            r.state = st;
+            r.trip_ms = m.trip_ms - 1;      // monitor counts from 1
+        }
+    }
+    if (!cut) r.state = m.state;
+    return r;
+}
+
+static const char *kind_names[] = {"normal run", "reservoir empties", "impeller jams", "jammed at switch-on"};
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "usage: %s [-n runs] [-s seed]\n"
+        "       %s -w normal|dry|jam     waveform of one run as ms,mA\n"
+        "  -n runs   noisy normal runs with bubbles for the false-trip count (default 200)\n"
+        "  -s seed   random seed\n", prog, prog);
+}
+
+int main(int argc, char **argv) {
+    int runs = 200;
+    const char *wave = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:w:h")) != -1) {
+        switch (opt) {
+        case 'n': runs = atoi(optarg); break;
+        case 's': rng = strtoull(optarg, NULL, 0) | 1; break;
+        case 'w': wave = optarg; break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+
+    if (wave) {
+        int kind = !strcmp(wave, "dry") ? RUN_DRY : !strcmp(wave, "jam") ? RUN_JAM : RUN_NORMAL;
+        printf("ms,mA\n");
+        simulate(kind, true, 2000, 0.5f, stdout);
+        return 0;
+    }
+
+    printf("Pump: %.0f V, %.1f A locked rotor, %.0f mA wet, PWM %d kHz sampled mid-pulse\n",
+           SUPPLY_V, SUPPLY_V / R_OHM, 1000 * (FRICTION + LOAD_WET), PUMP_PWM_HZ / 1000);
+    printf("Cutoff: stall >= %u mA for %u ms (>= %u mA for %u ms in the first %u ms), "
+           "dry < %u mA for %u ms (after %u ms)\n\n", cfg.stall_ma, cfg.stall_ms, cfg.inrush_ma, cfg.inrush_stall_ms,
+           cfg.inrush_ms, cfg.dry_ma, cfg.dry_ms, cfg.ramp_ms + cfg.settle_ms);
+
+    run_t hard = simulate(RUN_NORMAL, false, 0, 0, NULL);
+    run_t soft = simulate(RUN_NORMAL, true, 0, 0, NULL);
+    printf("Start-up supply peak: %.2f A full-on, %.2f A with the %u ms soft start (-%.0f%%)\n\n",
+           hard.supply_peak, soft.supply_peak, cfg.ramp_ms, 100 * (1 - soft.supply_peak / hard.supply_peak));
+
+    printf("%-22s %-9s %12s %14s %12s\n", "scenario", "trip", "onset->trip", "signature->trip", "cut after");
+    static const uint32_t at[] = {0, 10000, 5000, 0};
+    for (int kind = RUN_DRY; kind <= RUN_JAM_AT_START; kind++) {
+        run_t r = simulate(kind, true, at[kind], 0, NULL);
+        printf("%-22s %-9s", kind_names[kind], pump_state_name(r.state));
+        if (r.state >= PUMP_FAULT_DRY) {
+            // The IRQ sets duty 0 after the block that tripped; it applies at the next wrap
+            printf(" %9lu ms %12lu ms %9lu ms\n", (unsigned long)(r.trip_ms - r.onset_ms),
+                   (unsigned long)(r.trip_ms - r.signature_ms), (unsigned long)(r.trip_ms + 1 - r.signature_ms));
+        } else {
+            printf("   (missed)\n");
+        }
+    }
+
+    int false_trips = 0;
+    for (int i = 0; i < runs; i++) {
+        run_t r = simulate(RUN_NORMAL, true, 0, 0.5f, NULL);
+        if (r.state >= PUMP_FAULT_DRY) false_trips++;
+    }
+    printf("\n%d noisy %d s runs with air bubbles (2-4 ms, ~1 per 2 s): %d false trips\n", runs, RUN_MS / 1000,
+           false_trips);
+    return 0;
+}
+
+// End of pump_sim.c
@@ -0,0 +1,185 @@
+// ---------------- sampling_sim.c ---------------- //
+/*
+ * Host tool: runs the firmware's irrigation loop against a simulated bed at
+ * 100 ms resolution, once with fixed sensor periods (soil 2000 ms, DHT
+ * 5000 ms, as before adaptive_rate) and once with the adaptive controllers,
+ * and compares
+ *   - sensor wakeups,
+ *   - time the firmware's dry mask disagrees with the true one,
+ *   - delay between a true mask change and the firmware seeing it,
+ *   - pump time and time below target moisture.
+ *
+ * Build:  cc -O2 -I.. sampling_sim.c ../adaptive_rate.c -o sampling_sim -lm
+ * Usage:  sampling_sim [-d days] [-f fixed_soil_ms]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <unistd.h>
+#include "irrigation_logic.h"
+#include "adaptive_rate.h"
+
+#define STEP_MS 100
+
+// Same presets as watering_system_main.c (virtual-zone site)
+static const irrigation_params_t params = {
+    .zone_count = 3,
+    .cutoff = {1000, 1500, 2000},
+    .humidity_skip = 80,
+    .water_seconds = 30,
+};
+static const rate_config_t soil_cfg = {1000, 30000, 5.0f, 150.0f, 100.0f, 2000};
+static const rate_config_t dht_cfg = {2000, 60000, 0.05f, 3.0f, 15.0f, 4000};
+
+// Bed model, same constants as irrigation_tuner's defaults
+#define GAIN    15.0f    // ADC counts per pump-second
+#define TAU_S   (12 * 3600.0f)
+#define TARGET  1500.0f
+
+typedef struct {
+    const char *name;
+    unsigned long soil_reads, dht_reads;
+    double mismatch_s;
+    double delay_sum_s, delay_max_s;
+    unsigned long changes;
+    double pump_s, below_s;
+} sim_result_t;
+
+// Reproducible per-timestamp noise so both runs see the same sensor
+static float noise(uint32_t t_ms, uint32_t salt, float amp) {
+    uint32_t x = t_ms * 2654435761u ^ salt;
+    x ^= x >> 15;
+    x *= 0x2c1b3c6du;
+    x ^= x >> 12;
+    return ((x & 0xffff) / 65535.0f * 2 - 1) * amp;
+}
+
+static void run(int days, uint32_t fixed_soil_ms, bool adaptive, sim_result_t *r) {
+    srand(1);
+    rate_ctl_t soil_rate, dht_rate;
+    rate_init(&soil_rate, &soil_cfg, 0);
+    rate_init(&dht_rate, &dht_cfg, 0);
+
+    float base = 2600, boost = 0;
+    const float decay = expf(-(STEP_MS / 1000.0f) / TAU_S);
+    uint32_t next_soil = 0, next_dht = 0;
+    float seen_soil = base, seen_hum = 50;
+    int zone = -1, prev_zone = -1;
+    uint32_t pump_until = 0;
+    uint8_t true_prev = 0;
+    int pending = 0;
+    uint32_t change_ms = 0;
+
+    const uint32_t end = (uint32_t)days * 86400000u;
+    for (uint32_t t = 0; t < end; t += STEP_MS) {
+        double day_frac = fmod(t / 86400000.0, 1.0);
+        float sun = (float)fmax(0.0, sin(2 * M_PI * (day_frac - 0.25)));
+        base -= (0.06f + 0.5f * sun) / 600.0f;        // per 100 ms
+        if (rand() % 12000000 == 0) base += 900;      // rain
+        if (base < 300) base = 300;
+        if (base > 3500) base = 3500;
+        boost *= decay;
+        if (zone >= 0 && t < pump_until) {
+            boost += GAIN * STEP_MS / 1000.0f;
+            r->pump_s += STEP_MS / 1000.0;
+        }
+        float soil = base + boost;
+        if (soil > 4095) soil = 4095;
+        // Humidity steps once a minute, half a fixed DHT period off that
+        // schedule; on it, fixed sampling would read every step the instant
+        // it happens, which no real sensor does
+        float hum = 85 - 40 * sun + noise((t + 2500) / 60000, 7, 3);
+
+        // Sensor tasks
+        if (t >= next_soil) {
+            seen_soil = soil + noise(t, 1, 8);
+            r->soil_reads++;
+            uint32_t period = fixed_soil_ms;
+            if (adaptive) {
+                uint16_t raw = (uint16_t)seen_soil;
+                period = rate_update(&soil_rate, t, seen_soil,
+                                     irrigation_threshold_distance(&params, &raw), zone >= 0);
+            }
+            next_soil = t + period;
+        }
+        if (t >= next_dht) {
+            seen_hum = hum;
+            r->dht_reads++;
+            uint32_t period = 5000;
+            if (adaptive) period = rate_update(&dht_rate, t, seen_hum, seen_hum - params.humidity_skip, zone >= 0);
+            next_dht = t + period;
+        }
+
+        // irrigation_task on what the sensors last reported
+        uint16_t seen_raw = (uint16_t)seen_soil, true_raw = (uint16_t)soil;
+        uint8_t seen = irrigation_dry_zones(&params, &seen_raw, seen_hum);
+        if (zone >= 0 && t >= pump_until) {
+            zone = irrigation_next_zone(&params, seen, zone + 1);
+            pump_until = t + params.water_seconds * 1000u;
+        } else if (zone < 0 && seen) {
+            zone = irrigation_next_zone(&params, seen, 0);
+            pump_until = t + params.water_seconds * 1000u;
+        }
+        // irrigation_task notifies soil_task when watering starts or stops
+        if ((zone >= 0) != (prev_zone >= 0)) next_soil = t + STEP_MS;
+        prev_zone = zone;
+
+        // Score against the noise-free truth
+        uint8_t truth = irrigation_dry_zones(&params, &true_raw, hum);
+        if (truth != true_prev) {
+            true_prev = truth;
+            change_ms = t;
+            pending = 1;
+        }
+        if (seen != truth) {
+            r->mismatch_s += STEP_MS / 1000.0;
+        } else if (pending) {
+            double d = (t - change_ms) / 1000.0;
+            r->delay_sum_s += d;
+            if (d > r->delay_max_s) r->delay_max_s = d;
+            r->changes++;
+            pending = 0;
+        }
+        if (soil < TARGET) r->below_s += STEP_MS / 1000.0;
+    }
+}
+
+static void print_row(const sim_result_t *r, int days) {
+    printf("%-9s %10.0f %9.0f %11.1f %9.2f %9.1f %8.2f %9.2f\n",
+           r->name, r->soil_reads / (days * 24.0), r->dht_reads / (days * 24.0),
+           r->mismatch_s / days, r->changes ? r->delay_sum_s / r->changes : 0.0, r->delay_max_s,
+           r->pump_s / 3600.0, r->below_s / 3600.0);
+}
+
+int main(int argc, char **argv) {
+    int days = 7;
+    uint32_t fixed_ms = 2000;
+    int opt;
+    while ((opt = getopt(argc, argv, "d:f:")) != -1) {
+        switch (opt) {
+        case 'd': days = atoi(optarg); break;
+        case 'f': fixed_ms = (uint32_t)atoi(optarg); break;
+        default:
+            fprintf(stderr, "usage: %s [-d days] [-f fixed_soil_ms]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (days <= 0 || fixed_ms == 0) {
+        fprintf(stderr, "days and period must be positive\n");
+        return 2;
+    }
+
+    sim_result_t fixed = {.name = "fixed"}, adaptive = {.name = "adaptive"};
+    run(days, fixed_ms, false, &fixed);
+    run(days, fixed_ms, true, &adaptive);
+
+    printf("%d days, %d ms steps\n\n", days, STEP_MS);
+    printf("mode      soil rd/h  dht rd/h  mismatch/d  delay avg  delay max  pump h  below h\n");
+    print_row(&fixed, days);
+    print_row(&adaptive, days);
+    printf("\nsoil wakeups saved: %.1f%%\n",
+           100.0 * (1.0 - (double)adaptive.soil_reads / fixed.soil_reads));
+    return 0;
+}
+
+// End of sampling_sim.c
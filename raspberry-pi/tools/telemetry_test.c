@@ -0,0 +1,290 @@
+// ---------------- telemetry_test.c ---------------- //
+/*
+ * Host test for the MQTT telemetry publisher (telemetry.c), run unchanged
+ * on tools/net_sim against a broker stand-in that decodes every frame.
+ *
+ *   throughput  broker acks at once, samples come as fast as the
+ *               publisher keeps its spool short; reports frames/s,
+ *               samples/s and the publisher's static RAM
+ *   faulty      simulated clock x1000; the broker nacks, drops, disconnects
+ *               and answers after the publisher's 35 s timeout. Every
+ *               sample must arrive, frames in sampling order (QoS 1
+ *               repeats allowed), and the spool never reprograms flash
+ *               without an erase.
+ *
+ * Both run the simulated clock x1000 (a minute of timeouts is 60 ms);
+ * rates are per wall-clock second. Each scenario runs in its own process,
+ * since telemetry.c keeps its state in statics.
+ *
+ * Build:  cc -O2 -pthread -I.. -Inet_sim -Ihal_sim telemetry_test.c ../telemetry.c net_sim/net_sim.c \
+ *             -o telemetry_test
+ * Usage:  telemetry_test [-b batches] [-s seed]      exit 1 on a failure
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "net_sim.h"
+#include "telemetry.h"
+
+static uint32_t n_samples;
+static uint8_t *seen;               // per sample time: times the broker stored it
+static uint32_t seen_count, frames, repeats, order_errors, decode_errors;
+static int64_t last_t0 = -1;
+static uint32_t seed = 1;
+static int failures;
+
+static void check(bool ok, const char *what) {
+    if (ok) return;
+    printf("FAIL: %s\n", what);
+    failures++;
+}
+
+static double wall_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint32_t rnd(uint32_t n) {
+    seed = seed * 1664525u + 1013904223u;
+    return (seed >> 8) % n;
+}
+
+// ---------------- Broker stand-in ---------------- //
+typedef struct {
+    const uint8_t *p, *end;
+    bool ok;
+} cbor_rd_t;
+
+static uint32_t rd_head(cbor_rd_t *r, uint8_t *major) {
+    if (r->p >= r->end) { r->ok = false; return 0; }
+    uint8_t b = *r->p++;
+    *major = b >> 5;
+    uint8_t info = b & 31;
+    if (info < 24) return info;
+    int n = info == 24 ? 1 : info == 25 ? 2 : info == 26 ? 4 : 0;
+    if (n == 0 || r->end - r->p < n) { r->ok = false; return 0; }
+    uint32_t v = 0;
+    while (n--) v = v << 8 | *r->p++;
+    return v;
+}
+
+static int64_t rd_int(cbor_rd_t *r) {
+    uint8_t major;
+    uint32_t v = rd_head(r, &major);
+    if (major == 0) return v;
+    if (major == 1) return -1 - (int64_t)v;
+    r->ok = false;
+    return 0;
+}
+
+static bool rd_key(cbor_rd_t *r, const char *key) {
+    uint8_t major;
+    uint32_t n = rd_head(r, &major);
+    if (!r->ok || major != 3 || (uint32_t)(r->end - r->p) < n) return r->ok = false;
+    bool match = n == strlen(key) && memcmp(r->p, key, n) == 0;
+    r->p += n;
+    return match;
+}
+
+// Store one frame: { "n": id, "t0": t, "s": [[dt, soil, temp, hum, zones], ...] }
+static void store_frame(const uint8_t *payload, uint16_t len) {
+    cbor_rd_t r = { payload, payload + len, true };
+    uint8_t major;
+    bool ok = rd_head(&r, &major) == 3 && major == 5;
+    ok = ok && rd_key(&r, "n");
+    rd_key(&r, "");                 // node id, any value
+    ok = ok && rd_key(&r, "t0");
+    int64_t t0 = rd_int(&r);
+    ok = ok && rd_key(&r, "s");
+    uint32_t n = rd_head(&r, &major);
+    ok = ok && r.ok && major == 4 && n > 0;
+    for (uint32_t i = 0; ok && i < n; i++) {
+        ok = rd_head(&r, &major) == 5 && major == 4;
+        int64_t t = t0 + rd_int(&r);
+        int64_t soil = rd_int(&r);
+        rd_int(&r); rd_int(&r); rd_int(&r);
+        ok = ok && r.ok && t >= 0 && t < n_samples && soil == (t & 0xFFF);
+        if (!ok) break;
+        if (seen[t]++ == 0) seen_count++;
+    }
+    if (!ok || r.p != r.end) {
+        decode_errors++;
+        return;
+    }
+    frames++;
+    if (t0 == last_t0) repeats++;           // QoS 1 redelivery of the last frame
+    else if (t0 < last_t0) order_errors++;
+    last_t0 = t0 > last_t0 ? t0 : last_t0;
+}
+
+static int broker_ack(const uint8_t *payload, uint16_t len, uint32_t *reply_ms) {
+    store_frame(payload, len);
+    *reply_ms = 0;
+    return ERR_OK;
+}
+
+static int broker_faulty(const uint8_t *payload, uint16_t len, uint32_t *reply_ms) {
+    uint32_t roll = rnd(100);
+    // About 5 s of timeouts per publish on average against a frame every
+    // 12 s, so the spool drains and never has to wrap
+    if (roll < 70) {                        // normal PUBACK
+        store_frame(payload, len);
+        *reply_ms = 5 + rnd(200);
+        return ERR_OK;
+    } else if (roll < 80) {                 // refused
+        *reply_ms = 5;
+        return ERR_TIMEOUT;
+    } else if (roll < 87) {                 // lost on the way, never answered
+        return NET_SIM_NO_REPLY;
+    } else if (roll < 95) {                 // stored, but the ack comes after the publisher gave up
+        store_frame(payload, len);
+        *reply_ms = 40000;
+        return ERR_OK;
+    }
+    net_sim_mqtt_disconnect();              // session dropped mid-publish
+    return NET_SIM_NO_REPLY;
+}
+
+// ---------------- Scenarios ---------------- //
+static uint32_t broker_seen(void) {
+    cyw43_arch_lwip_begin();
+    uint32_t n = seen_count;
+    cyw43_arch_lwip_end();
+    return n;
+}
+
+static void start(double speed, net_sim_broker_fn broker, uint32_t samples) {
+    n_samples = samples;
+    seen = calloc(samples, 1);
+    net_sim.speed = speed;
+    net_sim.broker = broker;
+    net_sim_start();
+    telemetry_init();
+    net_sim_task_start(telemetry_task, NULL);
+
+    // Samples before the first connect would all go through the spool
+    telemetry_stats_t st;
+    do {
+        net_sim_sleep(10);
+        telemetry_get_stats(&st);
+    } while (!st.connected);
+}
+
+// Queue sample t, waiting for room like a sampler that never drops
+static uint32_t submit(uint32_t t) {
+    telemetry_sample_t s = {
+        .t_s = t, .soil = (uint16_t)(t & 0xFFF), .temp_x10 = 215, .hum_x10 = 480, .dry_zones = (uint8_t)(t & 7),
+    };
+    uint32_t full = 0;
+    while (!telemetry_submit(&s)) {
+        full++;
+        usleep(20);
+    }
+    return full;
+}
+
+// Wait (wall-clock) until the broker holds every sample
+static bool drain(double timeout_s) {
+    double until = wall_s() + timeout_s;
+    while (broker_seen() < n_samples && wall_s() < until) usleep(500);
+    return broker_seen() == n_samples;
+}
+
+static void check_delivery(void) {
+    telemetry_stats_t st;
+    telemetry_get_stats(&st);
+    check(decode_errors == 0, "broker got a frame it could not decode");
+    check(order_errors == 0, "frames reached the broker out of sampling order");
+    check(st.batches_lost == 0, "spool dropped frames");
+    check(net_sim.flash_bad_programs == 0, "spool programmed flash without erasing it");
+    printf("  frames stored %u (%u repeats), published %lu, spooled %lu, replayed %lu, lost %lu\n",
+           frames, repeats, (unsigned long)st.batches_published, (unsigned long)st.batches_spooled,
+           (unsigned long)st.batches_replayed, (unsigned long)st.batches_lost);
+    printf("  flash: %u erases, %u programs; out of order %u\n", net_sim.flash_erases, net_sim.flash_programs,
+           order_errors);
+}
+
+static void scenario_throughput(uint32_t batches) {
+    uint32_t n = batches * TELEMETRY_BATCH, full = 0;
+    start(1000, broker_ack, n);
+    double t0 = wall_s();
+    for (uint32_t t = 0; t < n; t++) {
+        // One frame is in flight at a time; past that, frames queue in the
+        // spool, which must not wrap
+        telemetry_stats_t st;
+        for (telemetry_get_stats(&st); st.spool_pending > 8; telemetry_get_stats(&st)) usleep(20);
+        full += submit(t);
+    }
+    bool all = drain(30);
+    double dt = wall_s() - t0;
+    check(all, "broker is missing samples");
+
+    printf("throughput: %u samples in %u frames, %.3f s\n", n, frames, dt);
+    printf("  %.0f frames/s, %.0f samples/s, %u waits on a full queue\n", frames / dt, n / dt, full);
+    printf("  RAM: %lu bytes static (queue %lu, batch + frame buffers, spool page)\n",
+           (unsigned long)telemetry_ram_bytes(), (unsigned long)(TELEMETRY_QUEUE_LEN * sizeof(telemetry_sample_t)));
+    check_delivery();
+}
+
+static void scenario_faulty(uint32_t batches) {
+    uint32_t n = batches * TELEMETRY_BATCH;
+    start(1000, broker_faulty, n);
+    double t0 = wall_s();
+    for (uint32_t t = 0; t < n; t++) {
+        submit(t);
+        net_sim_sleep(500);                 // one sample per 500 ms of simulated time
+    }
+    bool all = drain(60);
+    double dt = wall_s() - t0;
+    check(all, "broker is missing samples");
+
+    printf("faulty: %u of %u samples in %u frames, %.0f s simulated, %u publishes\n", broker_seen(), n, frames,
+           dt * net_sim.speed, net_sim.publishes);
+    check_delivery();
+}
+
+static int run(void (*scenario)(uint32_t), uint32_t batches) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        scenario(batches);
+        fflush(stdout);
+        _exit(failures ? 1 : 0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "usage: %s [-b batches] [-s seed]\n"
+        "  -b batches  frames' worth of samples per scenario (default 400)\n"
+        "  -s seed     broker fault seed\n", prog);
+}
+
+int main(int argc, char **argv) {
+    uint32_t batches = 400;
+    int opt;
+    while ((opt = getopt(argc, argv, "b:s:h")) != -1) {
+        switch (opt) {
+        case 'b': batches = (uint32_t)atol(optarg); break;
+        case 's': seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (batches == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    int rc = run(scenario_throughput, batches);
+    rc |= run(scenario_faulty, batches);
+    printf("%s\n", rc ? "FAILED" : "ok");
+    return rc ? 1 : 0;
+}
+
+// End of telemetry_test.c
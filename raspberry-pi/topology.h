@@ -0,0 +1,186 @@
+// ---------------- topology.h ---------------- //
+/*
+ * Site topology for the irrigation firmware.
+ * Every build describes its probes, relays and zones once, as X-macro lists,
+ * and this header turns them into fixed-size const tables, unrolled scan
+ * helpers and compile-time pin checks. Pick the site with
+ * -DIRRIGATION_SITE=SITE_xxx (each program has its own default).
+ *
+ *   SITE_PROBES(X)    X(probe_id, gpio)               soil probes, ADC pins only
+ *   SITE_RELAYS(X)    X(relay_id, gpio)               relay / pump outputs
+ *   SITE_ZONES(X)     X(zone_id, probe_id, relay_id, dry_threshold)
+ *   SITE_AUX_PINS(X)  X(name, gpio)                   everything else on the board
+ *   SITE_PWM_PINS(X)  X(name, gpio)                   outputs driven by a PWM slice, one slice each
+ */
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+
+// ---------------- Site list ---------------- //
+#define SITE_DUAL_ZONE    1  // main.c: two probes, one relay each
+#define SITE_VIRTUAL_ZONE 2  // watering_system_main.c: one probe split into three dryness bands, one pump
+#define SITE_SINGLE_PUMP  3  // water_pump.c: one probe, pump on GP14
+
+#ifndef IRRIGATION_SITE
+#define IRRIGATION_SITE SITE_VIRTUAL_ZONE
+#endif
+
+#if IRRIGATION_SITE == SITE_DUAL_ZONE
+#define SITE_NAME "dual-zone"
+#define SITE_PROBES(X) \
+    X(0, 26)   /* ADC0 */ \
+    X(1, 27)   /* ADC1 */
+#define SITE_RELAYS(X) \
+    X(0, 2) \
+    X(1, 3)
+#define SITE_ZONES(X) \
+    X(0, 0, 0, 2000) \
+    X(1, 1, 1, 2000)
+#define SITE_AUX_PINS(X)
+
+#elif IRRIGATION_SITE == SITE_VIRTUAL_ZONE
+#define SITE_NAME "virtual-zone"
+#define SITE_PROBES(X) \
+    X(0, 26)   /* ADC0 */
+#define SITE_RELAYS(X) \
+    X(0, 2)
+#define SITE_ZONES(X) \
+    X(0, 0, 0, 1000) \
+    X(1, 0, 0, 1500) \
+    X(2, 0, 0, 2000)
+#define SITE_AUX_PINS(X) \
+    X(SERVO_PIN, 10) \
+    X(PROX_PIN, 4) \
+    X(LED_ALERT, 6) \
+    X(DHT_PIN, 7) \
+    X(I2C_SDA, 8) \
+    X(I2C_SCL, 9) \
+    X(PUMP_SENSE_PIN, 27)   /* ADC1: pump shunt amplifier (PUMP_MOTOR_DRIVE) */
+#define SITE_PWM_PINS(X) \
+    X(RELAY0, 2)     /* slice 1: 32 kHz motor drive (PUMP_MOTOR_DRIVE) */ \
+    X(SERVO, 10)     /* slice 5: 50 Hz servo */
+
+#elif IRRIGATION_SITE == SITE_SINGLE_PUMP
+#define SITE_NAME "single-pump"
+#define SITE_DRY_ABOVE 1   // this probe reads high when dry
+#define SITE_CAL_DRY   3000 // soil_sensor.h CALIBRATION_DRY / _WET
+#define SITE_CAL_WET   1000
+#define SITE_PROBES(X) \
+    X(0, 26)   /* ADC0 */
+#define SITE_RELAYS(X) \
+    X(0, 14)
+#define SITE_ZONES(X) \
+    X(0, 0, 0, 2400)   /* 30% moisture on the 3000/1000 calibration */
+#define SITE_AUX_PINS(X)
+
+#else
+#error "Unknown IRRIGATION_SITE"
+#endif
+
+#ifndef SITE_DRY_ABOVE
+#define SITE_DRY_ABOVE 0   // default probes read low when dry
+#define SITE_CAL_DRY   1000 // same 2000-count span as the single-pump probe, reversed
+#define SITE_CAL_WET   3000
+#endif
+#ifndef SITE_PWM_PINS
+#define SITE_PWM_PINS(X)
+#endif
+
+// ---------------- Generated sizes and tables ---------------- //
+#define TOPO_COUNT2(a, b)       + 1
+#define TOPO_COUNT4(a, b, c, d) + 1
+#define PROBE_COUNT (0 SITE_PROBES(TOPO_COUNT2))
+#define RELAY_COUNT (0 SITE_RELAYS(TOPO_COUNT2))
+#define ZONE_COUNT  (0 SITE_ZONES(TOPO_COUNT4))
+
+#define TOPO_AUX_ENUM(name, gpio) name = (gpio),
+enum site_aux_pin { SITE_AUX_PINS(TOPO_AUX_ENUM) SITE_AUX_PIN_END };
+
+#define TOPO_SECOND(a, b)          (b),
+#define TOPO_ZONE_PROBE(z, p, r, t) (p),
+#define TOPO_ZONE_RELAY(z, p, r, t) (r),
+#define TOPO_ZONE_THR(z, p, r, t)   (t),
+
+static const uint8_t PROBE_GPIO[PROBE_COUNT] = { SITE_PROBES(TOPO_SECOND) };
+static const uint8_t RELAY_GPIO[RELAY_COUNT] = { SITE_RELAYS(TOPO_SECOND) };
+static const uint8_t ZONE_PROBE[ZONE_COUNT] = { SITE_ZONES(TOPO_ZONE_PROBE) };
+static const uint8_t ZONE_RELAY[ZONE_COUNT] = { SITE_ZONES(TOPO_ZONE_RELAY) };
+static const uint16_t ZONE_DRY_THRESHOLD[ZONE_COUNT] = { SITE_ZONES(TOPO_ZONE_THR) };
+
+#define ADC_BASE_PIN 26
+#define PROBE_ADC_CHANNEL(gpio) ((gpio) - ADC_BASE_PIN)
+
+// ---------------- Compile-time checks ---------------- //
+// Sum of the pin bits equals their OR only when no pin is listed twice.
+#define TOPO_BIT2(a, gpio) + (1ULL << (gpio))
+#define TOPO_OR2(a, gpio)  | (1ULL << (gpio))
+#define SITE_PIN_SUM (0ULL SITE_PROBES(TOPO_BIT2) SITE_RELAYS(TOPO_BIT2) SITE_AUX_PINS(TOPO_BIT2))
+#define SITE_PIN_OR  (0ULL SITE_PROBES(TOPO_OR2) SITE_RELAYS(TOPO_OR2) SITE_AUX_PINS(TOPO_OR2))
+#define SITE_PROBE_MASK (0ULL SITE_PROBES(TOPO_OR2))
+
+// Each PWM slice has one clock divider, wrap and enable for its A/B pair,
+// so two PWM outputs on one slice would reprogram each other.
+#define TOPO_SLICE_BIT(a, gpio) + (1u << (((gpio) >> 1) & 7))
+#define TOPO_SLICE_OR(a, gpio)  | (1u << (((gpio) >> 1) & 7))
+
+_Static_assert(SITE_PIN_SUM == SITE_PIN_OR, "topology: a GPIO is assigned twice");
+_Static_assert((SITE_PROBE_MASK & ~(0xFULL << ADC_BASE_PIN)) == 0, "topology: probes must sit on ADC pins GP26-GP29");
+_Static_assert(ZONE_COUNT >= 1 && ZONE_COUNT <= 8, "topology: zones are tracked in a uint8_t bitmask");
+_Static_assert((0u SITE_PWM_PINS(TOPO_SLICE_BIT)) == (0u SITE_PWM_PINS(TOPO_SLICE_OR)),
+               "topology: two PWM outputs share a PWM slice");
+_Static_assert(((0ULL SITE_PWM_PINS(TOPO_OR2)) & ~SITE_PIN_OR) == 0,
+               "topology: a PWM output is not in the relay or aux pin list");
+
+#define TOPO_CHECK_ZONE(z, p, r, t) \
+    _Static_assert((p) < PROBE_COUNT && (r) < RELAY_COUNT, "topology: zone " #z " names a missing probe or relay"); \
+    _Static_assert((t) < 4096, "topology: zone " #z " threshold exceeds the 12-bit ADC range");
+SITE_ZONES(TOPO_CHECK_ZONE)
+_Static_assert((SITE_CAL_DRY > SITE_CAL_WET) == SITE_DRY_ABOVE, "topology: calibration contradicts SITE_DRY_ABOVE");
+
+// ---------------- Helpers ---------------- //
+static inline bool zone_is_dry(uint16_t raw, uint16_t threshold) {
+#if SITE_DRY_ABOVE
+    return raw > threshold;
+#else
+    return raw < threshold;
+#endif
+}
+
+// Moisture 0-100% on this site's calibration, whichever way the probe reads
+static inline uint8_t site_moisture_pct(uint16_t raw) {
+    float pct = ((int)raw - SITE_CAL_DRY) * (100.0f / (SITE_CAL_WET - SITE_CAL_DRY));
+    return pct <= 0 ? 0 : pct >= 100 ? 100 : (uint8_t)(pct + 0.5f);
+}
+
+static inline uint zone_relay_gpio(uint zone) {
+    return RELAY_GPIO[ZONE_RELAY[zone]];
+}
+
+// Set up every probe as an ADC input and every relay as an output (OFF).
+#define TOPO_INIT_PROBE(id, gpio) adc_gpio_init(gpio);
+#define TOPO_INIT_RELAY(id, gpio) gpio_init(gpio); gpio_set_dir(gpio, GPIO_OUT); gpio_put(gpio, 0);
+static inline void topology_init_io(void) {
+    adc_init();
+    SITE_PROBES(TOPO_INIT_PROBE)
+    SITE_RELAYS(TOPO_INIT_RELAY)
+}
+
+// Read each probe once; expands to straight-line code, one block per probe.
+#define TOPO_READ_PROBE(id, gpio) adc_select_input(PROBE_ADC_CHANNEL(gpio)); raw[id] = adc_read();
+static inline void topology_read_probes(uint16_t raw[PROBE_COUNT]) {
+    SITE_PROBES(TOPO_READ_PROBE)
+}
+
+// Bitmask of dry zones (bit n = zone n) from one set of probe readings.
+#define TOPO_DRY_BIT(z, p, r, t) if (zone_is_dry(raw[p], t)) mask |= (uint8_t)(1u << (z));
+static inline uint8_t topology_dry_mask(const uint16_t raw[PROBE_COUNT]) {
+    uint8_t mask = 0;
+    SITE_ZONES(TOPO_DRY_BIT)
+    return mask;
+}
+
+#endif // TOPOLOGY_H
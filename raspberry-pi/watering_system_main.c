@@ -17,156 +17,377 @@
 #include "hardware/adc.h"
 #include "hardware/pwm.h"
 #include "hardware/i2c.h"
+#include "hardware/flash.h"
 #include "FreeRTOS.h"
 #include "task.h"
+#include "semphr.h"
+#include "history.h"
+#include "telemetry.h"
+#include "http_dashboard.h"
 
 // --- Pin definitions ---
-#define SOIL_PIN       26  // ADC0
-#define RELAY_PIN       2
-#define SERVO_PIN       3
-#define PROX_PIN        4
-#define LED_ALERT       6
-#define DHT_PIN         7  // temperature & humidity sensor
-
-// --- I2C pins for LCD ---
-#define I2C_PORT i2c0
-#define I2C_SDA  8
-#define I2C_SCL  9
-#define LCD_ADDR 0x27   // common I2C address
+// Soil probe (GP26), pump relay (GP2), servo, proximity, LED, DHT and the
+// display's I2C pins come from the site topology.
+#include "topology.h"
+#include "irrigation_logic.h"
+#include "irrigation_cycle.h"
+#include "adaptive_rate.h"
+#include "alert_rules.h"
+#include "alert_rules_default.h"
+#include "fw_update.h"
+#include "boot_state.h"
+#include "lcd.h"
+#include "oled.h"
+#include "status_screen.h"
+#include "cli_commands.h"
+#include "pump_drive.h"
 
 // --- Globals ---
 volatile uint8_t dry_zones = 0;
 volatile uint32_t irrigation_count = 0;
 volatile bool manual_abort_flag = false;
 volatile bool manual_start_flag = false;
-#define MAX_CYCLES 30
 #define WATER_SECONDS 30
 
+// Decision parameters (zone cutoffs from the topology, humidity skip, pump time)
+static const irrigation_params_t irrigation_params = {
+    .zone_count = ZONE_COUNT,
+    .cutoff = { SITE_ZONES(TOPO_ZONE_THR) },
+    .probe = { SITE_ZONES(TOPO_ZONE_PROBE) },
+    .dry_above = SITE_DRY_ABOVE,
+    .humidity_skip = 80,
+    .water_seconds = WATER_SECONDS,
+};
+
 volatile float temperature = 0;
 volatile float humidity = 0;
 
+// --- Adaptive sampling (replaces the fixed 2000 ms soil / 5000 ms DHT periods) ---
+static const rate_config_t soil_rate_cfg = {
+    .min_ms = 1000, .max_ms = 30000,
+    .slope_ref = 5.0f,      // ADC counts/s
+    .noise_ref = 150.0f,    // ADC counts
+    .margin_ref = 100.0f,   // ADC counts from a zone cutoff
+    .near_ms = 2000,        // no slower than the old fixed period there
+};
+static const rate_config_t dht_rate_cfg = {
+    .min_ms = 2000, .max_ms = 60000,
+    .slope_ref = 0.05f,     // %/s
+    .noise_ref = 3.0f,      // %
+    .margin_ref = 15.0f,    // % from the humidity skip: a few noise steps
+    .near_ms = 4000,
+};
+rate_ctl_t soil_rate, dht_rate;
+
+// --- Pump motor drive (-DPUMP_MOTOR_DRIVE=1: MOSFET + shunt instead of the relay) ---
+// Checked against a simulated 12 V pump with tools/pump_sim.
+#if PUMP_MOTOR_DRIVE
+static const pump_cfg_t pump_cfg = {
+    .start_permille = 300, .ramp_ms = 250,  // soft start: 30% -> 100%
+    .inrush_ms = 60, .settle_ms = 200,
+    .ma_per_count = 0.806f,                 // 0.1 ohm shunt, x10 amplifier
+    .stall_ma = 1200, .stall_ms = 3,        // locked rotor ~1.5 A
+    .inrush_ma = 1350, .inrush_stall_ms = 10, // 90% of locked rotor while spinning up
+    .dry_ma = 180, .dry_ms = 8,             // ~350 mA wet, ~90 mA dry
+};
+_Static_assert(PROBE_COUNT == 1, "the motor drive co-samples one soil probe");
+_Static_assert(PUMP_SENSE_PIN >= ADC_BASE_PIN && PUMP_SENSE_PIN <= ADC_BASE_PIN + 3, "pump sense must be an ADC pin");
+#endif
+SemaphoreHandle_t adc_lock;     // soil reads vs the pump drive taking the ADC
+
+// --- Live state for the web dashboard ---
+volatile uint16_t soil_level = 0;
+volatile int8_t watering_zone = -1;   // zone being watered, -1 when idle
+volatile int watering_seconds = 0;
+
+// --- Tasks: id, entry, name, stack (words), priority ---
+// With configSUPPORT_STATIC_ALLOCATION every stack, TCB, queue and mutex
+// below is a static object, so nothing comes from the FreeRTOS heap.
+#define APP_TASKS(X) \
+    X(soil,       soil_task,           "SoilTask",        448, 2) \
+    X(irrigation, irrigation_task,     "IrrigationTask",  512, 2) \
+    X(dht,        dht_task,            "DHTTask",         384, 1) \
+    X(cli,        cli_task,            "CLITask",         512, 3) \
+    X(telemetry,  telemetry_task,      "MQTTTask",       1024, 1) \
+    X(http,       http_dashboard_task, "HTTPTask",        512, 1)
+
+#define TASK_ID(id, fn, name, words, prio) TASK_##id,
+enum { APP_TASKS(TASK_ID) TASK_COUNT };
+
+#define TASK_STACK_SUM(id, fn, name, words, prio) + (words)
+#define APP_STACK_BYTES ((0 APP_TASKS(TASK_STACK_SUM)) * sizeof(StackType_t))
+_Static_assert(APP_STACK_BYTES <= 16 * 1024, "task stacks exceed their 16 KB budget");
+
+// Each task gets &task_handles[its id] as params; a task that deletes
+// itself clears its entry first, and print_memmap shows it as exited.
+TaskHandle_t task_handles[TASK_COUNT];
+
+// --- Sensor history (compressed, ~5 KB) ---
+history_t history;
+SemaphoreHandle_t history_lock;
+
+// --- Alert rules (bytecode compiled from config/irrigation-settings.json) ---
+// Replaces the hard-coded intrusion stop and maintenance counter; rules in
+// flash (CLI "alerts load") take precedence over the built-in set.
+alert_engine_t alerts;
+SemaphoreHandle_t alert_lock;
+static char alert_stop_name[16];    // the raised stop rule, copied out under alert_lock
+static const char *alert_source = "none";
+static uint8_t alert_led_holders;   // raised rules that want LED_ALERT on
+static uint32_t alert_samples, alert_evaluated, alert_us_total, alert_us_max;
+
+// --- Display: SSD1306 status screen, or the 16x2 LCD with -DDISPLAY_OLED=0 ---
+// Drawn from the soil and irrigation tasks and from alert actions.
+SemaphoreHandle_t display_lock;
+#if DISPLAY_OLED
+_Static_assert(ZONE_COUNT <= SCREEN_MAX_ZONES, "status screen: too many zones for one row each");
+status_screen_t screen;
+#endif
+
 // --- Function prototypes ---
-uint16_t read_soil(void);
 bool intrusion_detected(void);
 void servo_set_angle(float angle);
 bool read_dht(float *temperature, float *humidity);
+void print_history(void);
+void print_telemetry(void);
+void print_memmap(void);
+void print_alerts(void);
+void upload_alerts(void);
+void load_alert_rules(void);
+void alert_signal(uint8_t sig, float value);
+void alert_action(const char *name, uint8_t actions, bool raised);
+void soil_task(void *params);
+void irrigation_task(void *params);
+void dht_task(void *params);
+void cli_task(void *params);
+void print_pump(void);
+
+// --- Pump output: relay, or the PWM motor drive with current cutoff ---
+static void pump_on(int zone) {
+#if PUMP_MOTOR_DRIVE
+    xSemaphoreTake(adc_lock, portMAX_DELAY);
+    pump_drive_start(zone_relay_gpio(zone));
+    xSemaphoreGive(adc_lock);
+#else
+    gpio_put(zone_relay_gpio(zone), 1);
+#endif
+}
 
-// --- LCD function prototypes ---
-void lcd_send_cmd(uint8_t cmd);
-void lcd_send_data(uint8_t data);
-void lcd_clear();
-void lcd_init();
-void lcd_set_cursor(int col, int row);
-void lcd_print(const char *str);
+static void pump_off(int zone) {
+#if PUMP_MOTOR_DRIVE
+    xSemaphoreTake(adc_lock, portMAX_DELAY);
+    pump_drive_stop();
+    xSemaphoreGive(adc_lock);
+#else
+    gpio_put(zone_relay_gpio(zone), 0);
+#endif
+}
 
-// --- Soil sensor task ---
-void soil_task(void *params) {
-    while(1) {
-        uint16_t soil = read_soil();
-        uint8_t zones = 0;
+// Dry-run / stall fault latched by the drive (until CLI "pump reset")
+static bool pump_fault(void) {
+#if PUMP_MOTOR_DRIVE
+    return pump_drive_state() >= PUMP_FAULT_DRY;
+#else
+    return false;
+#endif
+}
+
+// While the pump runs the drive owns the ADC and hands out the probe reading
+static void read_probes(uint16_t probes[PROBE_COUNT]) {
+#if PUMP_MOTOR_DRIVE
+    xSemaphoreTake(adc_lock, portMAX_DELAY);
+    if(!pump_drive_probe(&probes[0])) topology_read_probes(probes);
+    xSemaphoreGive(adc_lock);
+#else
+    topology_read_probes(probes);
+#endif
+}
+
+// --- Display helpers ---
+#if DISPLAY_OLED
+// Whole status screen from the live state (display_lock held)
+static void draw_screen(void) {
+    screen_live_t live = {
+        .soil_pct = site_moisture_pct(soil_level),
+        .temperature = temperature,
+        .humidity = humidity,
+        .watering_zone = watering_zone,
+        .watering_seconds = watering_seconds,
+        .dry_zones = dry_zones,
+    };
+    screen_draw(&screen, &live);
+    oled_flush();
+}
+#endif
+
+// New probe readings: zone trends and the status screen (OLED), or the
+// soil value and humidity (LCD)
+static void display_status(const uint16_t probes[PROBE_COUNT], uint32_t now_s) {
+    xSemaphoreTake(display_lock, portMAX_DELAY);
+#if DISPLAY_OLED
+    uint8_t pct[ZONE_COUNT];
+    for(int z=0; z<ZONE_COUNT; z++) pct[z] = site_moisture_pct(probes[ZONE_PROBE[z]]);
+    screen_moisture(&screen, pct, now_s);
+    draw_screen();
+#else
+    lcd_clear();
+    lcd_set_cursor(0,0);
+    lcd_print("Soil Dryness:");
+
+    lcd_set_cursor(0,1);
+    char buf[64];   // worst case: "Val:65535 Hum:" and a 40-digit %.0f
+    snprintf(buf, sizeof(buf), "Val:%d Hum:%.0f%%", probes[0], humidity);
+    buf[LCD_COLS] = '\0';  // what fits on the row
+    lcd_print(buf);
+#endif
+    xSemaphoreGive(display_lock);
+}
 
-        if(soil < 1000) zones |= 0x01;
-        if(soil < 1500) zones |= 0x02;
-        if(soil < 2000) zones |= 0x04;
+// Event text: the status line until the next message (OLED), or the top row (LCD)
+static void display_message(const char *msg) {
+    xSemaphoreTake(display_lock, portMAX_DELAY);
+#if DISPLAY_OLED
+    screen_message(&screen, msg);
+    draw_screen();
+#else
+    lcd_clear();
+    lcd_set_cursor(0,0);
+    lcd_print(msg);
+#endif
+    xSemaphoreGive(display_lock);
+}
 
-        // Skip watering if humidity > 80%
-        if(humidity > 80) zones = 0;
+// Watering countdown, once a second
+static void display_countdown(int seconds) {
+    xSemaphoreTake(display_lock, portMAX_DELAY);
+#if DISPLAY_OLED
+    (void)seconds;      // watering_seconds is already set
+    draw_screen();
+#else
+    lcd_set_cursor(0,1);
+    char timer[16];
+    snprintf(timer, sizeof(timer), "Time:%02ds", seconds);
+    lcd_print(timer);
+#endif
+    xSemaphoreGive(display_lock);
+}
 
-        dry_zones = zones;
+// --- Hardware side of irrigation_cycle.c ---
+// Watering started (zone) or stopped (-1); soil_task reads again at once
+// and picks its new period instead of sleeping out the old one (up to 30 s)
+static void io_watering(int zone) {
+    watering_zone = zone;
+    if(zone < 0) watering_seconds = 0;
+    TaskHandle_t soil = task_handles[TASK_soil];
+    if(soil) xTaskNotifyGive(soil);
+}
 
-        // Update LCD with soil + humidity
-        lcd_clear();
-        lcd_set_cursor(0,0);
-        lcd_print("Soil Dryness:");
+static void io_countdown(int seconds) {
+    watering_seconds = seconds;
+    display_countdown(seconds);
+}
 
-        lcd_set_cursor(0,1);
-        char buf[16];
-        snprintf(buf, sizeof(buf), "Val:%d Hum:%.0f%%", soil, humidity);
-        lcd_print(buf);
+static void io_log(const char *line) {
+    fputs(line, stdout);
+}
 
-        vTaskDelay(pdMS_TO_TICKS(2000));
+static void io_delay(uint32_t ms) {
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+static bool io_abort(void) {
+    return manual_abort_flag;
+}
+
+// Asked every watering second: any rule with the stop action raised right
+// now, so one that stays raised into the next zone stops that one too
+static const char *io_stop_rule(void) {
+    xSemaphoreTake(alert_lock, portMAX_DELAY);
+    const char *name = alert_raised_action(&alerts, ALERT_STOP);
+    if(name) snprintf(alert_stop_name, sizeof(alert_stop_name), "%s", name);
+    xSemaphoreGive(alert_lock);
+    return name ? alert_stop_name : NULL;
+}
+
+static const irrigation_io_t irrigation_io = {
+    .read_probes = read_probes,
+    .signal = alert_signal,
+    .pump_on = pump_on,
+    .pump_off = pump_off,
+    .pump_fault = pump_fault,
+    .pump_report = print_pump,
+    .intrusion = intrusion_detected,
+    .servo = servo_set_angle,
+    .message = display_message,
+    .countdown = io_countdown,
+    .watering = io_watering,
+    .log = io_log,
+    .delay_ms = io_delay,
+    .abort_requested = io_abort,
+    .stop_rule = io_stop_rule,
+    .temperature = &temperature,
+    .humidity = &humidity,
+    .cycles = &irrigation_count,
+};
+
+// --- Soil sensor task ---
+void soil_task(void *params) {
+    uint16_t probes[PROBE_COUNT];
+    while(1) {
+        float distance;
+        uint8_t zones = irrigation_soil_pass(&irrigation_params, &irrigation_io, probes, &distance);
+        uint16_t soil = probes[0];
+        soil_level = soil;
+        dry_zones = zones;
+
+        // Record soil + climate (0.1 units) into history
+        int16_t sample[HIST_CHANNELS] = {
+            [HIST_SOIL] = (int16_t)soil,
+            [HIST_TEMP] = (int16_t)(temperature * 10),
+            [HIST_HUM]  = (int16_t)(humidity * 10),
+        };
+        uint32_t now_s = to_ms_since_boot(get_absolute_time()) / 1000;
+        xSemaphoreTake(history_lock, portMAX_DELAY);
+        history_record(&history, now_s, sample);
+        xSemaphoreGive(history_lock);
+
+        // Queue for MQTT; the publisher batches these into one frame
+        telemetry_sample_t ts = {
+            .t_s = now_s,
+            .soil = soil,
+            .temp_x10 = sample[HIST_TEMP],
+            .hum_x10 = (uint16_t)sample[HIST_HUM],
+            .dry_zones = zones,
+        };
+        telemetry_submit(&ts);
+
+        // Update the display with soil + humidity
+        display_status(probes, now_s);
+
+        // Next reading: faster near cutoffs, while moving or watering;
+        // slower while the publisher is catching up
+        uint32_t period = rate_update(&soil_rate, to_ms_since_boot(get_absolute_time()), soil, distance,
+                                      watering_zone >= 0);
+        if(telemetry_backpressure()) period *= 2;
+        // irrigation_task wakes us early when watering starts or stops
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(period));
     }
 }
 
 // --- Irrigation task ---
 void irrigation_task(void *params) {
     while(1) {
-        if(dry_zones == 0 && !manual_start_flag) {
+        if((dry_zones == 0 && !manual_start_flag) || pump_fault()) {
+            alert_signal(SIG_INTRUSION, intrusion_detected());
             vTaskDelay(pdMS_TO_TICKS(500));
             continue;
         }
 
-        for(int zone=0; zone<3; zone++) {
+        for(int zone=0; zone<ZONE_COUNT; zone++) {
             if((dry_zones & (1<<zone)) || manual_start_flag) {
                 manual_start_flag = false; // reset manual override
                 manual_abort_flag = false; // reset abort flag
-                printf("\n=== Starting watering Zone %d ===\n", zone+1);
-
-                // Update LCD
-                lcd_clear();
-                lcd_set_cursor(0,0);
-                char msg[16];
-                snprintf(msg, sizeof(msg), "Watering Z%d", zone+1);
-                lcd_print(msg);
-
-                gpio_put(RELAY_PIN, 1);
-
-                // Servo position
-                if(dry_zones == 0x01) servo_set_angle(45);
-                else if(dry_zones == 0x03) servo_set_angle(90);
-                else servo_set_angle(135);
-
-                int seconds = WATER_SECONDS;
-                while(seconds > 0) {
-                    if(manual_abort_flag) {
-                        printf("Manual abort via CLI!\n");
-                        break;
-                    }
-                    if(intrusion_detected()) {
-                        printf("INTRUSION detected! Stopping watering.\n");
-                        gpio_put(RELAY_PIN, 0);
-                        gpio_put(LED_ALERT, 1);
-
-                        lcd_clear();
-                        lcd_set_cursor(0,0);
-                        lcd_print("INTRUSION ALERT!");
-                        vTaskDelay(pdMS_TO_TICKS(2000));
-                        gpio_put(LED_ALERT, 0);
-                        break;
-                    }
-
-                    // Console status
-                    printf("[Zone %d] Watering... %d s | Temp=%.1fC Hum=%.1f%%\n",
-                           zone+1, seconds, temperature, humidity);
-
-                    // LCD countdown
-                    lcd_set_cursor(0,1);
-                    char timer[16];
-                    snprintf(timer, sizeof(timer), "Time:%02ds", seconds);
-                    lcd_print(timer);
-
-                    vTaskDelay(pdMS_TO_TICKS(1000));
-                    seconds--;
-                }
-
-                gpio_put(RELAY_PIN, 0);
-                printf("=== Finished watering Zone %d ===\n", zone+1);
-
-                lcd_clear();
-                lcd_set_cursor(0,0);
-                lcd_print("Zone Done");
-
-                irrigation_count++;
-                if(irrigation_count >= MAX_CYCLES) {
-                    printf("!!! MAINTENANCE REQUIRED !!!\n");
-                    irrigation_count = 0;
-
-                    lcd_clear();
-                    lcd_set_cursor(0,0);
-                    lcd_print("Maintenance!");
-                }
-
-                vTaskDelay(pdMS_TO_TICKS(2000));
+                irrigation_water_zone(&irrigation_params, &irrigation_io, zone, dry_zones);
             }
         }
     }
@@ -185,12 +406,6 @@ void servo_set_angle(float angle) {
     pwm_set_chan_level(slice, channel, duty);
 }
 
-// --- Soil sensor ---
-uint16_t read_soil() {
-    adc_select_input(0);
-    return adc_read();
-}
-
 // --- Intrusion sensor ---
 bool intrusion_detected() {
     return gpio_get(PROX_PIN);
@@ -208,101 +423,433 @@ void dht_task(void *params) {
     while(1) {
         if(read_dht(&temperature, &humidity)) {
             printf("[DHT] Temp=%.1fC Hum=%.1f%%\n", temperature, humidity);
+            alert_signal(SIG_TEMP, temperature);
+            alert_signal(SIG_HUM, humidity);
         }
-        vTaskDelay(pdMS_TO_TICKS(5000));
+        uint32_t period = rate_update(&dht_rate, to_ms_since_boot(get_absolute_time()), humidity,
+                                      humidity - irrigation_params.humidity_skip, watering_zone >= 0);
+        vTaskDelay(pdMS_TO_TICKS(period));
     }
 }
 
+// --- CLI input ---
+// getchar_timeout_us() for the CLI: waits in slices of CLI_WAIT_SLICE_MS and
+// feeds a trial image's watchdog (BOOT_WATCHDOG_MS) around each one, so a
+// handler blocked on the console does not reset the board
+#define CLI_WAIT_SLICE_MS 1000
+_Static_assert(CLI_WAIT_SLICE_MS < BOOT_WATCHDOG_MS / 2, "CLI waits must stay well inside the watchdog period");
+
+static int cli_getchar(uint32_t timeout_ms) {
+    int c;
+    do {
+        fw_update_feed();
+        uint32_t slice = timeout_ms < CLI_WAIT_SLICE_MS ? timeout_ms : CLI_WAIT_SLICE_MS;
+        c = getchar_timeout_us(slice * 1000);
+        timeout_ms -= slice;
+    } while(c == PICO_ERROR_TIMEOUT && timeout_ms > 0);
+    return c;
+}
+
 // --- CLI task ---
 void cli_task(void *params) {
     char buf[32];
     while(1) {
-        printf("\nEnter command (start/stop/status): ");
+        printf("\nEnter command (start/stop/status/history/telemetry/memmap/alerts/pump/firmware/update): ");
         fflush(stdout);
 
         int idx = 0;
         int c;
-        while((c = getchar_timeout_us(1000000)) != PICO_ERROR_TIMEOUT) {
+        while((c = cli_getchar(1000)) != PICO_ERROR_TIMEOUT) {
             if(c == '\r' || c == '\n') break;
             if(idx < sizeof(buf)-1) buf[idx++] = (char)c;
         }
         buf[idx] = '\0';
+        // A trial image confirms once both sensor loops have produced samples
+        fw_update_poll(soil_rate.samples > 0 && dht_rate.samples > 0);
 
-        if(strcmp(buf, "start") == 0) {
+        switch(cli_parse(buf)) {
+        case CLI_START:
             manual_start_flag = true;
             printf("Manual start requested!\n");
-        } else if(strcmp(buf, "stop") == 0) {
+            break;
+        case CLI_STOP:
             manual_abort_flag = true;
             printf("Manual stop requested!\n");
-        } else if(strcmp(buf, "status") == 0) {
+            break;
+        case CLI_STATUS: {
             printf("\n--- System Status ---\n");
             printf("Dry zones: %02X\n", dry_zones);
             printf("Temperature: %.1fC\n", temperature);
             printf("Humidity: %.1f%%\n", humidity);
             printf("Irrigation count: %d\n", irrigation_count);
+            uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+            printf("Soil sampling: every %lu ms, %.0f samples/h\n",
+                   (unsigned long)soil_rate.period_ms, rate_samples_per_hour(&soil_rate, now_ms));
+            printf("DHT sampling: every %lu ms, %.0f samples/h\n",
+                   (unsigned long)dht_rate.period_ms, rate_samples_per_hour(&dht_rate, now_ms));
             printf("--------------------\n");
+            break;
+        }
+        case CLI_HISTORY:
+            print_history();
+            break;
+        case CLI_TELEMETRY:
+            print_telemetry();
+            break;
+        case CLI_MEMMAP:
+            print_memmap();
+            break;
+        case CLI_ALERTS:
+            print_alerts();
+            break;
+        case CLI_ALERTS_LOAD:
+            upload_alerts();
+            break;
+        case CLI_PUMP:
+            print_pump();
+            break;
+        case CLI_PUMP_RESET:
+#if PUMP_MOTOR_DRIVE
+            pump_drive_clear();
+            printf("Pump fault cleared\n");
+#else
+            print_pump();
+#endif
+            break;
+        case CLI_FIRMWARE:
+            fw_update_status();
+            break;
+        case CLI_UPDATE:
+            fw_update_receive();
+            break;
         }
         vTaskDelay(pdMS_TO_TICKS(200));
     }
 }
 
+// --- History report: min/max/avg/trend over 10 min, 1 h and 24 h ---
+void print_history(void) {
+    static const uint32_t windows[] = {600, 3600, 86400};
+    static const char *window_names[] = {"10m", "1h", "24h"};
+    static const char *channel_names[HIST_CHANNELS] = {"Soil", "Temp", "Hum"};
+    static const float channel_scale[HIST_CHANNELS] = {1.0f, 0.1f, 0.1f};
+    uint32_t now = to_ms_since_boot(get_absolute_time()) / 1000;
+
+    printf("\n--- History (%u bytes) ---\n", (unsigned)sizeof(history));
+    printf("Win  Sensor      min      max      avg   trend/h\n");
+    for(int w=0; w<3; w++) {
+        for(int ch=0; ch<HIST_CHANNELS; ch++) {
+            hist_stats_t st;
+            xSemaphoreTake(history_lock, portMAX_DELAY);
+            bool ok = history_query(&history, ch, now, windows[w], &st);
+            xSemaphoreGive(history_lock);
+            if(!ok) continue;
+
+            float k = channel_scale[ch];
+            printf("%-4s %-6s %8.1f %8.1f %8.1f %+9.2f\n", window_names[w], channel_names[ch],
+                   st.min * k, st.max * k, st.avg * k, st.slope_per_hour * k);
+        }
+    }
+    printf("--------------------\n");
+}
+
+// --- Telemetry report: publish rate, spool depth and RAM ---
+void print_telemetry(void) {
+    telemetry_stats_t st;
+    telemetry_get_stats(&st);
+    uint32_t up_s = to_ms_since_boot(get_absolute_time()) / 1000;
+    if(up_s == 0) up_s = 1;
+
+    printf("\n--- Telemetry ---\n");
+    printf("Broker: %s (%s)\n", MQTT_BROKER_IP, st.connected ? "connected" : "offline");
+    printf("Samples: %lu queued, %lu dropped\n", (unsigned long)st.samples_in, (unsigned long)st.samples_dropped);
+    printf("Frames: %lu published (%.3f msg/s, %lu bytes)\n", (unsigned long)st.batches_published,
+           (float)st.batches_published / up_s, (unsigned long)st.bytes_published);
+    printf("Spool: %lu pending, %lu spooled, %lu replayed, %lu lost\n", (unsigned long)st.spool_pending,
+           (unsigned long)st.batches_spooled, (unsigned long)st.batches_replayed, (unsigned long)st.batches_lost);
+    printf("RAM: %lu bytes\n", (unsigned long)telemetry_ram_bytes());
+    printf("--------------------\n");
+}
+
+// --- Memory map: static buffers, task stacks and measured headroom ---
+void print_memmap(void) {
+    static const char *names[TASK_COUNT] = {
+#define TASK_NAME(id, fn, name, words, prio) name,
+        APP_TASKS(TASK_NAME)
+    };
+    static const uint32_t stack_words[TASK_COUNT] = {
+#define TASK_WORDS(id, fn, name, words, prio) words,
+        APP_TASKS(TASK_WORDS)
+    };
+
+    printf("\n--- Memory map ---\n");
+    printf("Task            stack  min free  used\n");
+    for(int i=0; i<TASK_COUNT; i++) {
+        uint32_t bytes = stack_words[i] * sizeof(StackType_t);
+        TaskHandle_t h = task_handles[i];
+        if (h == NULL) {
+            printf("%-14s %6lu    exited\n", names[i], (unsigned long)bytes);
+            continue;
+        }
+        uint32_t free_bytes = uxTaskGetStackHighWaterMark(h) * sizeof(StackType_t);
+        printf("%-14s %6lu %9lu  %3lu%%\n", names[i], (unsigned long)bytes, (unsigned long)free_bytes,
+               (unsigned long)((bytes - free_bytes) * 100 / bytes));
+    }
+    printf("Buffer                bytes\n");
+    printf("%-18s %9lu\n", "task stacks", (unsigned long)APP_STACK_BYTES);
+    printf("%-18s %9lu\n", "history", (unsigned long)sizeof(history));
+    printf("%-18s %9lu\n", "telemetry", (unsigned long)telemetry_ram_bytes());
+    printf("%-18s %9lu\n", "http", (unsigned long)http_ram_bytes());
+    printf("%-18s %9lu\n", "alerts", (unsigned long)sizeof(alerts));
+#if DISPLAY_OLED
+    printf("%-18s %9lu\n", "display", (unsigned long)(oled_ram_bytes() + sizeof(screen)));
+#endif
+#if PUMP_MOTOR_DRIVE
+    printf("%-18s %9lu\n", "pump drive", (unsigned long)pump_drive_ram_bytes());
+#endif
+#if configSUPPORT_DYNAMIC_ALLOCATION
+    printf("%-18s %9lu (min %lu)\n", "heap free", (unsigned long)xPortGetFreeHeapSize(),
+           (unsigned long)xPortGetMinimumEverFreeHeapSize());
+#else
+    printf("%-18s %9s\n", "heap", "disabled");
+#endif
+    printf("--------------------\n");
+}
+
+// --- Alerts: feed one sample, time the rules it touches ---
+void alert_signal(uint8_t sig, float value) {
+    int32_t v = (int32_t)(value * 10 + (value < 0 ? -0.5f : 0.5f));
+    xSemaphoreTake(alert_lock, portMAX_DELAY);
+    uint32_t t0 = time_us_32();
+    uint32_t n = alert_sample(&alerts, sig, v, to_ms_since_boot(get_absolute_time()), alert_action);
+    uint32_t us = time_us_32() - t0;
+    alert_samples++;
+    alert_evaluated += n;
+    alert_us_total += us;
+    if(us > alert_us_max) alert_us_max = us;
+    xSemaphoreGive(alert_lock);
+}
+
+// Called by the rule engine (alert_lock held) when a rule raises or clears
+void alert_action(const char *name, uint8_t actions, bool raised) {
+    if(actions & ALERT_LOG) printf(raised ? "!!! ALERT: %s !!!\n" : "Alert cleared: %s\n", name);
+    if(actions & ALERT_LED) {
+        if(raised) alert_led_holders++;
+        else if(alert_led_holders) alert_led_holders--;
+        gpio_put(LED_ALERT, alert_led_holders > 0);
+    }
+    if(!raised) return;
+    if(actions & ALERT_LCD) display_message(name);
+    if(actions & ALERT_RESET_CYCLES) irrigation_count = 0;
+}
+
+// Flash copy if it checks out, built-in set otherwise (call with alert_lock held once tasks run)
+void load_alert_rules(void) {
+    const uint8_t *blob = alert_flash_blob();
+    if(blob && alert_load(&alerts, blob, ((const alert_blob_hdr_t *)blob)->total_len)) {
+        alert_source = "flash";
+    } else {
+        alert_load(&alerts, alert_rules_default, sizeof(alert_rules_default));
+        alert_source = "built-in";
+    }
+    alert_led_holders = 0;
+    gpio_put(LED_ALERT, 0);
+}
+
+// --- Alerts report: rules, state and evaluation cost ---
+void print_alerts(void) {
+    xSemaphoreTake(alert_lock, portMAX_DELAY);
+    uint16_t n = alert_rule_count(&alerts);
+    printf("\n--- Alerts (%s, %u rules) ---\n", alert_source, n);
+    printf("Rule             fires  state\n");
+    for(uint16_t i=0; i<n; i++) {
+        printf("%-16s %5u  %s\n", alert_rule_name(&alerts, i), alerts.state[i].fires,
+               alert_rule_raised(&alerts, i) ? "RAISED" : "-");
+    }
+    printf("Samples: %lu, %.1f rules/sample, avg %lu us, max %lu us\n", (unsigned long)alert_samples,
+           alert_samples ? (float)alert_evaluated / alert_samples : 0.0f,
+           (unsigned long)(alert_samples ? alert_us_total / alert_samples : 0), (unsigned long)alert_us_max);
+    xSemaphoreGive(alert_lock);
+    printf("--------------------\n");
+}
+
+// --- Pump report: drive settings, last run and its current waveform ---
+void print_pump(void) {
+#if PUMP_MOTOR_DRIVE
+    pump_drive_report();
+#else
+    printf("\nPump: relay drive (build with -DPUMP_MOTOR_DRIVE=1 for soft start and current cutoff)\n");
+#endif
+}
+
+static int hex_digit(int c) {
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// --- "alerts load": hex from tools/alert_compiler -x, written page by page
+// to the rules flash region. An empty upload reverts to the built-in set. ---
+void upload_alerts(void) {
+    static uint8_t page[FLASH_PAGE_SIZE];
+    printf("Paste rule hex (alert_compiler -x), end with an empty line:\n");
+
+    // No rule may read the blob while its flash is rewritten
+    xSemaphoreTake(alert_lock, portMAX_DELAY);
+    alert_load(&alerts, NULL, 0);
+    alert_source = "none";
+    gpio_put(LED_ALERT, 0);
+    xSemaphoreGive(alert_lock);
+
+    uint32_t len = 0;
+    int hi = -1, c, prev = 0;
+    bool blank = true;
+    while((c = cli_getchar(10000)) != PICO_ERROR_TIMEOUT) {
+        if(c == '\r' || c == '\n') {
+            if(c == '\n' && prev == '\r') continue;
+            prev = c;
+            if(blank) break;
+            blank = true;
+            continue;
+        }
+        prev = c;
+        int v = hex_digit(c);
+        if(v < 0) continue;
+        blank = false;
+        if(hi < 0) {
+            hi = v;
+            continue;
+        }
+        if(len == ALERT_BLOB_MAX) {
+            printf("Too large, ignoring the rest\n");
+            break;
+        }
+        page[len % FLASH_PAGE_SIZE] = (uint8_t)(hi << 4 | v);
+        hi = -1;
+        if(++len % FLASH_PAGE_SIZE == 0) alert_flash_write(len - FLASH_PAGE_SIZE, page);
+    }
+    if(len % FLASH_PAGE_SIZE) {
+        memset(page + len % FLASH_PAGE_SIZE, 0xFF, FLASH_PAGE_SIZE - len % FLASH_PAGE_SIZE);
+        alert_flash_write(len - len % FLASH_PAGE_SIZE, page);
+    }
+    if(len == 0) alert_flash_erase();
+
+    xSemaphoreTake(alert_lock, portMAX_DELAY);
+    load_alert_rules();
+    printf("%lu bytes received, %u rules active (%s)\n", (unsigned long)len,
+           alert_rule_count(&alerts), alert_source);
+    xSemaphoreGive(alert_lock);
+}
+
+// --- Task / kernel object creation ---
+#if configSUPPORT_STATIC_ALLOCATION
+#define TASK_STORAGE(id, fn, name, words, prio) \
+    static StackType_t id##_stack[words]; \
+    static StaticTask_t id##_tcb;
+APP_TASKS(TASK_STORAGE)
+static StaticSemaphore_t history_lock_buf;
+static StaticSemaphore_t alert_lock_buf;
+static StaticSemaphore_t adc_lock_buf;
+static StaticSemaphore_t display_lock_buf;
+
+#define TASK_CREATE(id, fn, name, words, prio) \
+    task_handles[TASK_##id] = xTaskCreateStatic(fn, name, words, &task_handles[TASK_##id], prio, \
+                                                id##_stack, &id##_tcb);
+#else
+#define TASK_CREATE(id, fn, name, words, prio) \
+    xTaskCreate(fn, name, words, &task_handles[TASK_##id], prio, &task_handles[TASK_##id]);
+#endif
+
+static void create_tasks(void) {
+#if configSUPPORT_STATIC_ALLOCATION
+    history_lock = xSemaphoreCreateMutexStatic(&history_lock_buf);
+    alert_lock = xSemaphoreCreateMutexStatic(&alert_lock_buf);
+    adc_lock = xSemaphoreCreateMutexStatic(&adc_lock_buf);
+    display_lock = xSemaphoreCreateMutexStatic(&display_lock_buf);
+#else
+    history_lock = xSemaphoreCreateMutex();
+    alert_lock = xSemaphoreCreateMutex();
+    adc_lock = xSemaphoreCreateMutex();
+    display_lock = xSemaphoreCreateMutex();
+#endif
+    APP_TASKS(TASK_CREATE)
+}
+
+#if configSUPPORT_STATIC_ALLOCATION
+// Kernel-owned tasks need their memory handed over too
+void vApplicationGetIdleTaskMemory(StaticTask_t **tcb, StackType_t **stack, uint32_t *words) {
+    static StaticTask_t idle_tcb;
+    static StackType_t idle_stack[configMINIMAL_STACK_SIZE];
+    *tcb = &idle_tcb;
+    *stack = idle_stack;
+    *words = configMINIMAL_STACK_SIZE;
+}
+
+#if configNUMBER_OF_CORES > 1
+void vApplicationGetPassiveIdleTaskMemory(StaticTask_t **tcb, StackType_t **stack, uint32_t *words,
+                                          BaseType_t core) {
+    static StaticTask_t idle_tcb[configNUMBER_OF_CORES - 1];
+    static StackType_t idle_stack[configNUMBER_OF_CORES - 1][configMINIMAL_STACK_SIZE];
+    *tcb = &idle_tcb[core];
+    *stack = idle_stack[core];
+    *words = configMINIMAL_STACK_SIZE;
+}
+#endif
+
+#if configUSE_TIMERS
+void vApplicationGetTimerTaskMemory(StaticTask_t **tcb, StackType_t **stack, uint32_t *words) {
+    static StaticTask_t timer_tcb;
+    static StackType_t timer_stack[configTIMER_TASK_STACK_DEPTH];
+    *tcb = &timer_tcb;
+    *stack = timer_stack;
+    *words = configTIMER_TASK_STACK_DEPTH;
+}
+#endif
+#endif
+
 // --- Main ---
 int main() {
     stdio_init_all();
     printf("Smart Irrigation System with LCD + CLI\n");
+    fw_update_boot();
 
-    gpio_init(RELAY_PIN); gpio_set_dir(RELAY_PIN, GPIO_OUT);
+    topology_init_io();
     gpio_init(LED_ALERT); gpio_set_dir(LED_ALERT, GPIO_OUT);
     gpio_init(PROX_PIN); gpio_set_dir(PROX_PIN, GPIO_IN);
     gpio_init(DHT_PIN);
-    adc_init();
-    adc_gpio_init(SOIL_PIN);
-
-    // Init I2C for LCD
+#if PUMP_MOTOR_DRIVE
+    pump_drive_init(&pump_cfg, PROBE_ADC_CHANNEL(PUMP_SENSE_PIN), PROBE_ADC_CHANNEL(PROBE_GPIO[0]));
+#endif
+
+    // Init I2C for the display
+#if DISPLAY_OLED
+    i2c_init(I2C_PORT, OLED_I2C_HZ);
+#else
     i2c_init(I2C_PORT, 100 * 1000);
+#endif
     gpio_set_function(I2C_SDA, GPIO_FUNC_I2C);
     gpio_set_function(I2C_SCL, GPIO_FUNC_I2C);
     gpio_pull_up(I2C_SDA);
     gpio_pull_up(I2C_SCL);
+#if DISPLAY_OLED
+    uint8_t dry_pct[ZONE_COUNT];
+    for(int z=0; z<ZONE_COUNT; z++) dry_pct[z] = site_moisture_pct(irrigation_params.cutoff[z]);
+    oled_init();
+    screen_init(&screen, ZONE_COUNT, dry_pct);
+#else
     lcd_init();
+#endif
 
-    // --- FreeRTOS tasks ---
-    xTaskCreate(soil_task, "SoilTask", 256, NULL, 2, NULL);
-    xTaskCreate(irrigation_task, "IrrigationTask", 512, NULL, 2, NULL);
-    xTaskCreate(dht_task, "DHTTask", 256, NULL, 1, NULL);
-    xTaskCreate(cli_task, "CLITask", 512, NULL, 3, NULL);
+    history_init(&history);
+    rate_init(&soil_rate, &soil_rate_cfg, 0);
+    rate_init(&dht_rate, &dht_rate_cfg, 0);
+    load_alert_rules();
+    telemetry_init();
+    create_tasks();
 
     vTaskStartScheduler();
     while(1) {}
 }
 
-/////////////////////////////////////////////////////
-// --- LCD driver functions (I2C 16x2, PCF8574) ---
-/////////////////////////////////////////////////////
-void lcd_send_cmd(uint8_t cmd) {
-    uint8_t buf[2] = {0x80, cmd};
-    i2c_write_blocking(I2C_PORT, LCD_ADDR, buf, 2, false);
-}
-void lcd_send_data(uint8_t data) {
-    uint8_t buf[2] = {0x40, data};
-    i2c_write_blocking(I2C_PORT, LCD_ADDR, buf, 2, false);
-}
-void lcd_clear() {
-    lcd_send_cmd(0x01);
-    sleep_ms(2);
-}
-void lcd_init() {
-    sleep_ms(50);
-    lcd_send_cmd(0x38);
-    lcd_send_cmd(0x0C);
-    lcd_send_cmd(0x01);
-    sleep_ms(2);
-}
-void lcd_set_cursor(int col, int row) {
-    int row_offsets[] = {0x00, 0x40};
-    lcd_send_cmd(0x80 | (col + row_offsets[row]));
-}
-void lcd_print(const char *str) {
-    while(*str) lcd_send_data(*str++);
-}
 // ------------------------------------------------------- //
\ No newline at end of file